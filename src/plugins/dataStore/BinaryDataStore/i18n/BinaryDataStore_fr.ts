@@ -0,0 +1,30 @@
+<?xml version="1.0" encoding="utf-8"?>
+<!DOCTYPE TS>
+<TS version="2.1" language="fr_FR" sourcelanguage="en_GB">
+<context>
+    <name>OpenCOR::BinaryDataStore::BinaryDataStoreExporterWorker</name>
+    <message>
+        <source>The data could not be written.</source>
+        <translation>Les données n&apos;ont pas pu être écrites.</translation>
+    </message>
+    <message>
+        <source>The binary file could not be created.</source>
+        <translation>Le fichier binaire n&apos;a pas pu être créé.</translation>
+    </message>
+</context>
+<context>
+    <name>OpenCOR::BinaryDataStore::BinaryDataStorePlugin</name>
+    <message>
+        <source>Binary Data File</source>
+        <translation>Fichier de Données Binaire</translation>
+    </message>
+    <message>
+        <source>Export To Binary</source>
+        <translation>Exporter Vers Binaire</translation>
+    </message>
+    <message>
+        <source>Data</source>
+        <translation>Données</translation>
+    </message>
+</context>
+</TS>
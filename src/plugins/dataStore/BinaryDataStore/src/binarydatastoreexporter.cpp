@@ -0,0 +1,196 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Binary data store exporter
+//==============================================================================
+
+#include "binarydatastoreexporter.h"
+#include "binarydatastorefile.h"
+#include "corecliutils.h"
+#include "solverinterface.h"
+
+//==============================================================================
+
+#include <QDataStream>
+#include <QDir>
+#include <QVector>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+BinaryDataStoreExporterWorker::BinaryDataStoreExporterWorker(DataStore::DataStoreExportData *pDataStoreData) :
+    DataStore::DataStoreExporterWorker(pDataStoreData)
+{
+}
+
+//==============================================================================
+
+void BinaryDataStoreExporterWorker::run()
+{
+    // Export our data store to a binary file (see binarydatastorefile.h for its
+    // layout), using a temporary file, as for Core::writeFile()
+
+    QFile file(Core::temporaryFileName());
+    QString errorMessage;
+
+    if (file.open(QIODevice::WriteOnly)) {
+        // Retrieve our variables, making sure that our VOI is not one of them
+        // since it always gets exported, and as our first column
+
+        DataStore::DataStore *dataStore = mDataStoreData->dataStore();
+        DataStore::DataStoreVariable *voi = dataStore->voi();
+        DataStore::DataStoreVariables variables = mDataStoreData->variables();
+
+        variables.removeOne(voi);
+        variables.prepend(voi);
+
+        // Output our header, run sizes and metadata
+
+        int nbOfRuns = dataStore->runsCount();
+        int nbOfColumns = variables.count();
+        QByteArray metadata;
+        QDataStream metadataStream(&metadata, QIODevice::WriteOnly);
+
+        metadataStream.setVersion(QDataStream::Qt_5_12);
+
+        for (auto variable : variables) {
+            metadataStream << variable->uri() << variable->name() << variable->unit();
+        }
+
+        quint64 header[HeaderFieldsCount];
+
+        header[MagicNumberField] = BinaryDataStoreMagicNumber;
+        header[VersionField] = BinaryDataStoreVersion;
+        header[ColumnsCountField] = quint64(nbOfColumns);
+        header[RunsCountField] = quint64(nbOfRuns);
+        header[MetadataSizeField] = quint64(metadata.size());
+
+        QList<quint64> runSizes;
+
+        for (int i = 0; i < nbOfRuns; ++i) {
+            runSizes << dataStore->size(i);
+        }
+
+        metadata.append(QByteArray(int(BinaryDataStoreFile::paddedSize(metadata.size())-metadata.size()), '\0'));
+
+        bool res = file.write(reinterpret_cast<const char *>(header), qint64(sizeof(header))) != -1;
+
+        for (int i = 0; res && (i < nbOfRuns); ++i) {
+            res = file.write(reinterpret_cast<const char *>(&runSizes[i]), qint64(sizeof(quint64))) != -1;
+        }
+
+        res = res && (file.write(metadata) != -1);
+
+        // Output the data of each of our runs, one column at a time, padding
+        // with NaNs the values that a variable may not have (e.g. if it wasn't
+        // recorded for part of a run)
+        // Note: we pad using a fixed number of NaNs at a time, so that we never
+        //       need to allocate as many NaNs as there are values in a run...
+
+        static const int NaNsCount = 65536;
+
+        QVector<double> nans(NaNsCount, qQNaN());
+        double oneOverNbOfSteps = 1.0/qMax(nbOfRuns*nbOfColumns, 1);
+        int stepNb = 0;
+
+        for (int i = 0; res && (i < nbOfRuns); ++i) {
+            quint64 runSize = runSizes[i];
+
+            for (auto variable : variables) {
+                double *values = variable->values(i);
+                quint64 size = (values != nullptr)?
+                                   qMin(variable->size(i), runSize):
+                                   0;
+
+                if (size != 0) {
+                    res = file.write(reinterpret_cast<const char *>(values), qint64(size*Solver::SizeOfDouble)) != -1;
+                }
+
+                for (quint64 nbOfNans = runSize-size; res && (nbOfNans != 0);) {
+                    quint64 count = qMin(nbOfNans, quint64(NaNsCount));
+
+                    res = file.write(reinterpret_cast<const char *>(nans.constData()), qint64(count*Solver::SizeOfDouble)) != -1;
+
+                    nbOfNans -= count;
+                }
+
+                if (!res) {
+                    break;
+                }
+
+                emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
+            }
+        }
+
+        // Close our temporary file and rename it to our final file, if we were
+        // able to output all of our data
+
+        file.close();
+
+        if (res) {
+            QDir dir(QFileInfo(mDataStoreData->fileName()).path());
+
+            res = dir.exists() || dir.mkpath(dir.dirName());
+
+            if (res) {
+                if (QFile::exists(mDataStoreData->fileName())) {
+                    QFile::remove(mDataStoreData->fileName());
+                }
+
+                res = file.rename(mDataStoreData->fileName());
+            }
+        }
+
+        if (!res) {
+            file.remove();
+
+            errorMessage = tr("The data could not be written.");
+        }
+    } else {
+        errorMessage = tr("The binary file could not be created.");
+    }
+
+    // Let people know that our export is done
+
+    emit done(mDataStoreData, errorMessage);
+}
+
+//==============================================================================
+
+DataStore::DataStoreExporterWorker * BinaryDataStoreExporter::workerInstance(DataStore::DataStoreExportData *pDataStoreData)
+{
+    // Return an instance of our worker
+
+    return new BinaryDataStoreExporterWorker(pDataStoreData);
+}
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,203 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Binary data store file
+//==============================================================================
+
+#include "binarydatastorefile.h"
+#include "solverinterface.h"
+
+//==============================================================================
+
+#include <QDataStream>
+#include <QFile>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+BinaryDataStoreFile::BinaryDataStoreFile(const QString &pFileName)
+{
+    // Read and check the header, run sizes and metadata of the given file, and
+    // make sure that the size of the file is consistent with them
+
+    QFile file(pFileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    quint64 header[HeaderFieldsCount];
+    qint64 headerSize = qint64(sizeof(header));
+    qint64 fileSize = file.size();
+
+    if (   (file.read(reinterpret_cast<char *>(header), headerSize) != headerSize)
+        || (header[MagicNumberField] != BinaryDataStoreMagicNumber)
+        || (header[VersionField] != BinaryDataStoreVersion)
+        || (header[ColumnsCountField] == 0)
+        || (header[ColumnsCountField] > quint64(fileSize))
+        || (header[RunsCountField] > quint64(fileSize))
+        || (header[MetadataSizeField] > quint64(fileSize))) {
+        return;
+    }
+
+    quint64 dataSize = 0;
+
+    for (quint64 i = 0; i < header[RunsCountField]; ++i) {
+        quint64 runSize;
+
+        if (   (file.read(reinterpret_cast<char *>(&runSize), qint64(sizeof(runSize))) != qint64(sizeof(runSize)))
+            || (runSize > quint64(fileSize)/(header[ColumnsCountField]*Solver::SizeOfDouble))) {
+            return;
+        }
+
+        mRunSizes << runSize;
+
+        dataSize += header[ColumnsCountField]*runSize*Solver::SizeOfDouble;
+
+        if (dataSize > quint64(fileSize)) {
+            return;
+        }
+    }
+
+    QByteArray metadata = file.read(qint64(header[MetadataSizeField]));
+
+    file.close();
+
+    if (metadata.size() != int(header[MetadataSizeField])) {
+        return;
+    }
+
+    QDataStream metadataStream(metadata);
+
+    metadataStream.setVersion(QDataStream::Qt_5_12);
+
+    for (quint64 i = 0; i < header[ColumnsCountField]; ++i) {
+        QString uri;
+        QString name;
+        QString unit;
+
+        metadataStream >> uri >> name >> unit;
+
+        if (metadataStream.status() != QDataStream::Ok) {
+            return;
+        }
+
+        mUris << uri;
+        mNames << name;
+        mUnits << unit;
+    }
+
+    mColumnsCount = int(header[ColumnsCountField]);
+    mDataOffset = headerSize+qint64(mRunSizes.count())*qint64(sizeof(quint64))
+                 +paddedSize(qint64(header[MetadataSizeField]));
+    mValid = quint64(fileSize) == quint64(mDataOffset)+dataSize;
+}
+
+//==============================================================================
+
+bool BinaryDataStoreFile::isValid() const
+{
+    // Return whether we are valid
+
+    return mValid;
+}
+
+//==============================================================================
+
+int BinaryDataStoreFile::columnsCount() const
+{
+    // Return our number of columns, i.e. our VOI and variables
+
+    return mColumnsCount;
+}
+
+//==============================================================================
+
+QList<quint64> BinaryDataStoreFile::runSizes() const
+{
+    // Return the size of our runs
+
+    return mRunSizes;
+}
+
+//==============================================================================
+
+QStringList BinaryDataStoreFile::uris() const
+{
+    // Return the URI of our columns
+
+    return mUris;
+}
+
+//==============================================================================
+
+QStringList BinaryDataStoreFile::names() const
+{
+    // Return the name of our columns
+
+    return mNames;
+}
+
+//==============================================================================
+
+QStringList BinaryDataStoreFile::units() const
+{
+    // Return the unit of our columns
+
+    return mUnits;
+}
+
+//==============================================================================
+
+qint64 BinaryDataStoreFile::runOffset(int pRun) const
+{
+    // Return the offset of the data of the given run
+
+    qint64 res = mDataOffset;
+
+    for (int i = 0; i < pRun; ++i) {
+        res += qint64(quint64(mColumnsCount)*mRunSizes[i]*Solver::SizeOfDouble);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+qint64 BinaryDataStoreFile::paddedSize(qint64 pSize)
+{
+    // Return the given size padded to a multiple of eight bytes
+
+    return (pSize+7) & ~qint64(7);
+}
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,103 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Binary data store file
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+// Layout of a binary data store file, all of which is in native (i.e. little
+// endian) byte order:
+//  - a header (see the fields below);
+//  - the size of each run;
+//  - some metadata, i.e. the URI, name and unit of each column (using a
+//    QDataStream), padded to a multiple of eight bytes; and
+//  - the data of each run, i.e. a contiguous column of doubles for our VOI and
+//    then for each of our variables.
+// Note: everything is aligned on eight bytes, so that the columns of a run can
+//       be mapped in memory and used as is...
+
+static const quint64 BinaryDataStoreMagicNumber = 0x5441444e4942434f; // "OCBINDAT"
+static const quint64 BinaryDataStoreVersion = 1;
+
+enum {
+    MagicNumberField,
+    VersionField,
+    ColumnsCountField,
+    RunsCountField,
+    MetadataSizeField,
+    HeaderFieldsCount
+};
+
+//==============================================================================
+
+class BinaryDataStoreFile
+{
+public:
+    explicit BinaryDataStoreFile(const QString &pFileName);
+
+    bool isValid() const;
+
+    int columnsCount() const;
+    QList<quint64> runSizes() const;
+
+    QStringList uris() const;
+    QStringList names() const;
+    QStringList units() const;
+
+    qint64 runOffset(int pRun) const;
+
+    static qint64 paddedSize(qint64 pSize);
+
+private:
+    bool mValid = false;
+
+    int mColumnsCount = 0;
+    QList<quint64> mRunSizes;
+
+    QStringList mUris;
+    QStringList mNames;
+    QStringList mUnits;
+
+    qint64 mDataOffset = 0;
+};
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,71 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Binary data store importer
+//==============================================================================
+
+#include "binarydatastoreimporter.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+BinaryDataStoreImporterWorker::BinaryDataStoreImporterWorker(DataStore::DataStoreImportData *pImportData) :
+    DataStore::DataStoreImporterWorker(pImportData)
+{
+}
+
+//==============================================================================
+
+void BinaryDataStoreImporterWorker::run()
+{
+    // Import our binary file in our data store
+    // Note: our import data store uses the columns of our binary file, which
+    //       are mapped in memory (see BinaryDataStorePlugin::getImportData()),
+    //       so there is nothing to import as such...
+
+    emit progress(mImportData, mImportData->progress(mImportData->nbOfDataPoints()));
+
+    // Let people know that our import is done
+
+    emit done(mImportData, QString());
+}
+
+//==============================================================================
+
+DataStore::DataStoreImporterWorker * BinaryDataStoreImporter::workerInstance(DataStore::DataStoreImportData *pImportData)
+{
+    // Return an instance of our worker
+
+    return new BinaryDataStoreImporterWorker(pImportData);
+}
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,264 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Binary data store plugin
+//==============================================================================
+
+#include "binarydatastoreexporter.h"
+#include "binarydatastorefile.h"
+#include "binarydatastoreimporter.h"
+#include "binarydatastoreplugin.h"
+#include "binaryinterface.h"
+#include "corecliutils.h"
+#include "coreguiutils.h"
+#include "datastoredialog.h"
+
+//==============================================================================
+
+#include <QMainWindow>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+PLUGININFO_FUNC BinaryDataStorePluginInfo()
+{
+    Descriptions descriptions;
+
+    descriptions.insert("en", QString::fromUtf8("a binary specific data store plugin."));
+    descriptions.insert("fr", QString::fromUtf8("une extension de magasin de données spécifique au binaire."));
+
+    return new PluginInfo(PluginInfo::Category::DataStore, true, false,
+                          { "DataStore" },
+                          descriptions);
+}
+
+//==============================================================================
+
+BinaryDataStorePlugin::BinaryDataStorePlugin()
+{
+    // Keep track of our file type interface
+
+    static BinaryInterfaceData data(qobject_cast<FileTypeInterface *>(this));
+
+    Core::globalInstance(BinaryInterfaceDataSignature, &data);
+}
+
+//==============================================================================
+// Data store interface
+//==============================================================================
+
+QString BinaryDataStorePlugin::dataStoreName() const
+{
+    // Return the name of the data store
+
+    return "Binary";
+}
+
+//==============================================================================
+
+DataStore::DataStoreImportData * BinaryDataStorePlugin::getImportData(const QString &pFileName,
+                                                                      DataStore::DataStore *pImportDataStore,
+                                                                      DataStore::DataStore *pResultsDataStore,
+                                                                      const QList<quint64> &pRunSizes) const
+{
+    // Make sure that our binary file is valid and has at least one run
+
+    BinaryDataStoreFile binaryFile(pFileName);
+
+    if (!binaryFile.isValid() || binaryFile.runSizes().isEmpty()) {
+        return nullptr;
+    }
+
+    // Map the columns of the last run of our binary file in memory, so that
+    // our import data store can use them as is
+    // Note: our import data store can only hold one run, hence we import the
+    //       last run of our binary file, i.e. its current run...
+
+    int run = binaryFile.runSizes().count()-1;
+    quint64 nbOfDataPoints = binaryFile.runSizes().last();
+    DataStore::DataStoreMappedFile *file = nullptr;
+
+    try {
+        file = new DataStore::DataStoreMappedFile(pFileName,
+                                                  binaryFile.runOffset(run),
+                                                  binaryFile.columnsCount(),
+                                                  nbOfDataPoints);
+    } catch (...) {
+        return nullptr;
+    }
+
+    auto res = new DataStore::DataStoreImportData(pFileName, pImportDataStore,
+                                                  pResultsDataStore,
+                                                  binaryFile.columnsCount()-1,
+                                                  nbOfDataPoints, pRunSizes,
+                                                  file);
+
+    file->release();
+
+    // Give the VOI and variables of our import data store the URI, name and
+    // unit of the column they use, so that they can be matched by URI with
+    // the data that was exported
+    // Note: our import data store uses our columns in the order in which its
+    //       variables were added (see DataStore::addRun()), i.e. in the same
+    //       order as our import variables...
+
+    if (res->valid()) {
+        QStringList uris = binaryFile.uris();
+        QStringList names = binaryFile.names();
+        QStringList units = binaryFile.units();
+        DataStore::DataStoreVariables variables = DataStore::DataStoreVariables() << pImportDataStore->voi() << res->importVariables();
+
+        for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
+            variables[i]->setUri(uris[i]);
+            variables[i]->setName(names[i]);
+            variables[i]->setUnit(units[i]);
+        }
+    }
+
+    // Return some information about the data we want to import
+
+    return res;
+}
+
+//==============================================================================
+
+DataStore::DataStoreExportData * BinaryDataStorePlugin::getExportData(const QString &pFileName,
+                                                                      DataStore::DataStore *pDataStore,
+                                                                      const QMap<int, QIcon> &pIcons) const
+{
+    // Ask which data should be exported
+
+    DataStore::DataStoreDialog dataStoreDialog("BinaryDataStore", pDataStore, true,
+                                               pIcons, Core::mainWindow());
+
+    if (dataStoreDialog.exec() != 0) {
+        // Now that we know which data to export, we can ask for the name of the
+        // binary file where it is to be exported
+
+        QStringList binaryFilters = Core::filters(FileTypeInterfaces() << fileTypeInterface());
+        QString firstBinaryFilter = binaryFilters.first();
+        QString fileName = Core::getSaveFileName(tr("Export To Binary"),
+                                                 Core::newFileName(pFileName, tr("Data"), false, BinaryFileExtension),
+                                                 binaryFilters, &firstBinaryFilter);
+
+        if (!fileName.isEmpty()) {
+            return new DataStore::DataStoreExportData(fileName, pDataStore, dataStoreDialog.selectedData());
+        }
+    }
+
+    return nullptr;
+}
+
+//==============================================================================
+
+DataStore::DataStoreImporter * BinaryDataStorePlugin::dataStoreImporterInstance() const
+{
+    // Return the 'global' instance of our binary data store importer
+
+    static BinaryDataStoreImporter instance;
+
+    return static_cast<BinaryDataStoreImporter *>(Core::globalInstance("OpenCOR::BinaryDataStore::BinaryDataStoreImporter::instance()",
+                                                                       &instance));
+}
+
+//==============================================================================
+
+DataStore::DataStoreExporter * BinaryDataStorePlugin::dataStoreExporterInstance() const
+{
+    // Return the 'global' instance of our binary data store exporter
+
+    static BinaryDataStoreExporter instance;
+
+    return static_cast<BinaryDataStoreExporter *>(Core::globalInstance("OpenCOR::BinaryDataStore::BinaryDataStoreExporter::instance()",
+                                                                       &instance));
+}
+
+//==============================================================================
+// File interface
+//==============================================================================
+
+bool BinaryDataStorePlugin::isFile(const QString &pFileName) const
+{
+    // Return whether the given file is of the type that we support
+
+    return BinaryDataStoreFile(pFileName).isValid();
+}
+
+//==============================================================================
+
+QString BinaryDataStorePlugin::mimeType() const
+{
+    // Return the MIME type we support
+
+    return BinaryMimeType;
+}
+
+//==============================================================================
+
+QString BinaryDataStorePlugin::fileExtension() const
+{
+    // Return the extension of the type of file we support
+
+    return BinaryFileExtension;
+}
+
+//==============================================================================
+
+QString BinaryDataStorePlugin::fileTypeDescription() const
+{
+    // Return the description of the type of file we support
+
+    return tr("Binary Data File");
+}
+
+//==============================================================================
+
+QStringList BinaryDataStorePlugin::fileTypeDefaultViews() const
+{
+    // Return the default views to use for the type of file we support
+
+    return {};
+}
+
+//==============================================================================
+// I18n interface
+//==============================================================================
+
+void BinaryDataStorePlugin::retranslateUi()
+{
+    // We don't handle this interface...
+    // Note: even though we don't handle this interface, we still want to
+    //       support it since some other aspects of our plugin are
+    //       multilingual...
+}
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,64 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Binary interface
+//==============================================================================
+
+#include "corecliutils.h"
+#include "binaryinterface.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace BinaryDataStore {
+
+//==============================================================================
+
+BinaryInterfaceData::BinaryInterfaceData(FileTypeInterface *pFileTypeInterface) :
+    mFileTypeInterface(pFileTypeInterface)
+{
+}
+
+//==============================================================================
+
+FileTypeInterface * BinaryInterfaceData::fileTypeInterface() const
+{
+    // Return our file type interface
+
+    return mFileTypeInterface;
+}
+
+//==============================================================================
+
+FileTypeInterface * fileTypeInterface()
+{
+    // Return our file type interface
+
+    return static_cast<BinaryInterfaceData *>(Core::globalInstance(BinaryInterfaceDataSignature))->fileTypeInterface();
+}
+
+//==============================================================================
+
+} // namespace BinaryDataStore
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
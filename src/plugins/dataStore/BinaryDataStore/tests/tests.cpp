@@ -0,0 +1,225 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Binary data store tests
+//==============================================================================
+
+#include "binarydatastoreexporter.h"
+#include "binarydatastorefile.h"
+#include "binarydatastoreplugin.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+static const int     NbOfVariables = 4;
+static const quint64 FirstRunSize  = 100;
+static const quint64 SecondRunSize = 100000;
+
+//==============================================================================
+
+static void populateDataStore(OpenCOR::DataStore::DataStore *pDataStore,
+                              double *pValues)
+{
+    // Populate the given data store with two runs for a VOI and some variables,
+    // the last of which is not recorded
+    // Note: our second run is bigger than the number of NaNs that our exporter
+    //       writes at a time, so that our unrecorded variable needs padding in
+    //       several goes...
+
+    OpenCOR::DataStore::DataStoreVariables variables = pDataStore->addVariables(pValues, NbOfVariables);
+
+    pDataStore->voi()->setUri("main/time");
+    pDataStore->voi()->setName("time");
+    pDataStore->voi()->setUnit("ms");
+
+    for (int i = 0; i < NbOfVariables; ++i) {
+        variables[i]->setUri(QString("main/x%1").arg(i));
+        variables[i]->setName(QString("x%1").arg(i));
+        variables[i]->setUnit("mV");
+    }
+
+    variables.last()->setRecorded(false);
+
+    for (auto runSize : { FirstRunSize, SecondRunSize }) {
+        QVERIFY(pDataStore->addRun(runSize));
+
+        for (quint64 i = 0; i < runSize; ++i) {
+            for (int j = 0; j < NbOfVariables; ++j) {
+                pValues[j] = double(runSize)+double(j+1)*double(i);
+            }
+
+            pDataStore->addValues(0.001*double(i));
+        }
+    }
+}
+
+//==============================================================================
+
+static QString exportDataStore(OpenCOR::DataStore::DataStore *pDataStore,
+                               const QString &pDirectoryName)
+{
+    // Export the given data store to a binary file in the given directory and
+    // return the name of that file
+
+    QString res = QDir(pDirectoryName).filePath("data.ocbin");
+    auto exportData = new OpenCOR::DataStore::DataStoreExportData(res, pDataStore,
+                                                                  pDataStore->voiAndVariables());
+    OpenCOR::BinaryDataStore::BinaryDataStoreExporterWorker worker(exportData);
+    QString errorMessage = "not done";
+
+    QObject::connect(&worker, &OpenCOR::DataStore::DataStoreExporterWorker::done,
+                     [&](OpenCOR::DataStore::DataStoreExportData *, const QString &pErrorMessage) {
+        errorMessage = pErrorMessage;
+    });
+
+    worker.run();
+
+    delete exportData;
+
+    return errorMessage.isEmpty()?
+               res:
+               QString();
+}
+
+//==============================================================================
+
+void Tests::roundTripTests()
+{
+    // Export a data store to a binary file and check its layout
+
+    QTemporaryDir directory;
+    double values[NbOfVariables];
+    OpenCOR::DataStore::DataStore dataStore;
+
+    populateDataStore(&dataStore, values);
+
+    QString fileName = exportDataStore(&dataStore, directory.path());
+
+    QVERIFY(!fileName.isEmpty());
+
+    OpenCOR::BinaryDataStore::BinaryDataStoreFile binaryFile(fileName);
+
+    QVERIFY(binaryFile.isValid());
+    QCOMPARE(binaryFile.columnsCount(), 1+NbOfVariables);
+    QCOMPARE(binaryFile.runSizes(), QList<quint64>() << FirstRunSize << SecondRunSize);
+    QCOMPARE(binaryFile.uris(), QStringList() << "main/time" << "main/x0" << "main/x1" << "main/x2" << "main/x3");
+    QCOMPARE(binaryFile.names(), QStringList() << "time" << "x0" << "x1" << "x2" << "x3");
+    QCOMPARE(binaryFile.units(), QStringList() << "ms" << "mV" << "mV" << "mV" << "mV");
+
+    // Import our binary file, which should give us the last run of our data
+    // store, and match its columns with our exported variables using their URI
+
+    OpenCOR::BinaryDataStore::BinaryDataStorePlugin plugin;
+    OpenCOR::DataStore::DataStore importDataStore;
+    OpenCOR::DataStore::DataStore resultsDataStore;
+    OpenCOR::DataStore::DataStoreImportData *importData = plugin.getImportData(fileName, &importDataStore,
+                                                                               &resultsDataStore, {});
+
+    QVERIFY(importData != nullptr);
+    QVERIFY(importData->valid());
+    QCOMPARE(importData->nbOfVariables(), NbOfVariables);
+    QCOMPARE(importData->nbOfDataPoints(), SecondRunSize);
+
+    OpenCOR::DataStore::DataStoreVariables importVariables = importDataStore.voiAndVariables();
+
+    QCOMPARE(importVariables.count(), 1+NbOfVariables);
+
+    for (auto variable : dataStore.voiAndVariables()) {
+        OpenCOR::DataStore::DataStoreVariable *importVariable = nullptr;
+
+        for (auto otherVariable : importVariables) {
+            if (otherVariable->uri() == variable->uri()) {
+                importVariable = otherVariable;
+
+                break;
+            }
+        }
+
+        QVERIFY(importVariable != nullptr);
+        QCOMPARE(importVariable->name(), variable->name());
+        QCOMPARE(importVariable->unit(), variable->unit());
+        QCOMPARE(importVariable->size(), SecondRunSize);
+
+        // An unrecorded variable has no values, so it should have been padded
+        // with NaNs
+
+        bool recorded = variable->size(1) != 0;
+        double *values = variable->values(1);
+        double *importValues = importVariable->values();
+
+        for (quint64 i = 0; i < SecondRunSize; ++i) {
+            if (recorded) {
+                QCOMPARE(importValues[i], values[i]);
+            } else {
+                QVERIFY(qIsNaN(importValues[i]));
+            }
+        }
+    }
+
+    delete[] importData->resultsValues();
+    delete importData;
+}
+
+//==============================================================================
+
+void Tests::invalidFileTests()
+{
+    // Make sure that a truncated binary file and a binary file with some
+    // invalid metadata (here, a URI that is longer than the metadata itself)
+    // are not considered valid
+
+    QTemporaryDir directory;
+    double values[NbOfVariables];
+    OpenCOR::DataStore::DataStore dataStore;
+
+    populateDataStore(&dataStore, values);
+
+    QString fileName = exportDataStore(&dataStore, directory.path());
+
+    QVERIFY(!fileName.isEmpty());
+    QVERIFY(OpenCOR::BinaryDataStore::BinaryDataStoreFile(fileName).isValid());
+
+    QFile file(fileName);
+    qint64 fileSize = file.size();
+
+    QVERIFY(file.resize(fileSize-1));
+    QVERIFY(!OpenCOR::BinaryDataStore::BinaryDataStoreFile(fileName).isValid());
+
+    QVERIFY(file.resize(fileSize));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(qint64(OpenCOR::BinaryDataStore::HeaderFieldsCount+2)*qint64(sizeof(quint64))));
+    QVERIFY(file.write(QByteArray("\x00\x00\x10\x00", 4)) == 4);
+
+    file.close();
+
+    QVERIFY(!OpenCOR::BinaryDataStore::BinaryDataStoreFile(fileName).isValid());
+}
+
+//==============================================================================
+
+QTEST_GUILESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
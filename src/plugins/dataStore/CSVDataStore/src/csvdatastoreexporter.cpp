@@ -27,7 +27,12 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QDir>
-#include <QSet>
+#include <QVector>
+
+//==============================================================================
+
+#include <cmath>
+#include <cstring>
 
 //==============================================================================
 
@@ -36,6 +41,381 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+// Size of the buffer in which we format our rows before writing them, and
+// maximum size of a formatted number (e.g. -2.2250738585072014e-308)
+
+enum {
+    BufferSize = 1024*1024,
+    MaximumNumberSize = 25
+};
+
+//==============================================================================
+
+// Shortest round-trip formatting of doubles
+// Note: we use Florian Loitsch's Grisu2 algorithm, which generates the
+//       shortest (or, in some rare cases, close to shortest) string that reads
+//       back as the exact same double...
+
+struct DiyFp
+{
+    quint64 f;
+    int e;
+};
+
+//==============================================================================
+
+struct CachedPower
+{
+    quint64 f;
+    int e;
+    int k;
+};
+
+//==============================================================================
+
+static const CachedPower CachedPowers[] = {
+    { Q_UINT64_C(0xAB70FE17C79AC6CA), -1060, -300 },
+    { Q_UINT64_C(0xFF77B1FCBEBCDC4F), -1034, -292 },
+    { Q_UINT64_C(0xBE5691EF416BD60C), -1007, -284 },
+    { Q_UINT64_C(0x8DD01FAD907FFC3C),  -980, -276 },
+    { Q_UINT64_C(0xD3515C2831559A83),  -954, -268 },
+    { Q_UINT64_C(0x9D71AC8FADA6C9B5),  -927, -260 },
+    { Q_UINT64_C(0xEA9C227723EE8BCB),  -901, -252 },
+    { Q_UINT64_C(0xAECC49914078536D),  -874, -244 },
+    { Q_UINT64_C(0x823C12795DB6CE57),  -847, -236 },
+    { Q_UINT64_C(0xC21094364DFB5637),  -821, -228 },
+    { Q_UINT64_C(0x9096EA6F3848984F),  -794, -220 },
+    { Q_UINT64_C(0xD77485CB25823AC7),  -768, -212 },
+    { Q_UINT64_C(0xA086CFCD97BF97F4),  -741, -204 },
+    { Q_UINT64_C(0xEF340A98172AACE5),  -715, -196 },
+    { Q_UINT64_C(0xB23867FB2A35B28E),  -688, -188 },
+    { Q_UINT64_C(0x84C8D4DFD2C63F3B),  -661, -180 },
+    { Q_UINT64_C(0xC5DD44271AD3CDBA),  -635, -172 },
+    { Q_UINT64_C(0x936B9FCEBB25C996),  -608, -164 },
+    { Q_UINT64_C(0xDBAC6C247D62A584),  -582, -156 },
+    { Q_UINT64_C(0xA3AB66580D5FDAF6),  -555, -148 },
+    { Q_UINT64_C(0xF3E2F893DEC3F126),  -529, -140 },
+    { Q_UINT64_C(0xB5B5ADA8AAFF80B8),  -502, -132 },
+    { Q_UINT64_C(0x87625F056C7C4A8B),  -475, -124 },
+    { Q_UINT64_C(0xC9BCFF6034C13053),  -449, -116 },
+    { Q_UINT64_C(0x964E858C91BA2655),  -422, -108 },
+    { Q_UINT64_C(0xDFF9772470297EBD),  -396, -100 },
+    { Q_UINT64_C(0xA6DFBD9FB8E5B88F),  -369,  -92 },
+    { Q_UINT64_C(0xF8A95FCF88747D94),  -343,  -84 },
+    { Q_UINT64_C(0xB94470938FA89BCF),  -316,  -76 },
+    { Q_UINT64_C(0x8A08F0F8BF0F156B),  -289,  -68 },
+    { Q_UINT64_C(0xCDB02555653131B6),  -263,  -60 },
+    { Q_UINT64_C(0x993FE2C6D07B7FAC),  -236,  -52 },
+    { Q_UINT64_C(0xE45C10C42A2B3B06),  -210,  -44 },
+    { Q_UINT64_C(0xAA242499697392D3),  -183,  -36 },
+    { Q_UINT64_C(0xFD87B5F28300CA0E),  -157,  -28 },
+    { Q_UINT64_C(0xBCE5086492111AEB),  -130,  -20 },
+    { Q_UINT64_C(0x8CBCCC096F5088CC),  -103,  -12 },
+    { Q_UINT64_C(0xD1B71758E219652C),   -77,   -4 },
+    { Q_UINT64_C(0x9C40000000000000),   -50,    4 },
+    { Q_UINT64_C(0xE8D4A51000000000),   -24,   12 },
+    { Q_UINT64_C(0xAD78EBC5AC620000),     3,   20 },
+    { Q_UINT64_C(0x813F3978F8940984),    30,   28 },
+    { Q_UINT64_C(0xC097CE7BC90715B3),    56,   36 },
+    { Q_UINT64_C(0x8F7E32CE7BEA5C70),    83,   44 },
+    { Q_UINT64_C(0xD5D238A4ABE98068),   109,   52 },
+    { Q_UINT64_C(0x9F4F2726179A2245),   136,   60 },
+    { Q_UINT64_C(0xED63A231D4C4FB27),   162,   68 },
+    { Q_UINT64_C(0xB0DE65388CC8ADA8),   189,   76 },
+    { Q_UINT64_C(0x83C7088E1AAB65DB),   216,   84 },
+    { Q_UINT64_C(0xC45D1DF942711D9A),   242,   92 },
+    { Q_UINT64_C(0x924D692CA61BE758),   269,  100 },
+    { Q_UINT64_C(0xDA01EE641A708DEA),   295,  108 },
+    { Q_UINT64_C(0xA26DA3999AEF774A),   322,  116 },
+    { Q_UINT64_C(0xF209787BB47D6B85),   348,  124 },
+    { Q_UINT64_C(0xB454E4A179DD1877),   375,  132 },
+    { Q_UINT64_C(0x865B86925B9BC5C2),   402,  140 },
+    { Q_UINT64_C(0xC83553C5C8965D3D),   428,  148 },
+    { Q_UINT64_C(0x952AB45CFA97A0B3),   455,  156 },
+    { Q_UINT64_C(0xDE469FBD99A05FE3),   481,  164 },
+    { Q_UINT64_C(0xA59BC234DB398C25),   508,  172 },
+    { Q_UINT64_C(0xF6C69A72A3989F5C),   534,  180 },
+    { Q_UINT64_C(0xB7DCBF5354E9BECE),   561,  188 },
+    { Q_UINT64_C(0x88FCF317F22241E2),   588,  196 },
+    { Q_UINT64_C(0xCC20CE9BD35C78A5),   614,  204 },
+    { Q_UINT64_C(0x98165AF37B2153DF),   641,  212 },
+    { Q_UINT64_C(0xE2A0B5DC971F303A),   667,  220 },
+    { Q_UINT64_C(0xA8D9D1535CE3B396),   694,  228 },
+    { Q_UINT64_C(0xFB9B7CD9A4A7443C),   720,  236 },
+    { Q_UINT64_C(0xBB764C4CA7A44410),   747,  244 },
+    { Q_UINT64_C(0x8BAB8EEFB6409C1A),   774,  252 },
+    { Q_UINT64_C(0xD01FEF10A657842C),   800,  260 },
+    { Q_UINT64_C(0x9B10A4E5E9913129),   827,  268 },
+    { Q_UINT64_C(0xE7109BFBA19C0C9D),   853,  276 },
+    { Q_UINT64_C(0xAC2820D9623BF429),   880,  284 },
+    { Q_UINT64_C(0x80444B5E7AA7CF85),   907,  292 },
+    { Q_UINT64_C(0xBF21E44003ACDD2D),   933,  300 },
+    { Q_UINT64_C(0x8E679C2F5E44FF8F),   960,  308 },
+    { Q_UINT64_C(0xD433179D9C8CB841),   986,  316 },
+    { Q_UINT64_C(0x9E19DB92B4E31BA9),  1013,  324 },
+};
+
+enum {
+    CachedPowersMinimumDecimalExponent = -300,
+    CachedPowersDecimalStep = 8,
+    Alpha = -60,
+    MinimumFixedExponent = -4,
+    MaximumFixedExponent = 15
+};
+
+//==============================================================================
+
+static DiyFp multiply(const DiyFp &pX, const DiyFp &pY)
+{
+    // Return the product of the given DIY floating-point numbers, rounded to
+    // their upper 64 bits
+
+    quint64 xLo = pX.f & 0xFFFFFFFFu;
+    quint64 xHi = pX.f >> 32;
+    quint64 yLo = pY.f & 0xFFFFFFFFu;
+    quint64 yHi = pY.f >> 32;
+    quint64 p0 = xLo*yLo;
+    quint64 p1 = xLo*yHi;
+    quint64 p2 = xHi*yLo;
+    quint64 p3 = xHi*yHi;
+    quint64 q = (p0 >> 32)+(p1 & 0xFFFFFFFFu)+(p2 & 0xFFFFFFFFu)+(quint64(1) << 31);
+
+    return { p3+(p1 >> 32)+(p2 >> 32)+(q >> 32), pX.e+pY.e+64 };
+}
+
+//==============================================================================
+
+static DiyFp normalized(DiyFp pX)
+{
+    // Return the normalised version of the given DIY floating-point number
+
+    while ((pX.f >> 63) == 0) {
+        pX.f <<= 1;
+        --pX.e;
+    }
+
+    return pX;
+}
+
+//==============================================================================
+
+static void grisu2Round(char *pBuffer, int pLength, quint64 pDistance,
+                        quint64 pDelta, quint64 pRest, quint64 pTenK)
+{
+    // Move the last digit of our buffer as close as possible to our value,
+    // while staying within our boundaries
+
+    while (   (pRest < pDistance) && (pDelta-pRest >= pTenK)
+           && (   (pRest+pTenK < pDistance)
+               || (pDistance-pRest > pRest+pTenK-pDistance))) {
+        --pBuffer[pLength-1];
+
+        pRest += pTenK;
+    }
+}
+
+//==============================================================================
+
+static int grisu2(char *pBuffer, int &pDecimalExponent, double pValue)
+{
+    // Determine the (positive) given value and its boundaries
+
+    quint64 bits;
+
+    memcpy(&bits, &pValue, sizeof(double));
+
+    quint64 fraction = bits & ((quint64(1) << 52)-1);
+    int exponent = int(bits >> 52);
+    DiyFp value = (exponent == 0)?
+                      DiyFp { fraction, 1-1075 }:
+                      DiyFp { fraction+(quint64(1) << 52), exponent-1075 };
+    DiyFp upper = normalized({ 2*value.f+1, value.e-1 });
+    DiyFp lower = ((fraction == 0) && (exponent > 1))?
+                      DiyFp { 4*value.f-1, value.e-2 }:
+                      DiyFp { 2*value.f-1, value.e-1 };
+
+    lower = { lower.f << (lower.e-upper.e), upper.e };
+    value = normalized(value);
+
+    // Scale our value and its boundaries using a cached power of ten, so that
+    // our upper boundary has a binary exponent in [Alpha, Alpha+28]
+
+    int f = Alpha-upper.e-1;
+    int k = (f*78913)/(1 << 18)+int(f > 0);
+    const CachedPower &cachedPower = CachedPowers[(-CachedPowersMinimumDecimalExponent+k+CachedPowersDecimalStep-1)/CachedPowersDecimalStep];
+    DiyFp power = { cachedPower.f, cachedPower.e };
+    DiyFp w = multiply(value, power);
+    DiyFp wLower = multiply(lower, power);
+    DiyFp wUpper = multiply(upper, power);
+
+    ++wLower.f;
+    --wUpper.f;
+
+    pDecimalExponent = -cachedPower.k;
+
+    // Generate the digits of our value
+
+    quint64 delta = wUpper.f-wLower.f;
+    quint64 distance = wUpper.f-w.f;
+    int shift = -wUpper.e;
+    quint64 one = quint64(1) << shift;
+    auto integral = quint32(wUpper.f >> shift);
+    quint64 fractional = wUpper.f & (one-1);
+    quint32 powerOfTen = 1;
+    int nbOfDigits = 1;
+
+    while (powerOfTen <= integral/10) {
+        powerOfTen *= 10;
+
+        ++nbOfDigits;
+    }
+
+    int length = 0;
+
+    for (int n = nbOfDigits; n > 0; powerOfTen /= 10) {
+        pBuffer[length++] = char('0'+integral/powerOfTen);
+
+        integral %= powerOfTen;
+
+        --n;
+
+        quint64 rest = (quint64(integral) << shift)+fractional;
+
+        if (rest <= delta) {
+            pDecimalExponent += n;
+
+            grisu2Round(pBuffer, length, distance, delta, rest,
+                        quint64(powerOfTen) << shift);
+
+            return length;
+        }
+    }
+
+    int m = 0;
+
+    do {
+        fractional *= 10;
+        delta *= 10;
+        distance *= 10;
+
+        pBuffer[length++] = char('0'+(fractional >> shift));
+
+        fractional &= one-1;
+
+        ++m;
+    } while (fractional > delta);
+
+    pDecimalExponent -= m;
+
+    grisu2Round(pBuffer, length, distance, delta, fractional, one);
+
+    return length;
+}
+
+//==============================================================================
+
+char * formatNumber(char *pBuffer, double pValue)
+{
+    // Format the given value, in the given buffer, using as few digits as are
+    // needed for it to be read back exactly, and return the end of our
+    // formatted value
+
+    if (qIsNaN(pValue)) {
+        memcpy(pBuffer, "nan", 3);
+
+        return pBuffer+3;
+    }
+
+    if (std::signbit(pValue)) {
+        *pBuffer++ = '-';
+
+        pValue = -pValue;
+    }
+
+    if (qIsInf(pValue)) {
+        memcpy(pBuffer, "inf", 3);
+
+        return pBuffer+3;
+    }
+
+    if (pValue == 0.0) {
+        *pBuffer = '0';
+
+        return pBuffer+1;
+    }
+
+    // Generate our digits and lay them out in fixed or scientific notation,
+    // depending on their decimal exponent
+
+    char digits[20];
+    int decimalExponent;
+    int nbOfDigits = grisu2(digits, decimalExponent, pValue);
+    int n = nbOfDigits+decimalExponent;
+
+    if ((nbOfDigits <= n) && (n <= MaximumFixedExponent)) {
+        memcpy(pBuffer, digits, size_t(nbOfDigits));
+        memset(pBuffer+nbOfDigits, '0', size_t(n-nbOfDigits));
+
+        return pBuffer+n;
+    }
+
+    if ((0 < n) && (n <= MaximumFixedExponent)) {
+        memcpy(pBuffer, digits, size_t(n));
+
+        pBuffer[n] = '.';
+
+        memcpy(pBuffer+n+1, digits+n, size_t(nbOfDigits-n));
+
+        return pBuffer+nbOfDigits+1;
+    }
+
+    if ((MinimumFixedExponent < n) && (n <= 0)) {
+        pBuffer[0] = '0';
+        pBuffer[1] = '.';
+
+        memset(pBuffer+2, '0', size_t(-n));
+        memcpy(pBuffer+2-n, digits, size_t(nbOfDigits));
+
+        return pBuffer+2-n+nbOfDigits;
+    }
+
+    *pBuffer++ = digits[0];
+
+    if (nbOfDigits > 1) {
+        *pBuffer++ = '.';
+
+        memcpy(pBuffer, digits+1, size_t(nbOfDigits-1));
+
+        pBuffer += nbOfDigits-1;
+    }
+
+    *pBuffer++ = 'e';
+
+    int exponent = n-1;
+
+    if (exponent < 0) {
+        *pBuffer++ = '-';
+
+        exponent = -exponent;
+    }
+
+    if (exponent >= 100) {
+        *pBuffer++ = char('0'+exponent/100);
+
+        exponent %= 100;
+
+        *pBuffer++ = char('0'+exponent/10);
+    } else if (exponent >= 10) {
+        *pBuffer++ = char('0'+exponent/10);
+    }
+
+    *pBuffer++ = char('0'+exponent%10);
+
+    return pBuffer;
+}
+
+//==============================================================================
+
 CsvDataStoreExporterWorker::CsvDataStoreExporterWorker(DataStore::DataStoreExportData *pDataStoreData) :
     DataStore::DataStoreExporterWorker(pDataStoreData)
 {
@@ -46,13 +426,17 @@ CsvDataStoreExporterWorker::CsvDataStoreExporterWorker(DataStore::DataStoreExpor
 void CsvDataStoreExporterWorker::run()
 {
     // Export our data store to a CSV file
-    // Note: we would normally rely on a string to which we would append our
-    //       header and then data, and then use that string as a parameter to
-    //       Core::writeFile(). However, although this works fine with 'small'
-    //       amounts of data to export, this can crash OpenCOR if we really have
-    //       a lot of data to write. So, instead, we do what Core::writeFile()
-    //       does, but rather than writing one potentially humongous string, we
-    //       first write our header and then our data, one row at a time...
+    // Note #1: we would normally rely on a string to which we would append our
+    //          header and then data, and then use that string as a parameter
+    //          to Core::writeFile(). However, although this works fine with
+    //          'small' amounts of data to export, this can crash OpenCOR if we
+    //          really have a lot of data to write. So, instead, we do what
+    //          Core::writeFile() does, but rather than writing one potentially
+    //          humongous string, we first write our header and then our data,
+    //          a buffer's worth of rows at a time...
+    // Note #2: the VOI values of each run are sorted, so we merge them, run by
+    //          run, rather than gather, sort and deduplicate all of them, and
+    //          we format our values straight into a reused buffer...
 
     QFile file(Core::temporaryFileName());
     QString errorMessage;
@@ -67,55 +451,30 @@ void CsvDataStoreExporterWorker::run()
 
         variables.removeOne(voi);
 
-        // Retrieve the different values for our VOI and sets of variables
-        // Note #1: this is needed when we have two runs with different
-        //          starting/ending points and/or point intervals...
-        // Note #2: after our for loop, our list may contain duplicates and may
-        //          not be sorted. When it comes to removing duplicates, we do
-        //          this by converting our list to a set and back. Indeed, this
-        //          is much faster than preventing ourselves from adding
-        //          duplicates in the first place...
-
-        QList<DataStore::DataStoreVariables> variablesRuns;
-
-        for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
-            variablesRuns << DataStore::DataStoreVariables();
-        }
+        // Retrieve the VOI values of our runs, as well as the values of our
+        // variables for each of our runs
 
         int nbOfRuns = dataStore->runsCount();
-        QList<quint64> runsIndex;
-        QDoubleList voiValues;
+        int nbOfVariables = variables.count();
+        QVector<const double *> voiValues(nbOfRuns);
+        QVector<quint64> voiSizes(nbOfRuns);
+        QVector<quint64> runsIndex(nbOfRuns);
+        QVector<const double *> variablesValues(nbOfVariables*nbOfRuns);
+        QVector<quint64> variablesSizes(nbOfVariables*nbOfRuns);
+        quint64 nbOfDataPoints = 0;
 
         for (int i = 0; i < nbOfRuns; ++i) {
-            // Original index for the current run
-
-            runsIndex << 0;
-
-            // VOI values
-
-            for (quint64 j = 0, jMax = dataStore->size(i); j < jMax; ++j) {
-                voiValues << dataStore->voi()->value(j, i);
-            }
-
-            // Variables
+            voiValues[i] = dataStore->voi()->values(i);
+            voiSizes[i] = dataStore->size(i);
 
-            int j = -1;
+            nbOfDataPoints += voiSizes[i];
 
-            for (auto variable : variables) {
-                variablesRuns[++j] << variable;
+            for (int j = 0; j < nbOfVariables; ++j) {
+                variablesValues[j*nbOfRuns+i] = variables.at(j)->values(i);
+                variablesSizes[j*nbOfRuns+i] = variables.at(j)->size(i);
             }
         }
 
-        voiValues = voiValues.toSet().toList();
-
-        std::sort(voiValues.begin(), voiValues.end());
-
-        // Determine the number of steps to export everything, i.e. one for our
-        // header and then some for our number of VOI values
-
-        double oneOverNbOfSteps = 1.0/(1+voiValues.count());
-        int stepNb = 0;
-
         // Output our header
 
         static const QString Header = "%1 (%2)%3";
@@ -148,63 +507,108 @@ void CsvDataStoreExporterWorker::run()
 
         bool res = file.write(header.toUtf8()) != -1;
 
-        // Output our different sets of data, one row at a time, if we were able
-        // to output our header
+        // Output our different sets of data, a buffer's worth of rows at a
+        // time, if we were able to output our header
+        // Note: a row consists of the smallest VOI value that has yet to be
+        //       exported and of the values of our variables for the runs which
+        //       current VOI value is (fuzzy) equal to it, the other runs
+        //       getting empty fields...
 
         if (res) {
-            emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
+            QByteArray buffer(BufferSize+(1+nbOfVariables*nbOfRuns)*MaximumNumberSize+2,
+                              Qt::Uninitialized);
+            char *bufferBegin = buffer.data();
+            char *bufferEnd = bufferBegin;
+            QBoolList exportRuns;
+            quint64 nbOfExportedDataPoints = 0;
 
-            for (int i = 0, iMax = voiValues.count(); i < iMax; ++i) {
-                QString rowData;
-                double voiValue = voiValues[i];
+            for (int i = 0; i < nbOfRuns; ++i) {
+                exportRuns << false;
+            }
 
-                if (voi != nullptr) {
-                    rowData += QString::number(voiValue);
+            forever {
+                // Determine our next VOI value and the runs that have it
+
+                double voiValue = qQNaN();
+
+                for (int i = 0; i < nbOfRuns; ++i) {
+                    if (   (runsIndex[i] < voiSizes[i])
+                        && (qIsNaN(voiValue) || (voiValues[i][runsIndex[i]] < voiValue))) {
+                        voiValue = voiValues[i][runsIndex[i]];
+                    }
                 }
 
-                bool firstRowData = true;
-                QBoolList updateRunsIndex;
+                if (qIsNaN(voiValue)) {
+                    break;
+                }
 
-                for (int j = 0; j < nbOfRuns; ++j) {
-                    updateRunsIndex << false;
+                for (int i = 0; i < nbOfRuns; ++i) {
+                    exportRuns[i] =    (runsIndex[i] < voiSizes[i])
+                                    && (   (voiValues[i][runsIndex[i]] == voiValue)
+                                        || qFuzzyCompare(voiValues[i][runsIndex[i]], voiValue));
                 }
 
-                for (const auto &variableRuns : variablesRuns) {
-                    int j = 0;
+                // Output our row
+
+                bool firstField = true;
 
-                    for (auto variableRun : variableRuns) {
-                        if (firstRowData && rowData.isEmpty()) {
-                            firstRowData = false;
+                if (voi != nullptr) {
+                    bufferEnd = formatNumber(bufferEnd, voiValue);
+
+                    firstField = false;
+                }
+
+                for (int i = 0; i < nbOfVariables; ++i) {
+                    for (int j = 0; j < nbOfRuns; ++j) {
+                        if (firstField) {
+                            firstField = false;
                         } else {
-                            rowData += ',';
+                            *bufferEnd++ = ',';
                         }
 
-                        if (   (runsIndex[j] < dataStore->size(j))
-                            && qFuzzyCompare(dataStore->voi()->value(runsIndex[j], j), voiValue)) {
-                            rowData += QString::number(variableRun->value(runsIndex[j], j));
+                        if (exportRuns[j]) {
+                            quint64 index = runsIndex[j];
+                            int k = i*nbOfRuns+j;
 
-                            updateRunsIndex[j] = true;
+                            bufferEnd = formatNumber(bufferEnd, (index < variablesSizes[k])?
+                                                                    variablesValues[k][index]:
+                                                                    qQNaN());
                         }
-
-                        ++j;
                     }
                 }
 
-                for (int j = 0; j < nbOfRuns; ++j) {
-                    if (updateRunsIndex[j]) {
-                        ++runsIndex[j];
+                *bufferEnd++ = '\r';
+                *bufferEnd++ = '\n';
+
+                for (int i = 0; i < nbOfRuns; ++i) {
+                    if (exportRuns[i]) {
+                        ++runsIndex[i];
+                        ++nbOfExportedDataPoints;
                     }
                 }
 
-                rowData += CrLf;
+                // Write our buffer, if it is full enough, and let people know
+                // about our progress
 
-                res = file.write(rowData.toUtf8()) != -1;
+                if (bufferEnd-bufferBegin >= BufferSize) {
+                    res = file.write(bufferBegin, bufferEnd-bufferBegin) != -1;
 
-                if (!res) {
-                    break;
+                    if (!res) {
+                        break;
+                    }
+
+                    bufferEnd = bufferBegin;
+
+                    emit progress(mDataStoreData, double(nbOfExportedDataPoints)/nbOfDataPoints);
                 }
+            }
+
+            if (res && (bufferEnd != bufferBegin)) {
+                res = file.write(bufferBegin, bufferEnd-bufferBegin) != -1;
+            }
 
-                emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
+            if (res) {
+                emit progress(mDataStoreData, 1.0);
             }
         }
 
@@ -34,6 +34,10 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+char * formatNumber(char *pBuffer, double pValue);
+
+//==============================================================================
+
 class CsvDataStoreExporterWorker : public DataStore::DataStoreExporterWorker
 {
     Q_OBJECT
@@ -27,7 +27,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QFile>
-#include <QTextStream>
+#include <QThread>
+
+//==============================================================================
+
+#include <QtConcurrent/QtConcurrent>
+
+//==============================================================================
+
+#include <cstring>
 
 //==============================================================================
 
@@ -36,6 +44,216 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+// Size of the chunks in which we split our CSV file to parse it
+
+static const qint64 ChunkSize = 4*1024*1024;
+
+// Powers of ten that can be exactly represented as doubles, as well as the
+// biggest mantissa that can be exactly represented as a double
+
+static const double PowersOfTen[] = { 1.0e0,  1.0e1,  1.0e2,  1.0e3,  1.0e4,
+                                      1.0e5,  1.0e6,  1.0e7,  1.0e8,  1.0e9,
+                                      1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14,
+                                      1.0e15, 1.0e16, 1.0e17, 1.0e18, 1.0e19,
+                                      1.0e20, 1.0e21, 1.0e22 };
+
+enum {
+    MaximumExactPowerOfTen = 22,
+    MaximumNumberOfDigits = 19
+};
+
+static const quint64 MaximumExactMantissa = quint64(1) << 53;
+
+//==============================================================================
+
+static bool isSpace(char pChar)
+{
+    // Return whether the given character is a space
+
+    return (pChar == ' ') || (pChar == '\t') || (pChar == '\r');
+}
+
+//==============================================================================
+
+static bool isDigit(char pChar)
+{
+    // Return whether the given character is a digit
+
+    return (pChar >= '0') && (pChar <= '9');
+}
+
+//==============================================================================
+
+double fieldValue(const char *pBegin, const char *pEnd)
+{
+    // Trim the given field
+
+    while ((pBegin < pEnd) && isSpace(*pBegin)) {
+        ++pBegin;
+    }
+
+    while ((pEnd > pBegin) && isSpace(*(pEnd-1))) {
+        --pEnd;
+    }
+
+    if (pBegin == pEnd) {
+        return 0.0;
+    }
+
+    // Convert the given field to a double
+    // Note #1: we use the fast path of Clinger's algorithm, i.e. if both the
+    //          mantissa and the power of ten can be exactly represented as
+    //          doubles, then a single multiplication/division gives us a
+    //          correctly rounded result...
+    // Note #2: anything else (e.g. too many significant digits, a big
+    //          exponent, "nan" or "inf") is handed over to Qt, which is slower
+    //          but always right...
+
+    const char *current = pBegin;
+    bool negative = *current == '-';
+
+    if (negative || (*current == '+')) {
+        ++current;
+    }
+
+    quint64 mantissa = 0;
+    int nbOfDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool inFraction = false;
+
+    for (; current < pEnd; ++current) {
+        if (isDigit(*current)) {
+            int digit = *current-'0';
+
+            hasDigits = true;
+
+            if ((mantissa != 0) || (digit != 0)) {
+                ++nbOfDigits;
+            }
+
+            if (nbOfDigits > MaximumNumberOfDigits) {
+                break;
+            }
+
+            mantissa = 10*mantissa+quint64(digit);
+
+            if (inFraction) {
+                --exponent;
+            }
+        } else if ((*current == '.') && !inFraction) {
+            inFraction = true;
+        } else {
+            break;
+        }
+    }
+
+    if (   hasDigits && (current < pEnd)
+        && (nbOfDigits <= MaximumNumberOfDigits)
+        && ((*current == 'e') || (*current == 'E'))) {
+        ++current;
+
+        bool negativeExponent = (current < pEnd) && (*current == '-');
+
+        if (negativeExponent || ((current < pEnd) && (*current == '+'))) {
+            ++current;
+        }
+
+        int explicitExponent = 0;
+        const char *exponentBegin = current;
+
+        for (; (current < pEnd) && isDigit(*current); ++current) {
+            explicitExponent = qMin(10*explicitExponent+(*current-'0'), 100000);
+        }
+
+        if (current == exponentBegin) {
+            hasDigits = false;
+        }
+
+        exponent += negativeExponent?
+                        -explicitExponent:
+                        explicitExponent;
+    }
+
+    if (   hasDigits && (current == pEnd)
+        && (nbOfDigits <= MaximumNumberOfDigits)
+        && (mantissa <= MaximumExactMantissa)
+        && (exponent >= -MaximumExactPowerOfTen)
+        && (exponent <= MaximumExactPowerOfTen)) {
+        double res = (exponent < 0)?
+                         double(mantissa)/PowersOfTen[-exponent]:
+                         double(mantissa)*PowersOfTen[exponent];
+
+        return negative?
+                   -res:
+                   res;
+    }
+
+    return QByteArray::fromRawData(pBegin, int(pEnd-pBegin)).toDouble();
+}
+
+//==============================================================================
+
+static QVector<double> chunkValues(const char *pBegin, const char *pEnd,
+                                   int pNbOfValues)
+{
+    // Parse the given chunk of our CSV file, skipping blank lines and using
+    // zero for missing values
+    // Note: we start by counting the number of lines in our chunk, so that we
+    //       can allocate our values once and for all...
+
+    int nbOfLines = 0;
+
+    for (const char *lineEnd = pBegin;
+         (lineEnd = static_cast<const char *>(memchr(lineEnd, '\n', size_t(pEnd-lineEnd)))) != nullptr;
+         ++lineEnd) {
+        ++nbOfLines;
+    }
+
+    QVector<double> res((nbOfLines+1)*pNbOfValues);
+    double *values = res.data();
+
+    for (const char *line = pBegin; line < pEnd;) {
+        auto lineEnd = static_cast<const char *>(memchr(line, '\n', size_t(pEnd-line)));
+
+        if (lineEnd == nullptr) {
+            lineEnd = pEnd;
+        }
+
+        const char *field = line;
+
+        while ((field < lineEnd) && isSpace(*field)) {
+            ++field;
+        }
+
+        if (field < lineEnd) {
+            for (int i = 0; i < pNbOfValues; ++i) {
+                auto fieldEnd = static_cast<const char *>(memchr(field, ',', size_t(lineEnd-field)));
+
+                if (fieldEnd == nullptr) {
+                    fieldEnd = lineEnd;
+                }
+
+                values[i] = fieldValue(field, fieldEnd);
+
+                field = (fieldEnd < lineEnd)?
+                            fieldEnd+1:
+                            lineEnd;
+            }
+
+            values += pNbOfValues;
+        }
+
+        line = lineEnd+1;
+    }
+
+    res.resize(int(values-res.constData()));
+
+    return res;
+}
+
+//==============================================================================
+
 CsvDataStoreImporterWorker::CsvDataStoreImporterWorker(DataStore::DataStoreImportData *pImportData) :
     DataStore::DataStoreImporterWorker(pImportData)
 {
@@ -46,33 +264,90 @@ CsvDataStoreImporterWorker::CsvDataStoreImporterWorker(DataStore::DataStoreImpor
 void CsvDataStoreImporterWorker::run()
 {
     // Import our CSV file in our data store
-    // Note: we rely on our CSV file to be well-formed...
+    // Note #1: we rely on our CSV file to be well-formed...
+    // Note #2: we map our CSV file in memory and split it, on line boundaries,
+    //          into chunks that get parsed in parallel, one batch of chunks at
+    //          a time so that we only ever hold the values of a few chunks in
+    //          memory. The values of a chunk are then added, in order and in
+    //          one go, to our data store (with our VOI last, as in
+    //          DataStore::addValues()) and our progress is updated once per
+    //          chunk rather than once per data point...
+    // Note #3: an empty file cannot be mapped, so we check for it ourselves
+    //          rather than report it as a file that could not be opened...
 
     QFile file(mImportData->fileName());
+    bool opened = file.open(QIODevice::ReadOnly);
+    uchar *data = (opened && (file.size() != 0))?
+                      file.map(0, file.size()):
+                      nullptr;
     QString errorMessage;
 
-    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        QTextStream in(&file);
-        QString line = in.readLine(); // Header, which we ignore
-        DataStore::DataStore *importDataStore = mImportData->importDataStore();
+    if (data != nullptr) {
+        auto fileBegin = reinterpret_cast<const char *>(data);
+        const char *fileEnd = fileBegin+file.size();
+        auto headerEnd = static_cast<const char *>(memchr(fileBegin, '\n', size_t(fileEnd-fileBegin)));
+        const char *current = (headerEnd != nullptr)?
+                                  headerEnd+1:
+                                  fileEnd;
+        DataStore::DataStoreVariable *voi = mImportData->importDataStore()->voi();
+        DataStore::DataStoreVariables importVariables = mImportData->importVariables();
         double *importValues = mImportData->importValues();
         int nbOfVariables = mImportData->nbOfVariables();
+        int nbOfValues = 1+nbOfVariables;
+        quint64 nbOfDataPoints = mImportData->nbOfDataPoints();
+        int nbOfChunks = qMax(QThread::idealThreadCount(), 1);
+
+        while ((current < fileEnd) && (nbOfDataPoints != 0)) {
+            // Parse our next batch of chunks
+
+            QList<QFuture<QVector<double>>> chunks;
 
-        for (quint64 i = 0, iMax = mImportData->nbOfDataPoints(); i < iMax; ++i) {
-            line = in.readLine().trimmed();
+            for (int i = 0; (i < nbOfChunks) && (current < fileEnd); ++i) {
+                const char *chunkEnd = fileEnd;
 
-            QStringList fields = line.split(",");
+                if (fileEnd-current > ChunkSize) {
+                    auto lineEnd = static_cast<const char *>(memchr(current+ChunkSize, '\n', size_t(fileEnd-current-ChunkSize)));
 
-            for (int j = 0; j < nbOfVariables; ++j) {
-                importValues[j] = fields[j+1].toDouble();
+                    if (lineEnd != nullptr) {
+                        chunkEnd = lineEnd+1;
+                    }
+                }
+
+                chunks << QtConcurrent::run(chunkValues, current, chunkEnd, nbOfValues);
+
+                current = chunkEnd;
             }
 
-            importDataStore->addValues(fields[0].toDouble());
+            // Add the values of our chunks to our data store
+
+            for (auto &chunk : chunks) {
+                QVector<double> values = chunk.result();
+                quint64 count = qMin(quint64(values.count()/nbOfValues), nbOfDataPoints);
 
-            emit progress(mImportData, mImportData->progress());
+                if (count == 0) {
+                    continue;
+                }
+
+                for (int i = 0; i < nbOfVariables; ++i) {
+                    importVariables.at(i)->addValues(values.constData()+1+i,
+                                                  count, quint64(nbOfValues));
+                }
+
+                voi->addValues(values.constData(), count, quint64(nbOfValues));
+
+                memcpy(importValues, values.constData()+(count-1)*quint64(nbOfValues)+1,
+                       size_t(nbOfVariables)*sizeof(double));
+
+                nbOfDataPoints -= count;
+
+                emit progress(mImportData, mImportData->progress(count));
+            }
         }
 
+        file.unmap(data);
         file.close();
+    } else if (opened && (file.size() == 0)) {
+        errorMessage = tr("The file is empty.");
     } else {
         errorMessage = tr("The file could not be opened.");
     }
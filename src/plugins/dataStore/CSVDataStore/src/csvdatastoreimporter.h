@@ -34,6 +34,10 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+double fieldValue(const char *pBegin, const char *pEnd);
+
+//==============================================================================
+
 class CsvDataStoreImporterWorker : public DataStore::DataStoreImporterWorker
 {
     Q_OBJECT
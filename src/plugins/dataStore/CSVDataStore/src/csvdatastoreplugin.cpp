@@ -37,6 +37,11 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <algorithm>
+#include <cstring>
+
+//==============================================================================
+
 namespace OpenCOR {
 namespace CSVDataStore {
 
@@ -87,34 +92,65 @@ DataStore::DataStoreImportData * CSVDataStorePlugin::getImportData(const QString
 
     DataStore::DataStoreImportData *res = nullptr;
     QFile file(pFileName);
+    bool opened = file.open(QIODevice::ReadOnly);
+    uchar *data = (opened && (file.size() != 0))?
+                      file.map(0, file.size()):
+                      nullptr;
 
-    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+    if (data != nullptr) {
         // Determine our number of variables and data points
-        // Note #1: we subtract 1 for our number of variables because otherwise
-        //          it would include the VOI, which we don't want...
+        // Note #1: our number of variables is our number of commas in our
+        //          header, i.e. our number of fields minus one since we don't
+        //          want to include the VOI...
         // Note #2: nbOfDataPoints starts at -1 because we are going to count
         //          the header of our CSV file...
+        // Note #3: our CSV file is mapped in memory, so that we can go through
+        //          it as fast as our CsvDataStoreImporterWorker object will...
 
-        QTextStream in(&file);
-        QString line;
+        auto fileBegin = reinterpret_cast<const char *>(data);
+        const char *fileEnd = fileBegin+file.size();
+        auto headerEnd = static_cast<const char *>(memchr(fileBegin, '\n', size_t(fileEnd-fileBegin)));
+
+        if (headerEnd == nullptr) {
+            headerEnd = fileEnd;
+        }
+
+        int nbOfVariables = int(std::count(fileBegin, headerEnd, ','));
         auto nbOfDataPoints = quint64(-1);
 
-        while (!in.atEnd()) {
-            line = in.readLine().trimmed();
+        for (const char *line = fileBegin; line < fileEnd;) {
+            auto lineEnd = static_cast<const char *>(memchr(line, '\n', size_t(fileEnd-line)));
 
-            if (!line.isEmpty()) {
-                ++nbOfDataPoints;
+            if (lineEnd == nullptr) {
+                lineEnd = fileEnd;
             }
-        }
 
-        in.seek(0);
+            for (; line < lineEnd; ++line) {
+                if ((*line != ' ') && (*line != '\t') && (*line != '\r')) {
+                    ++nbOfDataPoints;
+
+                    break;
+                }
+            }
+
+            line = lineEnd+1;
+        }
 
         res = new DataStore::DataStoreImportData(pFileName, pImportDataStore,
                                                  pResultsDataStore,
-                                                 in.readLine().trimmed().split(",").count()-1,
-                                                 nbOfDataPoints, pRunSizes);
+                                                 nbOfVariables, nbOfDataPoints,
+                                                 pRunSizes);
 
+        file.unmap(data);
         file.close();
+    } else if (opened && (file.size() == 0)) {
+        // Our CSV file is empty, so it cannot be mapped, but we still want our
+        // importer to be run so that it can report our CSV file as such rather
+        // than as a file that could not be accessed
+
+        res = new DataStore::DataStoreImportData(pFileName, pImportDataStore,
+                                                 pResultsDataStore, 0, 0,
+                                                 pRunSizes);
     }
 
     // Return some information about the data we want to import
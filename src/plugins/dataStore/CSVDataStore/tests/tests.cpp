@@ -0,0 +1,384 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// CSV data store tests
+//==============================================================================
+
+#include "csvdatastoreexporter.h"
+#include "csvdatastoreimporter.h"
+#include "csvdatastoreplugin.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+//==============================================================================
+
+// Size of the chunks in which our importer splits a CSV file
+
+static const int ChunkSize = 4*1024*1024;
+
+//==============================================================================
+
+static QByteArray formattedNumber(double pValue)
+{
+    // Return the given value, as formatted by our exporter
+
+    char buffer[32];
+
+    return QByteArray(buffer, int(OpenCOR::CSVDataStore::formatNumber(buffer, pValue)-buffer));
+}
+
+//==============================================================================
+
+static void checkNumber(double pValue)
+{
+    // Check that the given value, once formatted by our exporter, is read back
+    // as the exact same value, sign included
+    // Note: a formatted value must also fit in the room that our exporter
+    //       reserves for it, i.e. 25 characters...
+
+    QByteArray number = formattedNumber(pValue);
+    double value = strtod(number.constData(), nullptr);
+
+    QVERIFY2(number.size() <= 25, number.constData());
+
+    if (std::isnan(pValue)) {
+        QVERIFY2(std::isnan(value), number.constData());
+    } else {
+        QVERIFY2(value == pValue, number.constData());
+        QVERIFY2(std::signbit(value) == std::signbit(pValue), number.constData());
+    }
+}
+
+//==============================================================================
+
+static void checkField(const QByteArray &pField)
+{
+    // Check that our importer reads the given field as the exact same value as
+    // Qt does, sign included
+
+    double value = OpenCOR::CSVDataStore::fieldValue(pField.constData(),
+                                                     pField.constData()+pField.size());
+    double expectedValue = pField.toDouble();
+
+    if (std::isnan(expectedValue)) {
+        QVERIFY2(std::isnan(value), pField.constData());
+    } else {
+        QVERIFY2(value == expectedValue, pField.constData());
+        QVERIFY2(std::signbit(value) == std::signbit(expectedValue), pField.constData());
+    }
+}
+
+//==============================================================================
+
+static OpenCOR::DataStore::DataStoreImportData * importCsvFile(const QString &pFileName,
+                                                               OpenCOR::DataStore::DataStore *pImportDataStore,
+                                                               OpenCOR::DataStore::DataStore *pResultsDataStore,
+                                                               QString &pErrorMessage)
+{
+    // Import the given CSV file in the given data store and return our import
+    // data, as well as any error message
+
+    OpenCOR::CSVDataStore::CSVDataStorePlugin plugin;
+    OpenCOR::DataStore::DataStoreImportData *res = plugin.getImportData(pFileName, pImportDataStore,
+                                                                        pResultsDataStore, {});
+
+    pErrorMessage = "not done";
+
+    if (res != nullptr) {
+        OpenCOR::CSVDataStore::CsvDataStoreImporterWorker worker(res);
+
+        QObject::connect(&worker, &OpenCOR::DataStore::DataStoreImporterWorker::done,
+                         [&](OpenCOR::DataStore::DataStoreImportData *, const QString &pWorkerErrorMessage) {
+            pErrorMessage = pWorkerErrorMessage;
+        });
+
+        worker.run();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+void Tests::formatNumberTests()
+{
+    // Special values
+
+    QCOMPARE(formattedNumber(0.0), QByteArray("0"));
+    QCOMPARE(formattedNumber(-0.0), QByteArray("-0"));
+    QCOMPARE(formattedNumber(std::numeric_limits<double>::infinity()), QByteArray("inf"));
+    QCOMPARE(formattedNumber(-std::numeric_limits<double>::infinity()), QByteArray("-inf"));
+    QCOMPARE(formattedNumber(std::numeric_limits<double>::quiet_NaN()), QByteArray("nan"));
+
+    checkNumber(0.0);
+    checkNumber(-0.0);
+    checkNumber(std::numeric_limits<double>::infinity());
+    checkNumber(-std::numeric_limits<double>::infinity());
+    checkNumber(std::numeric_limits<double>::quiet_NaN());
+
+    // Extreme values
+
+    checkNumber(std::numeric_limits<double>::denorm_min());
+    checkNumber(std::numeric_limits<double>::min());
+    checkNumber(std::nextafter(std::numeric_limits<double>::min(), 0.0));
+    checkNumber(std::numeric_limits<double>::max());
+    checkNumber(-std::numeric_limits<double>::max());
+
+    // Boundaries between fixed and scientific notations, i.e. decimal exponents
+    // of -4 and 15
+
+    QCOMPARE(formattedNumber(1.0e-4), QByteArray("0.0001"));
+    QCOMPARE(formattedNumber(1.0e-5), QByteArray("1e-5"));
+    QCOMPARE(formattedNumber(0.00012345), QByteArray("0.00012345"));
+    QCOMPARE(formattedNumber(0.000012345), QByteArray("1.2345e-5"));
+    QCOMPARE(formattedNumber(1.0e14), QByteArray("100000000000000"));
+    QCOMPARE(formattedNumber(999999999999999.0), QByteArray("999999999999999"));
+    QCOMPARE(formattedNumber(123456789012345.6), QByteArray("123456789012345.6"));
+    QCOMPARE(formattedNumber(1.0e15), QByteArray("1e15"));
+    QCOMPARE(formattedNumber(9999999999999998.0), QByteArray("9.999999999999998e15"));
+
+    static const double Boundaries[] = { 1.0e-5, 9.9999999999999991e-5, 1.0e-4,
+                                         1.0e-3, 1.0e14, 999999999999999.0,
+                                         1.0e15, 9999999999999998.0, 1.0e16 };
+
+    for (auto boundary : Boundaries) {
+        checkNumber(boundary);
+        checkNumber(-boundary);
+        checkNumber(std::nextafter(boundary, 0.0));
+        checkNumber(std::nextafter(boundary, HUGE_VAL));
+    }
+
+    // Powers of ten, as well as their neighbours
+
+    for (int i = -323; i <= 308; ++i) {
+        double powerOfTen = strtod(QByteArray("1e"+QByteArray::number(i)).constData(), nullptr);
+
+        checkNumber(powerOfTen);
+        checkNumber(std::nextafter(powerOfTen, 0.0));
+        checkNumber(std::nextafter(powerOfTen, HUGE_VAL));
+    }
+
+    // Random doubles and subnormals, i.e. random bit patterns with and without
+    // an exponent
+
+    QRandomGenerator generator(1);
+
+    for (int i = 0; i < 1000000; ++i) {
+        quint64 bits = generator.generate64();
+        double value;
+
+        memcpy(&value, &bits, sizeof(double));
+
+        checkNumber(value);
+
+        bits &= Q_UINT64_C(0x800FFFFFFFFFFFFF);
+
+        memcpy(&value, &bits, sizeof(double));
+
+        checkNumber(value);
+    }
+}
+
+//==============================================================================
+
+void Tests::fieldValueTests()
+{
+    // Blank, padded and signed fields, as well as fields that are not numbers
+
+    static const char *Fields[] = { "", " ", "1", " 1.5 ", "\t2\r", "-0", "+5",
+                                    ".5", "5.", "-", "1e", "1e+", "nan", "inf",
+                                    "-inf", "0x10" };
+
+    for (auto field : Fields) {
+        checkField(field);
+    }
+
+    // Fields with 19 or more significant digits, i.e. with a mantissa that may
+    // not be exactly representable as a double
+
+    static const char *LongFields[] = { "9007199254740992", "9007199254740993",
+                                        "1234567890123456789",
+                                        "12345678901234567890",
+                                        "1234567890123456789e3",
+                                        "1234567890123456789e-22",
+                                        "0.12345678901234567890123",
+                                        "0000000000000000000000001",
+                                        "1.0000000000000000000",
+                                        "9999999999999999999999e-22",
+                                        "-18446744073709551615" };
+
+    for (auto field : LongFields) {
+        checkField(field);
+    }
+
+    // Exponents just inside and just outside the range of exactly
+    // representable powers of ten, i.e. [-22, 22]
+
+    static const char *Mantissas[] = { "1", "7", "123", "3.14159", "-9007199254740991" };
+
+    for (auto mantissa : Mantissas) {
+        for (int exponent = 20; exponent <= 25; ++exponent) {
+            checkField(mantissa+QByteArray("e")+QByteArray::number(exponent));
+            checkField(mantissa+QByteArray("e-")+QByteArray::number(exponent));
+        }
+    }
+
+    // Random fields, with up to 22 digits, an optional decimal point and an
+    // optional exponent
+
+    QRandomGenerator generator(1);
+
+    for (int i = 0; i < 1000000; ++i) {
+        int nbOfDigits = generator.bounded(1, 23);
+        int decimalPoint = generator.bounded(nbOfDigits+2);
+        QByteArray field = (generator.bounded(2) == 0)?QByteArray("-"):QByteArray();
+
+        for (int j = 0; j < nbOfDigits; ++j) {
+            if (j == decimalPoint) {
+                field += '.';
+            }
+
+            field += char('0'+generator.bounded(10));
+        }
+
+        if (generator.bounded(2) == 0) {
+            field += 'e'+QByteArray::number(generator.bounded(-30, 31));
+        }
+
+        checkField(field);
+    }
+}
+
+//==============================================================================
+
+void Tests::chunkBoundaryTests()
+{
+    // Import a CSV file that is split into several chunks, with one of its
+    // lines crossing the end of our first chunk, and check that all of its
+    // values, including those of that line, are read as Qt would read them
+    // Note: our values alternate between 7 and 18 significant digits, so that
+    //       both our fast and slow paths get used...
+
+    static const int NbOfDataPoints = 200000;
+
+    QTemporaryDir directory;
+    QString fileName = QDir(directory.path()).filePath("data.csv");
+    QByteArray header = "time,x\n";
+    QByteArray contents = header;
+
+    for (int i = 0; i < NbOfDataPoints; ++i) {
+        contents += QByteArray::number(i).rightJustified(8, '0')+','
+                   +QByteArray::number(1.0/(i+1), 'e', (i%2 != 0)?17:6)+'\n';
+    }
+
+    QVERIFY(contents.size() > header.size()+ChunkSize);
+    QVERIFY(contents.at(header.size()+ChunkSize) != '\n');
+    QVERIFY(contents.at(header.size()+ChunkSize-1) != '\n');
+
+    QFile file(fileName);
+
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+
+    file.close();
+
+    OpenCOR::DataStore::DataStore importDataStore;
+    OpenCOR::DataStore::DataStore resultsDataStore;
+    QString errorMessage;
+    OpenCOR::DataStore::DataStoreImportData *importData = importCsvFile(fileName, &importDataStore,
+                                                                        &resultsDataStore, errorMessage);
+
+    QVERIFY(importData != nullptr);
+    QVERIFY(importData->valid());
+    QCOMPARE(errorMessage, QString());
+    QCOMPARE(importData->nbOfVariables(), 1);
+    QCOMPARE(importData->nbOfDataPoints(), quint64(NbOfDataPoints));
+
+    OpenCOR::DataStore::DataStoreVariable *voi = importDataStore.voi();
+    OpenCOR::DataStore::DataStoreVariable *variable = importDataStore.variables().first();
+
+    QCOMPARE(voi->size(), quint64(NbOfDataPoints));
+    QCOMPARE(variable->size(), quint64(NbOfDataPoints));
+
+    QList<QByteArray> lines = contents.split('\n');
+
+    for (int i = 0; i < NbOfDataPoints; ++i) {
+        QList<QByteArray> fields = lines[i+1].split(',');
+
+        QVERIFY(voi->value(quint64(i)) == fields[0].toDouble());
+        QVERIFY(variable->value(quint64(i)) == fields[1].toDouble());
+    }
+
+    delete[] importData->resultsValues();
+    delete importData;
+}
+
+//==============================================================================
+
+void Tests::emptyFileTests()
+{
+    // Make sure that an empty CSV file is reported as such rather than as a
+    // file that could not be opened
+
+    QTemporaryDir directory;
+    QString fileName = QDir(directory.path()).filePath("empty.csv");
+    QFile file(fileName);
+
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    file.close();
+
+    OpenCOR::DataStore::DataStore importDataStore;
+    OpenCOR::DataStore::DataStore resultsDataStore;
+    QString errorMessage;
+    OpenCOR::DataStore::DataStoreImportData *importData = importCsvFile(fileName, &importDataStore,
+                                                                        &resultsDataStore, errorMessage);
+
+    QVERIFY(importData != nullptr);
+    QCOMPARE(errorMessage, QString("The file is empty."));
+
+    delete[] importData->resultsValues();
+    delete importData;
+
+    // A file that doesn't exist should, however, still be reported as a file
+    // that could not be accessed
+
+    QVERIFY(importCsvFile(QDir(directory.path()).filePath("missing.csv"),
+                          &importDataStore, &resultsDataStore, errorMessage) == nullptr);
+}
+
+//==============================================================================
+
+QTEST_GUILESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -438,7 +438,7 @@ PyObject * DataStorePythonWrapper::values(DataStoreVariable *pDataStoreVariable,
     DataStoreArray *dataStoreArray = pDataStoreVariable->array(pRun);
 
     if ((pDataStoreVariable != nullptr) && (dataStoreArray != nullptr)) {
-        auto numPyArray = new NumPyPythonWrapper(dataStoreArray, pDataStoreVariable->size());
+        auto numPyArray = new NumPyPythonWrapper(dataStoreArray, pDataStoreVariable->size(pRun));
 
         return numPyArray->numPyArray();
     }
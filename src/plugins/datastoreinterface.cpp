@@ -31,7 +31,24 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDataStream>
+#include <QDir>
 #include <QThread>
+#include <QUuid>
+
+//==============================================================================
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+//==============================================================================
+
+#ifdef Q_OS_WIN
+    #include <Windows.h>
+#else
+    #include <sys/mman.h>
+#endif
 
 //==============================================================================
 
@@ -43,7 +60,7 @@ extern "C" Q_DECL_EXPORT int dataStoreInterfaceVersion()
 {
     // Version of the data store interface
 
-    return 5;
+    return 9;
 }
 
 //==============================================================================
@@ -52,25 +69,356 @@ namespace DataStore {
 
 //==============================================================================
 
-DataStoreArray::DataStoreArray(quint64 pSize) :
-    mSize(pSize)
+static const quint64 DataStoreArrayChunkSize = 65536;
+
+//==============================================================================
+
+static quint64 dataStoreArrayReservedSize(quint64 pCapacity)
+{
+    // Return the number of values to reserve for a growable array of the given
+    // capacity, i.e. its capacity rounded up to a whole number of chunks
+
+    return DataStoreArrayChunkSize*((pCapacity+DataStoreArrayChunkSize-1)/DataStoreArrayChunkSize);
+}
+
+//==============================================================================
+
+static const quint64 DataStoreMappedFileMagicNumber = 0x534144524f434e4f; // "ONCORDAS"
+static const quint64 DataStoreMappedFileVersion = 2;
+static const quint64 DataStoreMappedFileAlignment = 4096;
+
+enum {
+    MagicNumberField,
+    VersionField,
+    DataOffsetField,
+    ColumnsCountField,
+    CapacityField,
+    SizeField,
+    UrisSizeField,
+    HeaderFieldsCount
+};
+
+static const quint64 DataStoreMappedFileUrisOffset = HeaderFieldsCount*sizeof(quint64);
+
+//==============================================================================
+
+DataStoreMappedFile::DataStoreMappedFile(const QString &pFileName,
+                                         const QStringList &pUris,
+                                         quint64 pCapacity) :
+    mFile(pFileName),
+    mUris(pUris)
+{
+    // Create a file that can hold a column of the given capacity for each of
+    // the given URIs and map it in memory
+    // Note #1: our header consists of some fields followed by the URI of each
+    //          of our columns, so that a column can later be matched with its
+    //          variable using its URI (see DataStore::loadRun()). Our columns
+    //          then start on the next page boundary...
+    // Note #2: the columns of our file are not written to until they are
+    //          actually used, so on most file systems, they don't take any disk
+    //          space until then...
+    // Note #3: we never reuse an existing file since it might be mapped by
+    //          someone else (e.g. a run that was previously loaded), in which
+    //          case truncating it would pull the rug from under their feet...
+
+    if (!mFile.open(QIODevice::ReadWrite|QIODevice::NewOnly)) {
+        throw std::runtime_error("the file could not be created");
+    }
+
+    QByteArray uris;
+    QDataStream urisStream(&uris, QIODevice::WriteOnly);
+
+    urisStream.setVersion(QDataStream::Qt_5_12);
+
+    urisStream << pUris;
+
+    quint64 dataOffset = DataStoreMappedFileAlignment*((DataStoreMappedFileUrisOffset+quint64(uris.size())+DataStoreMappedFileAlignment-1)/DataStoreMappedFileAlignment);
+
+    map(dataOffset+quint64(pUris.count())*pCapacity*Solver::SizeOfDouble);
+
+    mHeader[MagicNumberField] = DataStoreMappedFileMagicNumber;
+    mHeader[VersionField] = DataStoreMappedFileVersion;
+    mHeader[DataOffsetField] = dataOffset;
+    mHeader[ColumnsCountField] = quint64(pUris.count());
+    mHeader[CapacityField] = pCapacity;
+    mHeader[SizeField] = 0;
+    mHeader[UrisSizeField] = quint64(uris.size());
+
+    memcpy(mMemory+DataStoreMappedFileUrisOffset, uris.constData(), size_t(uris.size()));
+
+    mData = reinterpret_cast<double *>(mMemory+dataOffset);
+}
+
+//==============================================================================
+
+DataStoreMappedFile::DataStoreMappedFile(const QString &pFileName) :
+    mFile(pFileName)
+{
+    // Open an existing file, map it in memory and retrieve the URI of its
+    // columns, after having made sure that it is one of ours
+
+    if (!mFile.open(QIODevice::ReadWrite)) {
+        throw std::runtime_error("the file could not be opened");
+    }
+
+    quint64 fileSize = quint64(mFile.size());
+
+    if (fileSize < DataStoreMappedFileUrisOffset) {
+        throw std::runtime_error("the file is not a data store file");
+    }
+
+    map(fileSize);
+
+    if (   (mHeader[MagicNumberField] != DataStoreMappedFileMagicNumber)
+        || (mHeader[VersionField] != DataStoreMappedFileVersion)
+        || (mHeader[DataOffsetField] > fileSize)
+        || (mHeader[UrisSizeField] > quint64(std::numeric_limits<int>::max()))
+        || (mHeader[DataOffsetField] < DataStoreMappedFileUrisOffset+mHeader[UrisSizeField])
+        || (mHeader[SizeField] > mHeader[CapacityField])
+        || (   (mHeader[CapacityField] != 0)
+            && (mHeader[ColumnsCountField] > (fileSize-mHeader[DataOffsetField])/(mHeader[CapacityField]*Solver::SizeOfDouble)))
+        || (fileSize != mHeader[DataOffsetField]+mHeader[ColumnsCountField]*mHeader[CapacityField]*Solver::SizeOfDouble)) {
+        mFile.unmap(mMemory);
+
+        throw std::runtime_error("the file is not a valid data store file");
+    }
+
+    QByteArray uris = QByteArray::fromRawData(reinterpret_cast<const char *>(mMemory+DataStoreMappedFileUrisOffset),
+                                              int(mHeader[UrisSizeField]));
+    QDataStream urisStream(uris);
+
+    urisStream.setVersion(QDataStream::Qt_5_12);
+
+    urisStream >> mUris;
+
+    if (   (urisStream.status() != QDataStream::Ok)
+        || (quint64(mUris.count()) != mHeader[ColumnsCountField])) {
+        mFile.unmap(mMemory);
+
+        throw std::runtime_error("the file is not a valid data store file");
+    }
+
+    mData = reinterpret_cast<double *>(mMemory+mHeader[DataOffsetField]);
+}
+
+//==============================================================================
+
+DataStoreMappedFile::DataStoreMappedFile(const QString &pFileName,
+                                         qint64 pOffset, int pColumnsCount,
+                                         quint64 pSize) :
+    mFile(pFileName),
+    mReadOnlyHeader(HeaderFieldsCount)
+{
+    // Map, in memory and read-only, the given number of contiguous columns of
+    // the given size, starting at the given offset, of the given file, which
+    // was created by someone else (e.g. a data store plugin)
+    // Note: we don't have a header as such, so we keep track of our properties
+    //       using our own, read-only, header...
+
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("the file could not be opened");
+    }
+
+    qint64 dataSize = qint64(quint64(pColumnsCount)*pSize*Solver::SizeOfDouble);
+
+    if (   (pOffset < 0) || (dataSize == 0) || (mFile.size()-pOffset < dataSize)
+        || ((mMemory = mFile.map(pOffset, dataSize)) == nullptr)) {
+        throw std::runtime_error("the file could not be mapped");
+    }
+
+    mHeader = mReadOnlyHeader.data();
+    mData = reinterpret_cast<double *>(mMemory);
+
+    mHeader[ColumnsCountField] = quint64(pColumnsCount);
+    mHeader[CapacityField] = pSize;
+    mHeader[SizeField] = pSize;
+}
+
+//==============================================================================
+
+DataStoreMappedFile::~DataStoreMappedFile()
+{
+    // Unmap our file
+
+    mFile.unmap(mMemory);
+}
+
+//==============================================================================
+
+void DataStoreMappedFile::map(quint64 pFileSize)
+{
+    // Make sure that our file has the given size and map it in memory
+
+    if (   ((quint64(mFile.size()) != pFileSize) && !mFile.resize(qint64(pFileSize)))
+        || ((mMemory = mFile.map(0, qint64(pFileSize))) == nullptr)) {
+        throw std::runtime_error("the file could not be mapped");
+    }
+
+    mHeader = reinterpret_cast<quint64 *>(mMemory);
+}
+
+//==============================================================================
+
+QString DataStoreMappedFile::fileName() const
+{
+    // Return our file name
+
+    return mFile.fileName();
+}
+
+//==============================================================================
+
+QStringList DataStoreMappedFile::uris() const
+{
+    // Return the URI of our columns, if known
+
+    return mUris;
+}
+
+//==============================================================================
+
+int DataStoreMappedFile::columnsCount() const
+{
+    // Return our number of columns
+
+    return int(mHeader[ColumnsCountField]);
+}
+
+//==============================================================================
+
+quint64 DataStoreMappedFile::capacity() const
+{
+    // Return our capacity, i.e. the number of values each of our columns can
+    // hold
+
+    return mHeader[CapacityField];
+}
+
+//==============================================================================
+
+quint64 DataStoreMappedFile::size() const
+{
+    // Return our size, i.e. the number of values that each of our columns was
+    // known to hold the last time we were synchronised
+
+    return mHeader[SizeField];
+}
+
+//==============================================================================
+
+void DataStoreMappedFile::setSize(quint64 pSize)
+{
+    // Set our size
+
+    mHeader[SizeField] = qMin(pSize, capacity());
+}
+
+//==============================================================================
+
+double * DataStoreMappedFile::column(int pColumn) const
+{
+    // Return the given column
+
+    return mData+quint64(pColumn)*capacity();
+}
+
+//==============================================================================
+
+void DataStoreMappedFile::hold()
+{
+    // Increment our reference counter
+
+    ++mReferenceCounter;
+}
+
+//==============================================================================
+
+void DataStoreMappedFile::release()
+{
+    // Decrement our reference counter, and delete ourselves, if needed
+
+    if (--mReferenceCounter == 0) {
+        delete this;
+    }
+}
+
+//==============================================================================
+
+DataStoreArray::DataStoreArray(quint64 pSize, bool pGrowable) :
+    mGrowable(pGrowable),
+    mCapacity(pSize),
+    mSize(pGrowable?0:pSize)
 {
     // Allocate our data
+    // Note: if we are growable, then we only reserve some address space for
+    //       our data, i.e. no memory is actually used until we grow, which we
+    //       do one chunk at a time (see grow()). This means that our data
+    //       never moves, so that a pointer to it remains valid for as long as
+    //       we exist...
+
+    if (!mGrowable) {
+        mData = new double[pSize] {};
+    } else if (mCapacity != 0) {
+        size_t reservedSize = size_t(dataStoreArrayReservedSize(mCapacity))*Solver::SizeOfDouble;
+
+#ifdef Q_OS_WIN
+        mData = static_cast<double *>(VirtualAlloc(nullptr, reservedSize,
+                                                   MEM_RESERVE, PAGE_NOACCESS));
+
+        if (mData == nullptr) {
+            throw std::bad_alloc();
+        }
+#else
+        void *data = mmap(nullptr, reservedSize, PROT_NONE,
+                          MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+
+        if (data == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+            throw std::bad_alloc();
+        }
 
-    mData = new double[pSize] {};
+        mData = static_cast<double *>(data);
+#endif
+    }
+}
+
+//==============================================================================
+
+DataStoreArray::DataStoreArray(quint64 pSize, DataStoreMappedFile *pFile,
+                               int pColumn) :
+    mGrowable(true),
+    mCapacity(pSize),
+    mSize(0),
+    mData(pFile->column(pColumn)),
+    mFile(pFile)
+{
+    // Use the given column of the given file as our data
+    // Note: our file is mapped in memory, so it is up to the OS to page our
+    //       data in and out, meaning that we can hold more data than would fit
+    //       in memory...
+
+    mFile->hold();
 }
 
 //==============================================================================
 
 quint64 DataStoreArray::size() const
 {
-    // Return our size
+    // Return our size, i.e. the number of values that can currently be accessed
 
     return mSize;
 }
 
 //==============================================================================
 
+quint64 DataStoreArray::capacity() const
+{
+    // Return our capacity, i.e. the number of values we can hold at most
+
+    return mCapacity;
+}
+
+//==============================================================================
+
 double * DataStoreArray::data() const
 {
     // Return our data
@@ -93,6 +441,50 @@ double DataStoreArray::data(quint64 pPosition) const
 
 //==============================================================================
 
+bool DataStoreArray::grow(quint64 pSize)
+{
+    // Make sure that we can hold the given number of values, if possible, by
+    // committing as many chunks of memory as needed
+    // Note: memory that has just been committed is guaranteed to be zeroed by
+    //       the OS, just like the memory of a non-growable array...
+
+    if (pSize <= mSize) {
+        return true;
+    }
+
+    if (!mGrowable || (pSize > mCapacity)) {
+        return false;
+    }
+
+    quint64 newSize = qMin(dataStoreArrayReservedSize(pSize),
+                           dataStoreArrayReservedSize(mCapacity));
+
+    if (mFile != nullptr) {
+        mSize = qMin(newSize, mCapacity);
+
+        return true;
+    }
+
+    double *data = mData+dataStoreArrayReservedSize(mSize);
+    size_t dataSize = size_t(newSize-dataStoreArrayReservedSize(mSize))*Solver::SizeOfDouble;
+
+#ifdef Q_OS_WIN
+    if (VirtualAlloc(data, dataSize, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        return false;
+    }
+#else
+    if (mprotect(data, dataSize, PROT_READ|PROT_WRITE) != 0) {
+        return false;
+    }
+#endif
+
+    mSize = qMin(newSize, mCapacity);
+
+    return true;
+}
+
+//==============================================================================
+
 void DataStoreArray::reset()
 {
     // Reset our data
@@ -117,7 +509,17 @@ void DataStoreArray::release()
     // needed
 
     if (--mReferenceCounter == 0) {
-        delete[] mData;
+        if (mFile != nullptr) {
+            mFile->release();
+        } else if (!mGrowable) {
+            delete[] mData;
+        } else if (mData != nullptr) {
+#ifdef Q_OS_WIN
+            VirtualFree(mData, 0, MEM_RELEASE);
+#else
+            munmap(mData, size_t(dataStoreArrayReservedSize(mCapacity))*Solver::SizeOfDouble);
+#endif
+        }
 
         delete this;
     }
@@ -202,13 +604,25 @@ DataStoreValues::~DataStoreValues()
 
 //==============================================================================
 
-DataStoreVariableRun::DataStoreVariableRun(quint64 pCapacity, double *pValue) :
+DataStoreVariableRun::DataStoreVariableRun(quint64 pCapacity, double *pValue,
+                                           DataStoreMappedFile *pFile,
+                                           int pColumn) :
     mCapacity(pCapacity),
     mValue(pValue)
 {
-    // Create our array of values
+    // Create our array of values, which will grow as we add values to it, so
+    // that we only use the memory we need, using the given column of the given
+    // file, if any, in which case we may already have some values
 
-    mArray = new DataStoreArray(mCapacity);
+    if (pFile != nullptr) {
+        mArray = new DataStoreArray(mCapacity, pFile, pColumn);
+
+        grow(pFile->size());
+
+        mSize = pFile->size();
+    } else {
+        mArray = new DataStoreArray(mCapacity, true);
+    }
 }
 
 //==============================================================================
@@ -225,8 +639,11 @@ DataStoreVariableRun::~DataStoreVariableRun()
 quint64 DataStoreVariableRun::size() const
 {
     // Return our size
+    // Note: we may be filled by one thread and read by another (e.g. the GUI),
+    //       so we use acquire semantics to make sure that all the values up to
+    //       our size are visible to our caller...
 
-    return mSize;
+    return mSize.loadAcquire();
 }
 
 //==============================================================================
@@ -235,10 +652,12 @@ void DataStoreVariableRun::addValue()
 {
     // Set the value of the variable at the given position
 
-    if ((mSize < mCapacity) && (mValue != nullptr)) {
-        mArray->data()[mSize] = *mValue;
+    quint64 size = mSize.load();
+
+    if (((size < mArraySize) || grow(size+1)) && (mValue != nullptr)) {
+        mArray->data()[size] = *mValue;
 
-        ++mSize;
+        mSize.storeRelease(size+1);
     }
 }
 
@@ -248,15 +667,56 @@ void DataStoreVariableRun::addValue(double pValue)
 {
     // Set the value of the variable at the given position using the given value
 
-    if (mSize < mCapacity) {
-        mArray->data()[mSize] = pValue;
+    quint64 size = mSize.load();
+
+    if ((size < mArraySize) || grow(size+1)) {
+        mArray->data()[size] = pValue;
 
-        ++mSize;
+        mSize.storeRelease(size+1);
     }
 }
 
 //==============================================================================
 
+void DataStoreVariableRun::addValues(const double *pValues, quint64 pCount,
+                                     quint64 pStride)
+{
+    // Set the values of the variable from the given position using the given
+    // (strided) values, and only then update our size, so that a reader never
+    // sees a value that hasn't been set yet
+
+    quint64 size = mSize.load();
+    quint64 count = qMin(pCount, mCapacity-size);
+
+    if ((size+count > mArraySize) && !grow(size+count)) {
+        count = mArraySize-size;
+    }
+
+    double *data = mArray->data()+size;
+
+    for (quint64 i = 0; i < count; ++i, pValues += pStride) {
+        data[i] = *pValues;
+    }
+
+    mSize.storeRelease(size+count);
+}
+
+//==============================================================================
+
+bool DataStoreVariableRun::grow(quint64 pSize)
+{
+    // Make sure that our array can hold the given number of values, keeping
+    // track of the number of values it can actually hold
+
+    bool res = mArray->grow(pSize);
+
+    mArraySize = mArray->size();
+
+    return res;
+}
+
+//==============================================================================
+
 DataStoreArray * DataStoreVariableRun::array() const
 {
     // Return our array
@@ -270,7 +730,7 @@ double DataStoreVariableRun::value(quint64 pPosition) const
 {
     // Return the value at the given position
 
-    return (pPosition < mSize)?
+    return (pPosition < mSize.loadAcquire())?
                mArray->data()[pPosition]:
                qQNaN();
 }
@@ -309,9 +769,15 @@ bool DataStoreVariable::compare(DataStoreVariable *pVariable1,
 {
     // Determine which of the two variables should be first based on their URI
     // Note: the comparison is case insensitive, so that it's easier for people
-    //       to find a variable...
+    //       to find a variable, but URIs that only differ in case are still
+    //       ordered, so that we are a strict weak ordering in which only
+    //       identical URIs are equivalent...
+
+    int res = pVariable1->uri().compare(pVariable2->uri(), Qt::CaseInsensitive);
 
-    return pVariable1->uri().compare(pVariable2->uri(), Qt::CaseInsensitive) < 0;
+    return (res != 0)?
+               res < 0:
+               pVariable1->uri() < pVariable2->uri();
 }
 
 //==============================================================================
@@ -330,6 +796,26 @@ bool DataStoreVariable::isVisible() const
 
 //==============================================================================
 
+bool DataStoreVariable::isRecorded() const
+{
+    // Return whether we are recorded
+
+    return mRecorded;
+}
+
+//==============================================================================
+
+void DataStoreVariable::setRecorded(bool pRecorded)
+{
+    // Set whether we are to be recorded
+    // Note: this only affects the runs that get added from now on, i.e. a run
+    //       of a variable that is not recorded has no values at all...
+
+    mRecorded = pRecorded;
+}
+
+//==============================================================================
+
 int DataStoreVariable::runsCount() const
 {
     // Return our number of runs
@@ -339,12 +825,16 @@ int DataStoreVariable::runsCount() const
 
 //==============================================================================
 
-bool DataStoreVariable::addRun(quint64 pCapacity)
+bool DataStoreVariable::addRun(quint64 pCapacity, DataStoreMappedFile *pFile,
+                               int pColumn)
 {
-    // Try to add a run of the given capacity
+    // Try to add a run of the given capacity, using the given column of the
+    // given file, if any
 
     try {
-        mRuns << new DataStoreVariableRun(pCapacity, mValue);
+        mRuns << (mRecorded?
+                      new DataStoreVariableRun(pCapacity, mValue, pFile, pColumn):
+                      new DataStoreVariableRun(0, mValue));
     } catch (...) {
         return false;
     }
@@ -503,6 +993,23 @@ void DataStoreVariable::addValue(double pValue, int pRun)
 
 //==============================================================================
 
+void DataStoreVariable::addValues(const double *pValues, quint64 pCount,
+                                  quint64 pStride, int pRun)
+{
+    // Add the given (strided) values to our current (i.e. last) run or to the
+    // given run
+
+    if (!mRuns.isEmpty()) {
+        if (pRun == -1) {
+            mRuns.last()->addValues(pValues, pCount, pStride);
+        } else if ((pRun >= 0) && (pRun < mRuns.count())) {
+            mRuns.at(pRun)->addValues(pValues, pCount, pStride);
+        }
+    }
+}
+
+//==============================================================================
+
 double DataStoreVariable::value(quint64 pPosition, int pRun) const
 {
     // Return the value at the given position and this for the given run
@@ -586,7 +1093,8 @@ DataStoreImportData::DataStoreImportData(const QString &pFileName,
                                          DataStore *pResultsDataStore,
                                          int pNbOfVariables,
                                          quint64 pNbOfDataPoints,
-                                         const QList<quint64> &pRunSizes) :
+                                         const QList<quint64> &pRunSizes,
+                                         DataStoreMappedFile *pFile) :
     DataStoreData(pFileName),
     mImportDataStore(pImportDataStore),
     mResultsDataStore(pResultsDataStore),
@@ -605,12 +1113,15 @@ DataStoreImportData::DataStoreImportData(const QString &pFileName,
     // number of variables for our import/results data store and a run that will
     // contain all of our raw/computed imported data in our import/results data
     // store
-    // Note: we make several calls to DataStore::addVariable() rather than one
-    //       big one to DataStore::addVariables() in case we can't allocate
-    //       enough memory, in which case we will need to remove the variables
-    //       we have added, and a failing call to DataStore::addVariables()
-    //       wouldn't allow us to do this since that call wouldn't actually
-    //       return...
+    // Note #1: if we are given a file, then our import data store uses its
+    //          columns for its run, meaning that our raw imported data is
+    //          already available, i.e. there is nothing to import as such...
+    // Note #2: we make several calls to DataStore::addVariable() rather than
+    //          one big one to DataStore::addVariables() in case we can't
+    //          allocate enough memory, in which case we will need to remove the
+    //          variables we have added, and a failing call to
+    //          DataStore::addVariables() wouldn't allow us to do this since that
+    //          call wouldn't actually return...
 
     try {
         mImportValues = new double[pNbOfVariables] {};
@@ -621,7 +1132,9 @@ DataStoreImportData::DataStoreImportData(const QString &pFileName,
             mResultsVariables << pResultsDataStore->addVariable(mResultsValues+i);
         }
 
-        if (!pImportDataStore->addRun(pNbOfDataPoints)) {
+        if (!((pFile != nullptr)?
+                  pImportDataStore->addRun(pFile):
+                  pImportDataStore->addRun(pNbOfDataPoints))) {
             throw std::exception();
         }
 
@@ -763,11 +1276,14 @@ QList<quint64> DataStoreImportData::runSizes() const
 
 //==============================================================================
 
-double DataStoreImportData::progress()
+double DataStoreImportData::progress(quint64 pNbOfDataPoints)
 {
-    // Increase and return our normalised progress
+    // Increase, by the given number of data points, and return our normalised
+    // progress
+
+    mProgress += pNbOfDataPoints;
 
-    return double(++mProgress)*mOneOverTotalProgress;
+    return double(mProgress)*mOneOverTotalProgress;
 }
 
 //==============================================================================
@@ -810,7 +1326,12 @@ DataStore::DataStore(const QString &pUri) :
 
 DataStore::~DataStore()
 {
-    // Delete some internal objects
+    // Keep track of the size of our runs that are stored in a file, and delete
+    // some internal objects
+
+    syncRuns();
+
+    keepRuns(0);
 
     delete mVoi;
 
@@ -840,19 +1361,158 @@ int DataStore::runsCount() const
 
 //==============================================================================
 
+QString DataStore::directory() const
+{
+    // Return our directory
+
+    return mDirectory;
+}
+
+//==============================================================================
+
+void DataStore::setDirectory(const QString &pDirectory)
+{
+    // Set our directory
+    // Note: if we have a directory, then our runs get stored in files in it,
+    //       rather than in memory. This only affects the runs that get added
+    //       from now on...
+
+    mDirectory = pDirectory;
+}
+
+//==============================================================================
+
+QStringList DataStore::uris()
+{
+    // Return the URI of our VOI and variables, in the order in which they are
+    // stored in a file
+
+    QStringList res;
+
+    res << mVoi->uri();
+
+    for (auto variable : variables()) {
+        res << variable->uri();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 bool DataStore::addRun(quint64 pCapacity)
 {
-    // Try to add a run to our VOI and all our variables
+    // Try to add a run to our VOI and all our variables, storing it in a file
+    // if we have a directory
+    // Note: our file gets a unique name since the number of runs we have says
+    //       nothing about the files that may already exist in our directory,
+    //       be it from a previous session, from another data store, or from a
+    //       run that was loaded from there...
+
+    DataStoreMappedFile *file = nullptr;
+
+    if (!mDirectory.isEmpty()) {
+        syncRuns();
+
+        try {
+            file = new DataStoreMappedFile(QDir(mDirectory).filePath(QString("run-%1.dat").arg(QUuid::createUuid().toString(QUuid::WithoutBraces))),
+                                           uris(), pCapacity);
+        } catch (...) {
+            return false;
+        }
+    }
+
+    bool res = addRun(pCapacity, file);
+
+    if (file != nullptr) {
+        file->release();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+bool DataStore::addRun(DataStoreMappedFile *pFile)
+{
+    // Try to add a run to our VOI and all our variables using the columns of
+    // the given file, i.e. without copying any of its data
+    // Note: unlike for loadRun(), the given file wasn't necessarily created by
+    //       a data store like ours, so it's up to our caller to make sure that
+    //       its columns are in the same order as our VOI and variables...
+
+    return addRun(pFile->capacity(), pFile);
+}
+
+//==============================================================================
+
+bool DataStore::loadRun(const QString &pFileName)
+{
+    // Try to add a run to our VOI and all our variables using the given file,
+    // which must have been created by a data store like ours
+    // Note: a column is matched with our VOI or one of our variables using its
+    //       URI. If several of our variables have the same URI, then they are
+    //       matched, in order, with the columns that have that URI, which is
+    //       fine since our variables are always sorted in the same way (see
+    //       variables())...
+
+    DataStoreMappedFile *file = nullptr;
+
+    try {
+        file = new DataStoreMappedFile(pFileName);
+    } catch (...) {
+        return false;
+    }
+
+    QStringList fileUris = file->uris();
+    QStringList ourUris = uris();
+    QVector<bool> usedColumns(fileUris.count());
+    QList<int> columns;
+
+    if (fileUris.count() == ourUris.count()) {
+        for (const auto &uri : ourUris) {
+            int column = fileUris.indexOf(uri);
+
+            while ((column != -1) && usedColumns[column]) {
+                column = fileUris.indexOf(uri, column+1);
+            }
+
+            if (column == -1) {
+                break;
+            }
+
+            usedColumns[column] = true;
+
+            columns << column;
+        }
+    }
+
+    bool res =    (columns.count() == ourUris.count())
+               && addRun(file->capacity(), file, columns);
+
+    file->release();
+
+    return res;
+}
+
+//==============================================================================
+
+bool DataStore::addRun(quint64 pCapacity, DataStoreMappedFile *pFile,
+                       const QList<int> &pColumns)
+{
+    // Try to add a run to our VOI and all our variables, using the given file,
+    // if any, and the given columns of that file, if any (in the same order as
+    // our VOI and variables), or its columns in order
 
     int oldRunsCount = mVoi->runsCount();
 
     try {
-        if (!mVoi->addRun(pCapacity)) {
+        if (!mVoi->addRun(pCapacity, pFile, pColumns.value(0, 0))) {
             throw std::exception();
         }
 
-        for (auto variable : mVariables) {
-            if (!variable->addRun(pCapacity)) {
+        for (int i = 0, iMax = mVariables.count(); i < iMax; ++i) {
+            if (!mVariables[i]->addRun(pCapacity, pFile, pColumns.value(i+1, i+1))) {
                 throw std::exception();
             }
         }
@@ -860,20 +1520,57 @@ bool DataStore::addRun(quint64 pCapacity)
         // We couldn't add a run to our VOI and all our variables, so only keep
         // the number of runs we used to have
 
-        mVoi->keepRuns(oldRunsCount);
-
-        for (auto variable : mVariables) {
-            variable->keepRuns(oldRunsCount);
-        }
+        keepRuns(oldRunsCount);
 
         return false;
     }
 
+    if (pFile != nullptr) {
+        pFile->hold();
+    }
+
+    mFiles << pFile;
+
     return true;
 }
 
 //==============================================================================
 
+void DataStore::keepRuns(int pRunsCount)
+{
+    // Keep the given number of runs
+
+    mVoi->keepRuns(pRunsCount);
+
+    for (auto variable : mVariables) {
+        variable->keepRuns(pRunsCount);
+    }
+
+    while (mFiles.count() > pRunsCount) {
+        if (mFiles.last() != nullptr) {
+            mFiles.last()->release();
+        }
+
+        mFiles.removeLast();
+    }
+}
+
+//==============================================================================
+
+void DataStore::syncRuns()
+{
+    // Keep track of the size of our runs that are stored in a file, so that
+    // those files can later be loaded back (see loadRun())
+
+    for (int i = 0, iMax = mFiles.count(); i < iMax; ++i) {
+        if (mFiles[i] != nullptr) {
+            mFiles[i]->setSize(mVoi->size(i));
+        }
+    }
+}
+
+//==============================================================================
+
 quint64 DataStore::size(int pRun) const
 {
     // Return our size, i.e. the size of our VOI, for example
@@ -895,8 +1592,10 @@ DataStoreVariable * DataStore::voi() const
 DataStoreVariables DataStore::variables()
 {
     // Return all our variables, after making sure that they are sorted
+    // Note: we use a stable sort, so that variables with the same URI always
+    //       keep the order in which they were added to us...
 
-    std::sort(mVariables.begin(), mVariables.end(), DataStoreVariable::compare);
+    std::stable_sort(mVariables.begin(), mVariables.end(), DataStoreVariable::compare);
 
     return mVariables;
 }
@@ -912,7 +1611,7 @@ DataStoreVariables DataStore::voiAndVariables()
 
     variables << mVoi << mVariables;
 
-    std::sort(variables.begin(), variables.end(), DataStoreVariable::compare);
+    std::stable_sort(variables.begin(), variables.end(), DataStoreVariable::compare);
 
     return variables;
 }
@@ -25,7 +25,11 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QAtomicInteger>
+#include <QFile>
 #include <QObject>
+#include <QStringList>
+#include <QVector>
 
 //==============================================================================
 
@@ -34,16 +38,65 @@ namespace DataStore {
 
 //==============================================================================
 
+class DataStoreMappedFile
+{
+public:
+    explicit DataStoreMappedFile(const QString &pFileName,
+                                 const QStringList &pUris, quint64 pCapacity);
+    explicit DataStoreMappedFile(const QString &pFileName);
+    explicit DataStoreMappedFile(const QString &pFileName, qint64 pOffset,
+                                 int pColumnsCount, quint64 pSize);
+
+    QString fileName() const;
+
+    QStringList uris() const;
+
+    int columnsCount() const;
+    quint64 capacity() const;
+
+    quint64 size() const;
+    void setSize(quint64 pSize);
+
+    double * column(int pColumn) const;
+
+    void hold();
+    void release();
+
+private:
+    int mReferenceCounter = 1;
+
+    QFile mFile;
+
+    QStringList mUris;
+
+    uchar *mMemory = nullptr;
+    quint64 *mHeader = nullptr;
+    double *mData = nullptr;
+
+    QVector<quint64> mReadOnlyHeader;
+
+    ~DataStoreMappedFile();
+
+    void map(quint64 pFileSize);
+};
+
+//==============================================================================
+
 class DataStoreArray
 {
 public:
-    explicit DataStoreArray(quint64 pSize);
+    explicit DataStoreArray(quint64 pSize, bool pGrowable = false);
+    explicit DataStoreArray(quint64 pSize, DataStoreMappedFile *pFile,
+                            int pColumn);
 
     quint64 size() const;
+    quint64 capacity() const;
 
     double * data() const;
     double data(quint64 pPosition) const;
 
+    bool grow(quint64 pSize);
+
     void reset();
 
     void hold();
@@ -52,8 +105,13 @@ public:
 private:
     int mReferenceCounter = 1;
 
+    bool mGrowable;
+
+    quint64 mCapacity;
     quint64 mSize;
     double *mData = nullptr;
+
+    DataStoreMappedFile *mFile = nullptr;
 };
 
 //==============================================================================
@@ -95,7 +153,9 @@ class DataStoreVariableRun : public QObject
     Q_OBJECT
 
 public:
-    explicit DataStoreVariableRun(quint64 pCapacity, double *pValue);
+    explicit DataStoreVariableRun(quint64 pCapacity, double *pValue,
+                                  DataStoreMappedFile *pFile = nullptr,
+                                  int pColumn = 0);
     ~DataStoreVariableRun() override;
 
     quint64 size() const;
@@ -104,16 +164,20 @@ public:
 
     void addValue();
     void addValue(double pValue);
+    void addValues(const double *pValues, quint64 pCount, quint64 pStride);
 
     double value(quint64 pPosition) const;
     double * values() const;
 
 private:
     quint64 mCapacity;
-    quint64 mSize = 0;
+    quint64 mArraySize = 0;
+    QAtomicInteger<quint64> mSize = 0;
 
     DataStoreArray *mArray = nullptr;
     double *mValue;
+
+    bool grow(quint64 pSize);
 };
 
 //==============================================================================
@@ -133,7 +197,8 @@ public:
     static bool compare(DataStoreVariable *pVariable1,
                         DataStoreVariable *pVariable2);
 
-    bool addRun(quint64 pCapacity);
+    bool addRun(quint64 pCapacity, DataStoreMappedFile *pFile = nullptr,
+                int pColumn = 0);
     void keepRuns(int pRunsCount);
 
     void setType(int pType);
@@ -146,12 +211,17 @@ public:
 
     void addValue();
     void addValue(double pValue, int pRun = -1);
+    void addValues(const double *pValues, quint64 pCount, quint64 pStride,
+                   int pRun = -1);
 
     double * values(int pRun = -1) const;
 
 public slots:
     bool isVisible() const;
 
+    bool isRecorded() const;
+    void setRecorded(bool pRecorded);
+
     int runsCount() const;
 
     int type() const;
@@ -175,6 +245,8 @@ private:
 
     double *mValue;
 
+    bool mRecorded = true;
+
     DataStoreVariableRuns mRuns;
 };
 
@@ -213,7 +285,8 @@ public:
                                  DataStore *pResultsDataStore,
                                  int pNbOfVariables,
                                  quint64 pNbOfDataPoints,
-                                 const QList<quint64> &pRunSizes);
+                                 const QList<quint64> &pRunSizes,
+                                 DataStoreMappedFile *pFile = nullptr);
     ~DataStoreImportData() override;
 
     bool valid() const;
@@ -234,7 +307,7 @@ public:
 
     QList<quint64> runSizes() const;
 
-    double progress();
+    double progress(quint64 pNbOfDataPoints = 1);
 
 private:
     bool mValid = true;
@@ -290,7 +363,14 @@ public:
     explicit DataStore(const QString &pUri = {});
     ~DataStore() override;
 
+    QString directory() const;
+    void setDirectory(const QString &pDirectory);
+
     bool addRun(quint64 pCapacity);
+    bool addRun(DataStoreMappedFile *pFile);
+    bool loadRun(const QString &pFileName);
+
+    void syncRuns();
 
     DataStoreVariables variables();
     DataStoreVariables voiAndVariables();
@@ -315,8 +395,17 @@ public slots:
 private:
     QString mUri;
 
+    QString mDirectory;
+    QList<DataStoreMappedFile *> mFiles;
+
     DataStoreVariable *mVoi = nullptr;
     DataStoreVariables mVariables;
+
+    QStringList uris();
+
+    bool addRun(quint64 pCapacity, DataStoreMappedFile *pFile,
+                const QList<int> &pColumns = {});
+    void keepRuns(int pRunsCount);
 };
 
 //==============================================================================
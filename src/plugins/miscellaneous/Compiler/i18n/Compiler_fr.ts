@@ -31,5 +31,25 @@
         <source>the execution engine could not be created</source>
         <translation>le moteur d&apos;exécution n&apos;a pas pu être créé</translation>
     </message>
+    <message>
+        <source>the target machine could not be determined</source>
+        <translation>la machine cible n&apos;a pas pu être déterminée</translation>
+    </message>
+    <message>
+        <source>the cached object code could not be loaded</source>
+        <translation>le code objet mis en cache n&apos;a pas pu être chargé</translation>
+    </message>
+    <message>
+        <source>the bitcode module could not be added to the execution engine</source>
+        <translation>le module de code de bits n&apos;a pas pu être ajouté au moteur d&apos;exécution</translation>
+    </message>
+    <message>
+        <source>%1 (%2), with %3</source>
+        <translation>%1 (%2), avec %3</translation>
+    </message>
+    <message>
+        <source>%1 (generic CPU)</source>
+        <translation>%1 (processeur générique)</translation>
+    </message>
 </context>
 </TS>
@@ -33,13 +33,28 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+//==============================================================================
+
 #include "llvmclangbegin.h"
     #include "llvm/ADT/IntrusiveRefCntPtr.h"
-    #include "llvm/ExecutionEngine/ExecutionEngine.h"
+    #include "llvm/Config/llvm-config.h"
+    #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+    #include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+    #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+    #include "llvm/ExecutionEngine/Orc/ObjectTransformLayer.h"
+    #include "llvm/IR/Module.h"
+    #include "llvm/Object/ObjectFile.h"
+    #include "llvm/Support/Host.h"
     #include "llvm/Support/TargetSelect.h"
 
-    #include "llvm-c/Core.h"
-
     #include "clang/Basic/Diagnostic.h"
     #include "clang/CodeGen/CodeGenAction.h"
     #include "clang/Driver/Compilation.h"
@@ -60,11 +75,165 @@ namespace Compiler {
 
 //==============================================================================
 
+static const char *DummyFileName = "dummyFile.c";
+
+//==============================================================================
+
+static llvm::SmallVector<const char *, 16> compilationArguments(bool pOptimizeForHost)
+{
+    // Return the arguments to compile our code with
+    // Note #1: when optimising for our host, we target its CPU and all of its
+    //          features (e.g. AVX2, AVX-512, FMA), so that the loop and SLP
+    //          vectorisers can make use of them...
+    // Note #2: we don't let Clang assume that there are no infinities or NaNs
+    //          since a model may very well generate some (e.g. log(0.0)) and
+    //          our ODE/NLA solvers rely on them to detect a problem. This also
+    //          means that our inline exp() and log() can safely return and
+    //          test for such values. Ideally, we would only do this for those
+    //          functions, but the version of Clang we use doesn't allow for
+    //          floating-point options to be changed within a file...
+
+    llvm::SmallVector<const char *, 16> res;
+
+    res.emplace_back("clang");
+    res.emplace_back("-fsyntax-only");
+#ifdef QT_DEBUG
+    res.emplace_back("-g");
+    res.emplace_back("-O0");
+#else
+    res.emplace_back("-O3");
+    res.emplace_back("-ffast-math");
+    res.emplace_back("-fno-finite-math-only");
+    res.emplace_back("-fvectorize");
+    res.emplace_back("-fslp-vectorize");
+#endif
+
+    if (pOptimizeForHost) {
+        res.emplace_back("-march=native");
+    }
+
+    res.emplace_back("-Werror");
+    res.emplace_back(DummyFileName);
+
+    return res;
+}
+
+//==============================================================================
+
+static QStringList hostCpuFeatures()
+{
+    // Return the (vector-related) features of our host CPU that are enabled
+
+    QStringList res;
+    llvm::StringMap<bool> features;
+
+    if (llvm::sys::getHostCPUFeatures(features)) {
+        static const QRegularExpression VectorFeatureRegEx = QRegularExpression("^(sse|ssse|avx|fma)");
+
+        for (const auto &feature : features) {
+            QString featureName = QString::fromStdString(feature.first().str());
+
+            if (feature.second && VectorFeatureRegEx.match(featureName).hasMatch()) {
+                res << featureName.toUpper();
+            }
+        }
+    }
+
+    res.sort();
+
+    return res;
+}
+
+//==============================================================================
+
+static llvm::Expected<llvm::orc::JITTargetMachineBuilder> targetMachineBuilder(bool pOptimizeForHost)
+{
+    // Return a builder for our target machine, which targets either our host
+    // CPU and all of its features or a generic CPU
+
+    if (pOptimizeForHost) {
+        return llvm::orc::JITTargetMachineBuilder::detectHost();
+    }
+
+    return llvm::orc::JITTargetMachineBuilder(llvm::Triple(llvm::sys::getProcessTriple()));
+}
+
+//==============================================================================
+
+CompilerEngine::CompilerEngine() :
+    mCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)+"/Compiler")
+{
+}
+
+//==============================================================================
+
 CompilerEngine::~CompilerEngine()
 {
     // Delete some internal objects
 
-    delete mExecutionEngine;
+    reset();
+}
+
+//==============================================================================
+
+void CompilerEngine::reset()
+{
+    // Delete some internal objects
+
+    delete mJit;
+
+    mJit = nullptr;
+}
+
+//==============================================================================
+
+QString CompilerEngine::cacheDirectory() const
+{
+    // Return our cache directory
+
+    return mCacheDirectory;
+}
+
+//==============================================================================
+
+void CompilerEngine::setCacheDirectory(const QString &pCacheDirectory)
+{
+    // Set our cache directory, i.e. where the object code of the code we
+    // compile is to be cached
+    // Note: an empty cache directory means that no caching is to be done...
+
+    mCacheDirectory = pCacheDirectory;
+}
+
+//==============================================================================
+
+bool CompilerEngine::optimizeForHost() const
+{
+    // Return whether we optimise the code we compile for our host CPU
+
+    return mOptimizeForHost;
+}
+
+//==============================================================================
+
+void CompilerEngine::setOptimizeForHost(bool pOptimizeForHost)
+{
+    // Set whether we optimise the code we compile for our host CPU
+    // Note: the resulting object code can only be used on a CPU that has the
+    //       same features as our host CPU, hence we may want to disable it
+    //       (e.g. to compare results across machines)...
+
+    mOptimizeForHost = pOptimizeForHost;
+}
+
+//==============================================================================
+
+QString CompilerEngine::compilationReport() const
+{
+    // Return a report on our last compilation, i.e. our target and, if we
+    // optimised for our host CPU, its name and the features that were enabled
+
+    return mCompilationReport;
 }
 
 //==============================================================================
@@ -87,13 +256,104 @@ QString CompilerEngine::error() const
 
 //==============================================================================
 
-inline std::string functionName(const char *pFunctionName)
+bool CompilerEngine::compileModule(const QByteArray &pCode,
+                                   llvm::LLVMContext *pContext,
+                                   std::unique_ptr<llvm::Module> &pModule)
 {
-#if defined(Q_OS_WIN) || defined(Q_OS_LINUX)
-    return pFunctionName;
-#else
-    return std::string("_")+pFunctionName;
-#endif
+    // Get a driver to compile our code
+
+    auto diagnosticOptions = new clang::DiagnosticOptions();
+    clang::DiagnosticsEngine diagnosticsEngine(llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(new clang::DiagnosticIDs()),
+                                               &*diagnosticOptions);
+    clang::driver::Driver driver("clang", llvm::sys::getProcessTriple(), diagnosticsEngine);
+
+    driver.setCheckInputsExist(false);
+
+    // Get a compilation object to which we pass some arguments
+
+    std::unique_ptr<clang::driver::Compilation> compilation(driver.BuildCompilation(compilationArguments(mOptimizeForHost)));
+
+    if (!compilation) {
+        mError = tr("the compilation object could not be created");
+
+        return false;
+    }
+
+    // The compilation object should have only one command, so if it doesn't
+    // then something went wrong
+
+    clang::driver::JobList &jobs = compilation->getJobs();
+
+    if (    (jobs.size() != 1)
+        || !llvm::isa<clang::driver::Command>(*jobs.begin())) {
+        mError = tr("the compilation object must contain only one command");
+
+        return false;
+    }
+
+    // Retrieve the command job
+
+    static const QString Clang = "clang";
+
+    auto &command = llvm::cast<clang::driver::Command>(*jobs.begin());
+    QString commandName = command.getCreator().getName();
+
+    if (commandName != Clang) {
+        mError = tr("a <strong>clang</strong> command was expected, but a <strong>%1</strong> command was found instead").arg(commandName);
+
+        return false;
+    }
+
+    // Create a compiler invocation using our command's arguments
+
+    const llvm::opt::ArgStringList &commandArguments = command.getArguments();
+    std::unique_ptr<clang::CompilerInvocation> compilerInvocation(new clang::CompilerInvocation());
+
+    clang::CompilerInvocation::CreateFromArgs(*compilerInvocation,
+                                              commandArguments,
+                                              diagnosticsEngine);
+
+    // Map our dummy file to a memory buffer
+
+    compilerInvocation->getPreprocessorOpts().addRemappedFile(DummyFileName, llvm::MemoryBuffer::getMemBuffer(pCode.constData()).release());
+
+    // Create a compiler instance to handle the actual work
+
+    clang::CompilerInstance compilerInstance;
+
+    compilerInstance.setInvocation(std::move(compilerInvocation));
+
+    // Create the compiler instance's diagnostics engine
+
+    compilerInstance.createDiagnostics();
+
+    if (!compilerInstance.hasDiagnostics()) {
+        mError = tr("the diagnostics engine could not be created");
+
+        return false;
+    }
+
+    // Create and execute the frontend to generate an LLVM bitcode module
+
+    std::unique_ptr<clang::CodeGenAction> codeGenerationAction(new clang::EmitLLVMOnlyAction(pContext));
+
+    if (!compilerInstance.ExecuteAction(*codeGenerationAction)) {
+        mError = tr("the code could not be compiled");
+
+        return false;
+    }
+
+    // Retrieve the LLVM bitcode module
+
+    pModule = codeGenerationAction->takeModule();
+
+    if (!pModule) {
+        mError = tr("the bitcode module could not be retrieved");
+
+        return false;
+    }
+
+    return true;
 }
 
 //==============================================================================
@@ -102,18 +362,37 @@ bool CompilerEngine::compileCode(const QString &pCode)
 {
     // Reset ourselves
 
-    delete mExecutionEngine;
-
-    mExecutionEngine = nullptr;
+    reset();
 
     mError = QString();
+    mCompilationReport = QString();
 
     // Prepend all the external functions that may, or not, be needed by the
     // given code
-    // Note: indeed, we cannot include header files since we don't (and don't
-    //       want in order to avoid complications) deploy them with OpenCOR. So,
-    //       instead, we must declare as external functions all the functions
-    //       that we would normally use through header files...
+    // Note #1: indeed, we cannot include header files since we don't (and
+    //          don't want in order to avoid complications) deploy them with
+    //          OpenCOR. So, instead, we must declare as external functions all
+    //          the functions that we would normally use through header files...
+    // Note #2: Clang knows about the standard functions and emits them as LLVM
+    //          intrinsics, so that they can be constant folded and, for simple
+    //          ones like fabs() or floor(), inlined. Others still end up as
+    //          calls to our compiler_*() functions, which prevents loops from
+    //          being vectorised. This is a problem for exp() and log(), which
+    //          are used a lot in models, hence in release mode (i.e. when
+    //          __OPTIMIZE__ is defined) we define them inline using Cephes'
+    //          rational approximations (accurate to about 1 ULP). For exp(),
+    //          the result is scaled by 2^(n-1) in two steps, so that it can be
+    //          subnormal (i.e. for values between about -745.13 and -708).
+    //          Also, n is never less than -1073, so that the product of the
+    //          two scales is exact whatever the order in which the fast math
+    //          options have the multiplications done (the argument reduction
+    //          is then a bit bigger, but only for results that are at most a
+    //          few times the smallest subnormal number). Finally, the second
+    //          part of the argument reduction uses a copy of n that is opaque
+    //          to the compiler, so that the fast math options cannot merge it
+    //          with the first part and lose accuracy...
+    // Note #3: __FAST_MATH__ doesn't get defined since we don't use all of the
+    //          fast math options (see compilationArguments())...
 
     QString code =  "extern double fabs(double);\n"
                     "\n"
@@ -165,189 +444,297 @@ bool CompilerEngine::compileCode(const QString &pCode)
                     "extern double gcd_multi(int, ...);\n"
                     "extern double lcm_multi(int, ...);\n"
                     "\n"
+                    "#ifdef __OPTIMIZE__\n"
+                    "static inline double opencor_exp(double pNb)\n"
+                    "{\n"
+                    "    union { double d; unsigned long long i; } exponent, scale1, scale2;\n"
+                    "    double nb = (pNb > 709.782712893384)?709.782712893384:(pNb < -745.1332191019412)?-745.1332191019412:pNb;\n"
+                    "    double n = __builtin_fmax(__builtin_floor(1.4426950408889634073599*nb+0.5), -1073.0);\n"
+                    "\n"
+                    "    exponent.d = n+6755399441055744.0;\n"
+                    "\n"
+                    "    double r = nb-n*6.93145751953125e-1;\n"
+                    "\n"
+                    "    r = r-(double)((long long)(exponent.i&0x000fffffffffffffULL)-2251799813685248LL)*1.42860682030941723212e-6;\n"
+                    "\n"
+                    "    double rr = r*r;\n"
+                    "    double p = r*((1.26177193074810590878e-4*rr+3.02994407707441961300e-2)*rr+9.99999999999999999910e-1);\n"
+                    "    double h = __builtin_floor(0.5*(n-1.0));\n"
+                    "\n"
+                    "    r = 2.0+4.0*p/((((3.00198505138664455042e-6*rr+2.52448340349684104192e-3)*rr+2.27265548208155028766e-1)*rr+2.00000000000000000009e0)-p);\n"
+                    "\n"
+                    "    scale1.d = h+6755399441055744.0;\n"
+                    "    scale1.i = (scale1.i+1023) << 52;\n"
+                    "    scale2.d = (n-1.0-h)+6755399441055744.0;\n"
+                    "    scale2.i = (scale2.i+1023) << 52;\n"
+                    "\n"
+                    "    return (pNb > 709.782712893384)?__builtin_inf():(pNb < -745.1332191019412)?0.0:r*scale1.d*scale2.d;\n"
+                    "}\n"
+                    "\n"
+                    "static inline double opencor_log(double pNb)\n"
+                    "{\n"
+                    "    union { double d; unsigned long long i; } mantissa, exponent;\n"
+                    "    int subnormal = pNb < 2.2250738585072014e-308;\n"
+                    "\n"
+                    "    mantissa.d = subnormal?18014398509481984.0*pNb:pNb;\n"
+                    "    exponent.i = 0x4330000000000000ULL|(mantissa.i >> 52);\n"
+                    "\n"
+                    "    double e = exponent.d-(subnormal?4503599627370496.0+1022.0+54.0:4503599627370496.0+1022.0);\n"
+                    "\n"
+                    "    mantissa.i = (mantissa.i&0x000fffffffffffffULL)|0x3fe0000000000000ULL;\n"
+                    "\n"
+                    "    int belowSqrtHalf = mantissa.d < 0.70710678118654752440;\n"
+                    "    double m = belowSqrtHalf?mantissa.d+mantissa.d-1.0:mantissa.d-1.0;\n"
+                    "\n"
+                    "    e = belowSqrtHalf?e-1.0:e;\n"
+                    "\n"
+                    "    double z = m*m;\n"
+                    "    double y = m*z*(((((1.01875663804580931796e-4*m+4.97494994976747001425e-1)*m+4.70579119878881725854e0)*m+1.44989225341610930846e1)*m+1.79368678507819816313e1)*m+7.70838733755885391666e0)\n"
+                    "                  /(((((m+1.12873587189167450590e1)*m+4.52279145837532221105e1)*m+8.29875266912776603211e1)*m+7.11544750618563894466e1)*m+2.31251620126765340583e1);\n"
+                    "\n"
+                    "    y = m+(y-e*2.121944400546905827679e-4-0.5*z)+e*0.693359375;\n"
+                    "\n"
+                    "    return (pNb != pNb)?pNb:(pNb < 0.0)?__builtin_nan(\"\"):(pNb == 0.0)?-__builtin_inf():(pNb == __builtin_inf())?__builtin_inf():y;\n"
+                    "}\n"
+                    "\n"
+                    "#define exp opencor_exp\n"
+                    "#define log opencor_log\n"
+                    "#endif\n"
+                    "\n"
                    +pCode;
 
-    // Get a driver to compile our code
+    // Check whether the object code for our code is in our cache, if we have
+    // one, in which case we don't need to compile our code at all
+    // Note: the key of our cache covers everything that affects the object
+    //       code we get, i.e. the version of LLVM, our target, our compilation
+    //       arguments and, of course, our code...
 
-    auto diagnosticOptions = new clang::DiagnosticOptions();
-    clang::DiagnosticsEngine diagnosticsEngine(llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(new clang::DiagnosticIDs()),
-                                               &*diagnosticOptions);
-    clang::driver::Driver driver("clang", llvm::sys::getProcessTriple(), diagnosticsEngine);
+    QByteArray codeByteArray = code.toUtf8();
+    QString objectFileName;
+    QByteArray object;
 
-    driver.setCheckInputsExist(false);
+    if (!mCacheDirectory.isEmpty()) {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
 
-    // Get a compilation object to which we pass some arguments
+        hash.addData(LLVM_VERSION_STRING);
+        hash.addData(llvm::sys::getProcessTriple().c_str());
+        hash.addData(llvm::sys::getHostCPUName().str().c_str());
+        hash.addData(hostCpuFeatures().join(" ").toUtf8());
 
-    llvm::StringRef dummyFileName("dummyFile.c");
-    llvm::SmallVector<const char *, 16> compilationArguments;
+        for (auto compilationArgument : compilationArguments(mOptimizeForHost)) {
+            hash.addData(compilationArgument);
+            hash.addData(" ");
+        }
 
-    compilationArguments.emplace_back("clang");
-    compilationArguments.emplace_back("-fsyntax-only");
-#ifdef QT_DEBUG
-    compilationArguments.emplace_back("-g");
-    compilationArguments.emplace_back("-O0");
-#else
-    compilationArguments.emplace_back("-O3");
-    compilationArguments.emplace_back("-ffast-math");
-#endif
-    compilationArguments.emplace_back("-Werror");
-    compilationArguments.emplace_back(dummyFileName.data());
+        hash.addData(codeByteArray);
 
-    std::unique_ptr<clang::driver::Compilation> compilation(driver.BuildCompilation(compilationArguments));
+        objectFileName = QDir(mCacheDirectory).filePath(hash.result().toHex()+".o");
 
-    if (!compilation) {
-        mError = tr("the compilation object could not be created");
+        QFile objectFile(objectFileName);
 
-        return false;
-    }
+        if (objectFile.open(QIODevice::ReadOnly)) {
+            object = objectFile.readAll();
 
-    // The compilation object should have only one command, so if it doesn't
-    // then something went wrong
+            objectFile.close();
 
-    clang::driver::JobList &jobs = compilation->getJobs();
+            // Make sure that our cached object code is valid since our JIT
+            // would otherwise abort when trying to load it
 
-    if (    (jobs.size() != 1)
-        || !llvm::isa<clang::driver::Command>(*jobs.begin())) {
-        mError = tr("the compilation object must contain only one command");
+            llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> objectFileOrError = llvm::object::ObjectFile::createObjectFile(llvm::MemoryBufferRef(llvm::StringRef(object.constData(), size_t(object.size())), DummyFileName));
+
+            if (!objectFileOrError) {
+                llvm::consumeError(objectFileOrError.takeError());
+
+                object = QByteArray();
+            }
+        }
+    }
 
+    // Compile our code, unless we have its object code in our cache
+    // Note: we use our own LLVM context since our functions may get compiled
+    //       from another thread (see below)...
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> module;
+
+    if (object.isEmpty() && !compileModule(codeByteArray, context.get(), module)) {
         return false;
     }
 
-    // Retrieve the command job
+    // Initialise the native target (and its ASM printer), so not only can we
+    // then create a JIT, but more importantly its data layout will match that
+    // of our target platform
 
-    static const QString Clang = "clang";
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
 
-    auto &command = llvm::cast<clang::driver::Command>(*jobs.begin());
-    QString commandName = command.getCreator().getName();
+    // Create and keep track of a (lazy) JIT
+    // Note #1: our JIT compiles a function only when it gets called for the
+    //          first time, meaning that a function can be used before the
+    //          others have been compiled and that the functions that never get
+    //          used never get compiled...
+    // Note #2: each compiler engine has its own JIT, and therefore its own
+    //          execution session, rather than sharing one with the other
+    //          compiler engines. Indeed, the version of LLVM we use cannot
+    //          remove a JITDylib from an execution session, meaning that a
+    //          shared session would keep the code of every model that has ever
+    //          been compiled until OpenCOR exits...
 
-    if (commandName != Clang) {
-        mError = tr("a <strong>clang</strong> command was expected, but a <strong>%1</strong> command was found instead").arg(commandName);
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> jitTargetMachineBuilder = targetMachineBuilder(mOptimizeForHost);
+
+    if (!jitTargetMachineBuilder) {
+        llvm::consumeError(jitTargetMachineBuilder.takeError());
+
+        mError = tr("the target machine could not be determined");
 
         return false;
     }
 
-    // Create a compiler invocation using our command's arguments
-
-    const llvm::opt::ArgStringList &commandArguments = command.getArguments();
-    std::unique_ptr<clang::CompilerInvocation> compilerInvocation(new clang::CompilerInvocation());
+    llvm::Expected<std::unique_ptr<llvm::orc::LLLazyJIT>> jit = llvm::orc::LLLazyJITBuilder().setJITTargetMachineBuilder(*jitTargetMachineBuilder).create();
 
-    clang::CompilerInvocation::CreateFromArgs(*compilerInvocation,
-                                              commandArguments,
-                                              diagnosticsEngine);
+    if (!jit) {
+        llvm::consumeError(jit.takeError());
 
-    // Map our dummy file to a memory buffer
+        mError = tr("the execution engine could not be created");
 
-    QByteArray codeByteArray = code.toUtf8();
+        return false;
+    }
 
-    compilerInvocation->getPreprocessorOpts().addRemappedFile(dummyFileName, llvm::MemoryBuffer::getMemBuffer(codeByteArray.constData()).release());
+    mJit = jit->release();
 
-    // Create a compiler instance to handle the actual work
+    // Map all the external functions that may, or not, be needed by the given
+    // code, as well as those that have been registered with LLVM (e.g.
+    // doNonLinearSolve(), see CellmlFileRuntime::update())
 
-    clang::CompilerInstance compilerInstance;
+    llvm::orc::SymbolMap symbols;
 
-    compilerInstance.setInvocation(std::move(compilerInvocation));
+    symbols[mJit->mangleAndIntern("fabs")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_fabs), llvm::JITSymbolFlags::Exported);
 
-    // Create the compiler instance's diagnostics engine
+    symbols[mJit->mangleAndIntern("log")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_log), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("exp")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_exp), llvm::JITSymbolFlags::Exported);
 
-    compilerInstance.createDiagnostics();
+    symbols[mJit->mangleAndIntern("floor")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_floor), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("ceil")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_ceil), llvm::JITSymbolFlags::Exported);
 
-    if (!compilerInstance.hasDiagnostics()) {
-        mError = tr("the diagnostics engine could not be created");
+    symbols[mJit->mangleAndIntern("factorial")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_factorial), llvm::JITSymbolFlags::Exported);
 
-        return false;
-    }
+    symbols[mJit->mangleAndIntern("sin")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_sin), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("sinh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_sinh), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("asin")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_asin), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("asinh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_asinh), llvm::JITSymbolFlags::Exported);
 
-    // Create and execute the frontend to generate an LLVM bitcode module
+    symbols[mJit->mangleAndIntern("cos")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_cos), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("cosh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_cosh), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acos")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acos), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acosh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acosh), llvm::JITSymbolFlags::Exported);
 
-    std::unique_ptr<clang::CodeGenAction> codeGenerationAction(new clang::EmitLLVMOnlyAction(llvm::unwrap(LLVMGetGlobalContext())));
+    symbols[mJit->mangleAndIntern("tan")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_tan), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("tanh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_tanh), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("atan")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_atan), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("atanh")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_atanh), llvm::JITSymbolFlags::Exported);
 
-    if (!compilerInstance.ExecuteAction(*codeGenerationAction)) {
-        mError = tr("the code could not be compiled");
+    symbols[mJit->mangleAndIntern("sec")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_sec), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("sech")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_sech), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("asec")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_asec), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("asech")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_asech), llvm::JITSymbolFlags::Exported);
 
-        return false;
-    }
-
-    // Retrieve the LLVM bitcode module
+    symbols[mJit->mangleAndIntern("csc")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_csc), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("csch")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_csch), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acsc")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acsc), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acsch")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acsch), llvm::JITSymbolFlags::Exported);
 
-    std::unique_ptr<llvm::Module> module = codeGenerationAction->takeModule();
+    symbols[mJit->mangleAndIntern("cot")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_cot), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("coth")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_coth), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acot")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acot), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("acoth")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_acoth), llvm::JITSymbolFlags::Exported);
 
-    if (!module) {
-        mError = tr("the bitcode module could not be retrieved");
+    symbols[mJit->mangleAndIntern("arbitrary_log")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_arbitrary_log), llvm::JITSymbolFlags::Exported);
 
-        return false;
-    }
+    symbols[mJit->mangleAndIntern("pow")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_pow), llvm::JITSymbolFlags::Exported);
 
-    // Initialise the native target (and its ASM printer), so not only can we
-    // then create an execution engine, but more importantly its data layout
-    // will match that of our target platform
+    symbols[mJit->mangleAndIntern("multi_min")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_multi_min), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("multi_max")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_multi_max), llvm::JITSymbolFlags::Exported);
 
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
+    symbols[mJit->mangleAndIntern("gcd_multi")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_gcd_multi), llvm::JITSymbolFlags::Exported);
+    symbols[mJit->mangleAndIntern("lcm_multi")] = llvm::JITEvaluatedSymbol(reinterpret_cast<llvm::JITTargetAddress>(compiler_lcm_multi), llvm::JITSymbolFlags::Exported);
 
-    // Create and keep track of an execution engine
+    llvm::orc::JITDylib &mainJitDylib = mJit->getMainJITDylib();
+    llvm::Expected<std::unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> processSymbolsGenerator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(mJit->getDataLayout().getGlobalPrefix());
 
-    mExecutionEngine = llvm::EngineBuilder(std::move(module)).setEngineKind(llvm::EngineKind::JIT).create();
+    if (   mainJitDylib.define(llvm::orc::absoluteSymbols(symbols))
+        || !processSymbolsGenerator) {
+        if (!processSymbolsGenerator) {
+            llvm::consumeError(processSymbolsGenerator.takeError());
+        }
 
-    if (mExecutionEngine == nullptr) {
         mError = tr("the execution engine could not be created");
 
-        module.reset();
+        reset();
 
         return false;
     }
 
-    // Map all the external functions that may, or not, be needed by the given
-    // code
-
-    mExecutionEngine->addGlobalMapping(functionName("fabs"), reinterpret_cast<quint64>(compiler_fabs));
+    mainJitDylib.addGenerator(std::move(*processSymbolsGenerator));
 
-    mExecutionEngine->addGlobalMapping(functionName("log"), reinterpret_cast<quint64>(compiler_log));
-    mExecutionEngine->addGlobalMapping(functionName("exp"), reinterpret_cast<quint64>(compiler_exp));
+    // Add our cached object code or our module to our JIT and, in the latter
+    // case, cache its object code, if needed
+    // Note #1: we cache the object code that our JIT generates, rather than
+    //          generate it ourselves, so that our module doesn't get compiled
+    //          twice. This means, however, that our JIT must compile our module
+    //          as a whole (when one of its functions gets called for the first
+    //          time) since we would otherwise get one object per function...
+    // Note #2: our object code may be generated from any thread (i.e. the one
+    //          from which one of our functions first gets called), hence we
+    //          cache it from our JIT's object transform layer...
+    // Note #3: we use a QSaveFile object so that another instance of OpenCOR
+    //          never sees a partially written file...
 
-    mExecutionEngine->addGlobalMapping(functionName("floor"), reinterpret_cast<quint64>(compiler_floor));
-    mExecutionEngine->addGlobalMapping(functionName("ceil"), reinterpret_cast<quint64>(compiler_ceil));
+    if (!object.isEmpty()) {
+        if (mJit->addObjectFile(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object.constData(), size_t(object.size()))))) {
+            mError = tr("the cached object code could not be loaded");
 
-    mExecutionEngine->addGlobalMapping(functionName("factorial"), reinterpret_cast<quint64>(compiler_factorial));
+            reset();
 
-    mExecutionEngine->addGlobalMapping(functionName("sin"), reinterpret_cast<quint64>(compiler_sin));
-    mExecutionEngine->addGlobalMapping(functionName("sinh"), reinterpret_cast<quint64>(compiler_sinh));
-    mExecutionEngine->addGlobalMapping(functionName("asin"), reinterpret_cast<quint64>(compiler_asin));
-    mExecutionEngine->addGlobalMapping(functionName("asinh"), reinterpret_cast<quint64>(compiler_asinh));
+            return false;
+        }
+    } else {
+        if (!objectFileName.isEmpty()) {
+            mJit->setPartitionFunction(llvm::orc::CompileOnDemandLayer::compileWholeModule);
 
-    mExecutionEngine->addGlobalMapping(functionName("cos"), reinterpret_cast<quint64>(compiler_cos));
-    mExecutionEngine->addGlobalMapping(functionName("cosh"), reinterpret_cast<quint64>(compiler_cosh));
-    mExecutionEngine->addGlobalMapping(functionName("acos"), reinterpret_cast<quint64>(compiler_acos));
-    mExecutionEngine->addGlobalMapping(functionName("acosh"), reinterpret_cast<quint64>(compiler_acosh));
+            mJit->getObjTransformLayer().setTransform([objectFileName](std::unique_ptr<llvm::MemoryBuffer> pObject) -> llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> {
+                QSaveFile objectFile(objectFileName);
+                qint64 objectSize = qint64(pObject->getBufferSize());
 
-    mExecutionEngine->addGlobalMapping(functionName("tan"), reinterpret_cast<quint64>(compiler_tan));
-    mExecutionEngine->addGlobalMapping(functionName("tanh"), reinterpret_cast<quint64>(compiler_tanh));
-    mExecutionEngine->addGlobalMapping(functionName("atan"), reinterpret_cast<quint64>(compiler_atan));
-    mExecutionEngine->addGlobalMapping(functionName("atanh"), reinterpret_cast<quint64>(compiler_atanh));
+                if (   QDir().mkpath(QFileInfo(objectFileName).absolutePath())
+                    && objectFile.open(QIODevice::WriteOnly)
+                    && (objectFile.write(pObject->getBufferStart(), objectSize) == objectSize)) {
+                    objectFile.commit();
+                }
 
-    mExecutionEngine->addGlobalMapping(functionName("sec"), reinterpret_cast<quint64>(compiler_sec));
-    mExecutionEngine->addGlobalMapping(functionName("sech"), reinterpret_cast<quint64>(compiler_sech));
-    mExecutionEngine->addGlobalMapping(functionName("asec"), reinterpret_cast<quint64>(compiler_asec));
-    mExecutionEngine->addGlobalMapping(functionName("asech"), reinterpret_cast<quint64>(compiler_asech));
+                return std::move(pObject);
+            });
+        }
 
-    mExecutionEngine->addGlobalMapping(functionName("csc"), reinterpret_cast<quint64>(compiler_csc));
-    mExecutionEngine->addGlobalMapping(functionName("csch"), reinterpret_cast<quint64>(compiler_csch));
-    mExecutionEngine->addGlobalMapping(functionName("acsc"), reinterpret_cast<quint64>(compiler_acsc));
-    mExecutionEngine->addGlobalMapping(functionName("acsch"), reinterpret_cast<quint64>(compiler_acsch));
+        module->setDataLayout(mJit->getDataLayout());
 
-    mExecutionEngine->addGlobalMapping(functionName("cot"), reinterpret_cast<quint64>(compiler_cot));
-    mExecutionEngine->addGlobalMapping(functionName("coth"), reinterpret_cast<quint64>(compiler_coth));
-    mExecutionEngine->addGlobalMapping(functionName("acot"), reinterpret_cast<quint64>(compiler_acot));
-    mExecutionEngine->addGlobalMapping(functionName("acoth"), reinterpret_cast<quint64>(compiler_acoth));
+        if (mJit->addLazyIRModule(llvm::orc::ThreadSafeModule(std::move(module), llvm::orc::ThreadSafeContext(std::move(context))))) {
+            mError = tr("the bitcode module could not be added to the execution engine");
 
-    mExecutionEngine->addGlobalMapping(functionName("arbitrary_log"), reinterpret_cast<quint64>(compiler_arbitrary_log));
+            reset();
 
-    mExecutionEngine->addGlobalMapping(functionName("pow"), reinterpret_cast<quint64>(compiler_pow));
+            return false;
+        }
+    }
 
-    mExecutionEngine->addGlobalMapping(functionName("multi_min"), reinterpret_cast<quint64>(compiler_multi_min));
-    mExecutionEngine->addGlobalMapping(functionName("multi_max"), reinterpret_cast<quint64>(compiler_multi_max));
+    // Keep track of what our code was compiled for
 
-    mExecutionEngine->addGlobalMapping(functionName("gcd_multi"), reinterpret_cast<quint64>(compiler_gcd_multi));
-    mExecutionEngine->addGlobalMapping(functionName("lcm_multi"), reinterpret_cast<quint64>(compiler_lcm_multi));
+    if (mOptimizeForHost) {
+        mCompilationReport = tr("%1 (%2), with %3").arg(QString::fromStdString(llvm::sys::getProcessTriple()),
+                                                        QString::fromStdString(llvm::sys::getHostCPUName().str()),
+                                                        hostCpuFeatures().join(", "));
+    } else {
+        mCompilationReport = tr("%1 (generic CPU)").arg(QString::fromStdString(llvm::sys::getProcessTriple()));
+    }
 
     return true;
 }
@@ -357,9 +744,18 @@ bool CompilerEngine::compileCode(const QString &pCode)
 void * CompilerEngine::getFunction(const QString &pFunctionName)
 {
     // Return the address of the requested function
+    // Note: the function may not have been compiled yet, in which case we get
+    //       the address of a stub that will compile it when it first gets
+    //       called...
+
+    if (mJit != nullptr) {
+        llvm::Expected<llvm::JITEvaluatedSymbol> symbol = mJit->lookup(qPrintable(pFunctionName));
+
+        if (symbol) {
+            return reinterpret_cast<void *>(symbol->getAddress());
+        }
 
-    if (mExecutionEngine != nullptr) {
-        return reinterpret_cast<void *>(mExecutionEngine->getFunctionAddress(qPrintable(pFunctionName)));
+        llvm::consumeError(symbol.takeError());
     }
 
     return nullptr;
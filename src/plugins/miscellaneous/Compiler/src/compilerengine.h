@@ -34,8 +34,17 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <memory>
+
+//==============================================================================
+
 namespace llvm {
-    class ExecutionEngine;
+    class LLVMContext;
+    class Module;
+
+    namespace orc {
+        class LLLazyJIT;
+    } // namespace orc
 } // namespace llvm
 
 //==============================================================================
@@ -50,8 +59,17 @@ class COMPILER_EXPORT CompilerEngine : public QObject
     Q_OBJECT
 
 public:
+    explicit CompilerEngine();
     ~CompilerEngine() override;
 
+    QString cacheDirectory() const;
+    void setCacheDirectory(const QString &pCacheDirectory);
+
+    bool optimizeForHost() const;
+    void setOptimizeForHost(bool pOptimizeForHost);
+
+    QString compilationReport() const;
+
     bool hasError() const;
     QString error() const;
 
@@ -60,9 +78,18 @@ public:
     void * getFunction(const QString &pFunctionName);
 
 private:
-    llvm::ExecutionEngine *mExecutionEngine = nullptr;
+    QString mCacheDirectory;
+    bool mOptimizeForHost = true;
+
+    llvm::orc::LLLazyJIT *mJit = nullptr;
 
     QString mError;
+    QString mCompilationReport;
+
+    void reset();
+
+    bool compileModule(const QByteArray &pCode, llvm::LLVMContext *pContext,
+                       std::unique_ptr<llvm::Module> &pModule);
 };
 
 //==============================================================================
@@ -32,15 +32,19 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <array>
+#include <cmath>
+#include <limits>
 
 //==============================================================================
 
 void Tests::initTestCase()
 {
-    // Create our compiler engine
+    // Create our compiler engine, making sure that it doesn't use a cache
 
     mCompilerEngine = new OpenCOR::Compiler::CompilerEngine();
 
+    mCompilerEngine->setCacheDirectory(QString());
+
     // Initialise some values
 
     mA = 5.0;
@@ -126,6 +130,123 @@ void Tests::basicTests()
 
 //==============================================================================
 
+void Tests::cacheTests()
+{
+    // Compile some code using a cache and make sure that its object code gets
+    // cached
+    // Note: the object code is cached when our JIT generates it, i.e. when our
+    //       function first gets called...
+
+    static const QString Code = "double function(double pNb1, double pNb2)\n"
+                                "{\n"
+                                "    return pNb1*pNb2+pNb1;\n"
+                                "}";
+
+    QTemporaryDir cacheDirectory;
+
+    {
+        OpenCOR::Compiler::CompilerEngine compilerEngine;
+
+        compilerEngine.setCacheDirectory(cacheDirectory.path());
+
+        QVERIFY(compilerEngine.compileCode(Code));
+        QVERIFY(qFuzzyCompare(reinterpret_cast<double (*)(double, double)>(compilerEngine.getFunction("function"))(mA, mB),
+                              mA*mB+mA));
+    }
+
+    QCOMPARE(QDir(cacheDirectory.path()).entryList(QDir::Files).count(), 1);
+
+    // Compile the same code again using another compiler engine, and make sure
+    // that we can still retrieve and use its function and that no other object
+    // code got cached
+
+    OpenCOR::Compiler::CompilerEngine otherCompilerEngine;
+
+    otherCompilerEngine.setCacheDirectory(cacheDirectory.path());
+
+    QVERIFY(otherCompilerEngine.compileCode(Code));
+    QVERIFY(qFuzzyCompare(reinterpret_cast<double (*)(double, double)>(otherCompilerEngine.getFunction("function"))(mA, mB),
+                          mA*mB+mA));
+    QCOMPARE(QDir(cacheDirectory.path()).entryList(QDir::Files).count(), 1);
+
+    // Make sure that some invalid cached object code is not used, but gets
+    // replaced with valid object code instead
+
+    QString objectFileName = QDir(cacheDirectory.path()).entryInfoList(QDir::Files).first().absoluteFilePath();
+    QFile objectFile(objectFileName);
+
+    QVERIFY(objectFile.open(QIODevice::WriteOnly|QIODevice::Truncate));
+
+    objectFile.write("invalid object code");
+    objectFile.close();
+
+    QVERIFY(otherCompilerEngine.compileCode(Code));
+    QVERIFY(qFuzzyCompare(reinterpret_cast<double (*)(double, double)>(otherCompilerEngine.getFunction("function"))(mA, mB),
+                          mA*mB+mA));
+
+    // Make sure that invalid code is still reported as such (and, in doing so,
+    // that the object code of our previous code has been cached)
+
+    QVERIFY(!otherCompilerEngine.compileCode("double function() { return 3.0*/a; }"));
+
+    QVERIFY(objectFile.open(QIODevice::ReadOnly));
+    QVERIFY(objectFile.readAll() != "invalid object code");
+
+    objectFile.close();
+}
+
+//==============================================================================
+
+void Tests::hostTests()
+{
+    // Compile some vectorisable code for a generic CPU and for our host CPU,
+    // and make sure that we get the same results and a report that reflects
+    // what our code was compiled for
+
+    static const QString Code = "void function(double *pArrayA, double *pArrayB)\n"
+                                "{\n"
+                                "    for (int i = 0; i < 64; ++i) {\n"
+                                "        pArrayA[i] = pArrayA[i]*pArrayB[i]+pArrayB[i];\n"
+                                "    }\n"
+                                "}";
+
+    std::array<double, 64> genericArrayA = {};
+    std::array<double, 64> hostArrayA = {};
+    std::array<double, 64> arrayB = {};
+
+    for (size_t i = 0; i < arrayB.size(); ++i) {
+        genericArrayA[i] = hostArrayA[i] = mA+double(i);
+        arrayB[i] = mB-double(i);
+    }
+
+    mCompilerEngine->setOptimizeForHost(false);
+
+    QVERIFY(!mCompilerEngine->optimizeForHost());
+    QVERIFY(mCompilerEngine->compileCode(Code));
+    QVERIFY(mCompilerEngine->compilationReport().contains("generic CPU"));
+
+    reinterpret_cast<void (*)(double *, double *)>(mCompilerEngine->getFunction("function"))(genericArrayA.data(), arrayB.data());
+
+    mCompilerEngine->setOptimizeForHost(true);
+
+    QVERIFY(mCompilerEngine->optimizeForHost());
+    QVERIFY(mCompilerEngine->compileCode(Code));
+    QVERIFY(!mCompilerEngine->compilationReport().contains("generic CPU"));
+
+    reinterpret_cast<void (*)(double *, double *)>(mCompilerEngine->getFunction("function"))(hostArrayA.data(), arrayB.data());
+
+    for (size_t i = 0; i < arrayB.size(); ++i) {
+        QVERIFY(qFuzzyCompare(hostArrayA[i], genericArrayA[i]));
+    }
+
+    // Make sure that there is no report if our code cannot be compiled
+
+    QVERIFY(!mCompilerEngine->compileCode("double function() { return 3.0*/a; }"));
+    QVERIFY(mCompilerEngine->compilationReport().isEmpty());
+}
+
+//==============================================================================
+
 void Tests::voidFunctionTests()
 {
     std::array<double, 3> arrayA = {};
@@ -499,6 +620,36 @@ void Tests::expFunctionTests()
                           compiler_exp(3.0)));
     QVERIFY(qFuzzyCompare(reinterpret_cast<double (*)(double)>(mCompilerEngine->getFunction("function"))(mA),
                           compiler_exp(mA)));
+
+    // Make sure that our results are accurate over a wide range of values
+    // Note: this is particularly relevant in release mode where exp() is
+    //       defined inline in the code that gets compiled...
+
+    auto function = reinterpret_cast<double (*)(double)>(mCompilerEngine->getFunction("function"));
+
+    for (double nb = -700.0; nb <= 700.0; nb += 0.37) {
+        QVERIFY(qAbs(function(nb)-std::exp(nb)) <= 1.0e-15*std::exp(nb));
+    }
+
+    // Make sure that we gradually underflow, i.e. that our results are
+    // subnormal between about -745.13 and -708, and accurate to within the
+    // smallest subnormal number
+
+    static const double MinSubnormal = 4.9406564584124654e-324;
+
+    for (double nb = -745.1; nb <= -700.0; nb += 0.13) {
+        QVERIFY(qAbs(function(nb)-std::exp(nb)) <= qMax(1.0e-15*std::exp(nb), MinSubnormal));
+    }
+
+    QVERIFY(qAbs(function(-708.0)-std::exp(-708.0)) <= 1.0e-15*std::exp(-708.0));
+    QVERIFY((function(-740.0) > 0.0) && (function(-740.0) < std::numeric_limits<double>::min()));
+    QVERIFY(qAbs(function(-740.0)-std::exp(-740.0)) <= MinSubnormal);
+    QCOMPARE(function(-746.0), 0.0);
+
+    // Make sure that we overflow and underflow as expected
+
+    QVERIFY(qIsInf(function(800.0)) && (function(800.0) > 0.0));
+    QCOMPARE(function(-800.0), 0.0);
 }
 
 //==============================================================================
@@ -514,6 +665,21 @@ void Tests::logFunctionTests()
                           compiler_log(3.0)));
     QVERIFY(qFuzzyCompare(reinterpret_cast<double (*)(double)>(mCompilerEngine->getFunction("function"))(mA),
                           compiler_log(mA)));
+
+    // Make sure that our results are accurate over a wide range of values
+    // Note: this is particularly relevant in release mode where log() is
+    //       defined inline in the code that gets compiled...
+
+    auto function = reinterpret_cast<double (*)(double)>(mCompilerEngine->getFunction("function"));
+
+    for (double nb = 1.0e-300; nb <= 1.0e300; nb *= 1.37) {
+        QVERIFY(qAbs(function(nb)-std::log(nb)) <= 1.0e-15*qMax(qAbs(std::log(nb)), 1.0));
+    }
+
+    // Make sure that we handle zero and negative numbers as expected
+
+    QVERIFY(qIsInf(function(0.0)) && (function(0.0) < 0.0));
+    QVERIFY(qIsNaN(function(-1.0)));
 }
 
 //==============================================================================
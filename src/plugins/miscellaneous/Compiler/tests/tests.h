@@ -60,6 +60,9 @@ private slots:
 
     void basicTests();
 
+    void cacheTests();
+    void hostTests();
+
     void voidFunctionTests();
 
     void timesOperatorTests();
@@ -297,6 +297,10 @@
         <source>Legend</source>
         <translation>Légende</translation>
     </message>
+    <message>
+        <source>Background rendering</source>
+        <translation>Rendu en arrière-plan</translation>
+    </message>
     <message>
         <source>Line</source>
         <translation>Ligne</translation>
@@ -544,6 +548,10 @@
         <source>Model type:</source>
         <translation>Type de modèle :</translation>
     </message>
+    <message>
+        <source>Code generation:</source>
+        <translation>Génération de code :</translation>
+    </message>
     <message>
         <source>DAE</source>
         <translation>EAD</translation>
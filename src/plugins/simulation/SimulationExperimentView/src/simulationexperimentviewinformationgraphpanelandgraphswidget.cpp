@@ -362,6 +362,7 @@ void SimulationExperimentViewInformationGraphPanelAndGraphsWidget::initialize(Gr
             graphPanelPlot->setBackgroundColor(pGraphPanelWidgetProperties.backgroundColor());
             graphPanelPlot->setForegroundColor(pGraphPanelWidgetProperties.foregroundColor());
             graphPanelPlot->setLegendVisible(pGraphPanelWidgetProperties.legend());
+            graphPanelPlot->setBackgroundRendering(pGraphPanelWidgetProperties.backgroundRendering());
         }
 
         // Populate our graph panel property editor
@@ -85,6 +85,7 @@ SimulationExperimentViewPreferencesWidget::SimulationExperimentViewPreferencesWi
     mGraphPanelBackgroundColor = mSettings.value(SettingsPreferencesGraphPanelBackgroundColor, SettingsPreferencesGraphPanelBackgroundColorDefault).value<QColor>();
     mGraphPanelForegroundColor = mSettings.value(SettingsPreferencesGraphPanelForegroundColor, SettingsPreferencesGraphPanelForegroundColorDefault).value<QColor>();
     mGraphPanelLegend = mSettings.value(SettingsPreferencesGraphPanelLegend, SettingsPreferencesGraphPanelLegendDefault).toBool();
+    mGraphPanelBackgroundRendering = mSettings.value(SettingsPreferencesGraphPanelBackgroundRendering, SettingsPreferencesGraphPanelBackgroundRenderingDefault).toBool();
 
     mGraphLineStyle = SEDMLSupport::lineStyle(mSettings.value(SettingsPreferencesGraphLineStyle, SEDMLSupport::stringLineStyle(SettingsPreferencesGraphLineStyleDefault)).toString());
     mGraphLineWidth = mSettings.value(SettingsPreferencesGraphLineWidth, SettingsPreferencesGraphLineWidthDefault).toInt();
@@ -100,6 +101,7 @@ SimulationExperimentViewPreferencesWidget::SimulationExperimentViewPreferencesWi
     mGraphPanelProperties->addColorProperty(mGraphPanelBackgroundColor)->setName(tr("Background colour"));
     mGraphPanelProperties->addColorProperty(mGraphPanelForegroundColor)->setName(tr("Foreground colour"));
     mGraphPanelProperties->addBooleanProperty(mGraphPanelLegend)->setName(tr("Legend"));
+    mGraphPanelProperties->addBooleanProperty(mGraphPanelBackgroundRendering)->setName(tr("Background rendering"));
 
     int propertiesWidth = mSettings.value(SettingsPropertiesWidth, int(0.42*width())).toInt();
 
@@ -194,6 +196,7 @@ bool SimulationExperimentViewPreferencesWidget::preferencesChanged() const
               (graphPanelProperties[0]->colorValue() != mGraphPanelBackgroundColor)
            || (graphPanelProperties[1]->colorValue() != mGraphPanelForegroundColor)
            || (graphPanelProperties[2]->booleanValue() != mGraphPanelLegend)
+           || (graphPanelProperties[3]->booleanValue() != mGraphPanelBackgroundRendering)
               // Graph line preferences
            ||  (graphLineProperties[0]->listValueIndex() != SEDMLSupport::indexLineStyle(mGraphLineStyle))
            ||  (graphLineProperties[1]->integerValue() != mGraphLineWidth)
@@ -215,6 +218,7 @@ void SimulationExperimentViewPreferencesWidget::resetPreferences()
     graphPanelProperties[0]->setColorValue(SettingsPreferencesGraphPanelBackgroundColorDefault);
     graphPanelProperties[1]->setColorValue(SettingsPreferencesGraphPanelForegroundColorDefault);
     graphPanelProperties[2]->setBooleanValue(SettingsPreferencesGraphPanelLegendDefault);
+    graphPanelProperties[3]->setBooleanValue(SettingsPreferencesGraphPanelBackgroundRenderingDefault);
 
     Core::Properties graphProperties = mGraphProperties->properties();
     Core::Properties graphLineProperties = graphProperties[0]->properties();
@@ -241,6 +245,7 @@ void SimulationExperimentViewPreferencesWidget::savePreferences()
     mSettings.setValue(SettingsPreferencesGraphPanelBackgroundColor, graphPanelProperties[0]->colorValue());
     mSettings.setValue(SettingsPreferencesGraphPanelForegroundColor, graphPanelProperties[1]->colorValue());
     mSettings.setValue(SettingsPreferencesGraphPanelLegend, graphPanelProperties[2]->booleanValue());
+    mSettings.setValue(SettingsPreferencesGraphPanelBackgroundRendering, graphPanelProperties[3]->booleanValue());
 
     Core::Properties graphProperties = mGraphProperties->properties();
     Core::Properties graphLineProperties = graphProperties[0]->properties();
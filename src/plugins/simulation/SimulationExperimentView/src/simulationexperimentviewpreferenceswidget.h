@@ -62,15 +62,17 @@ static const auto PluginName = QStringLiteral("SimulationExperimentView");
 
 //==============================================================================
 
-static const auto SettingsPreferencesGraphPanelBackgroundColor = QStringLiteral("GraphPanelBackgroundColor");
-static const auto SettingsPreferencesGraphPanelForegroundColor = QStringLiteral("GraphPanelForegroundColor");
-static const auto SettingsPreferencesGraphPanelLegend          = QStringLiteral("GraphPanelLegend");
+static const auto SettingsPreferencesGraphPanelBackgroundColor     = QStringLiteral("GraphPanelBackgroundColor");
+static const auto SettingsPreferencesGraphPanelForegroundColor     = QStringLiteral("GraphPanelForegroundColor");
+static const auto SettingsPreferencesGraphPanelLegend              = QStringLiteral("GraphPanelLegend");
+static const auto SettingsPreferencesGraphPanelBackgroundRendering = QStringLiteral("GraphPanelBackgroundRendering");
 
 //==============================================================================
 
-static const QColor SettingsPreferencesGraphPanelBackgroundColorDefault = GraphPanelWidget::DefaultGraphPanelBackgroundColor;
-static const QColor SettingsPreferencesGraphPanelForegroundColorDefault = GraphPanelWidget::DefaultGraphPanelForegroundColor;
-static const bool SettingsPreferencesGraphPanelLegendDefault            = GraphPanelWidget::DefaultGraphPanelLegend;
+static const QColor SettingsPreferencesGraphPanelBackgroundColorDefault   = GraphPanelWidget::DefaultGraphPanelBackgroundColor;
+static const QColor SettingsPreferencesGraphPanelForegroundColorDefault   = GraphPanelWidget::DefaultGraphPanelForegroundColor;
+static const bool SettingsPreferencesGraphPanelLegendDefault              = GraphPanelWidget::DefaultGraphPanelLegend;
+static const bool SettingsPreferencesGraphPanelBackgroundRenderingDefault = GraphPanelWidget::DefaultGraphPanelBackgroundRendering;
 
 //==============================================================================
 
@@ -118,6 +120,7 @@ private:
     QColor mGraphPanelBackgroundColor;
     QColor mGraphPanelForegroundColor;
     bool mGraphPanelLegend;
+    bool mGraphPanelBackgroundRendering;
 
     Qt::PenStyle mGraphLineStyle;
     int mGraphLineWidth;
@@ -945,7 +945,8 @@ void SimulationExperimentViewSimulationWidget::initialize(bool pReloading)
                 // output the model type
 
                 information +=  QString()+"<span "+OutputGood+">"+tr("valid")+"</span>."+OutputBrLn
-                               +QString(QString()+OutputTab+"<strong>"+tr("Model type:")+"</strong> <span "+OutputInfo+">%1</span>."+OutputBrLn).arg(runtime->needNlaSolver()?tr("DAE"):tr("ODE"));
+                               +QString(QString()+OutputTab+"<strong>"+tr("Model type:")+"</strong> <span "+OutputInfo+">%1</span>."+OutputBrLn).arg(runtime->needNlaSolver()?tr("DAE"):tr("ODE"))
+                               +QString(QString()+OutputTab+"<strong>"+tr("Code generation:")+"</strong> <span "+OutputInfo+">%1</span>."+OutputBrLn).arg(runtime->compilationReport().toHtmlEscaped());
             } else {
                 // We couldn't retrieve a VOI, which means that we either don't
                 // have a runtime or we have one, but it's not valid or it's
@@ -2637,7 +2638,10 @@ GraphPanelWidget::GraphPanelWidgetProperties SimulationExperimentViewSimulationW
                                                                                          SettingsPreferencesGraphPanelForegroundColorDefault).value<QColor>(),
                                                         PreferencesInterface::preference(PluginName,
                                                                                          SettingsPreferencesGraphPanelLegend,
-                                                                                         SettingsPreferencesGraphPanelLegendDefault).toBool());
+                                                                                         SettingsPreferencesGraphPanelLegendDefault).toBool(),
+                                                        PreferencesInterface::preference(PluginName,
+                                                                                         SettingsPreferencesGraphPanelBackgroundRendering,
+                                                                                         SettingsPreferencesGraphPanelBackgroundRenderingDefault).toBool());
 }
 
 //==============================================================================
@@ -3612,12 +3616,17 @@ void SimulationExperimentViewSimulationWidget::updateGraphData(GraphPanelWidget:
 {
     // Update our graph's data from the given run
 
+    // Note: a parameter that is not recorded has no data, in which case our
+    //       graph has no data either...
+
     if (pGraph->isValid()) {
         SimulationSupport::Simulation *simulation = mViewWidget->simulation(pGraph->fileName());
+        double *dataX = data(simulation, static_cast<CellMLSupport::CellmlFileRuntimeParameter *>(pGraph->parameterX()), pRun);
+        double *dataY = data(simulation, static_cast<CellMLSupport::CellmlFileRuntimeParameter *>(pGraph->parameterY()), pRun);
 
-        pGraph->setData(data(simulation, static_cast<CellMLSupport::CellmlFileRuntimeParameter *>(pGraph->parameterX()), pRun),
-                        data(simulation, static_cast<CellMLSupport::CellmlFileRuntimeParameter *>(pGraph->parameterY()), pRun),
-                        pSize, pRun);
+        pGraph->setData(dataX, dataY,
+                        ((dataX != nullptr) && (dataY != nullptr))?pSize:0,
+                        pRun);
     }
 }
 
@@ -3739,30 +3748,18 @@ void SimulationExperimentViewSimulationWidget::updateSimulationResults(Simulatio
                     // the plot's contents)
 
                     if (!plot->hasDirtyAxes()) {
-                        double minX = plotMinX;
-                        double maxX = plotMaxX;
-                        double minY = plotMinY;
-                        double maxY = plotMaxY;
-
-                        for (quint64 i = (oldDataSize != 0)?oldDataSize-1:0;
-                             i < pSimulationResultsSize; ++i) {
-                            double valX = graph->data(pSimulationRun)->sample(i).x();
-                            double valY = graph->data(pSimulationRun)->sample(i).y();
-
-                            if (   !qIsInf(valX) && !qIsNaN(valX)
-                                && !qIsInf(valY) && !qIsNaN(valY)) {
-                                minX = qMin(minX, valX);
-                                maxX = qMax(maxX, valX);
-                                minY = qMin(minY, valY);
-                                maxY = qMax(maxY, valY);
-                            }
-                        }
+                        // Note: our graph keeps track of the bounding rectangle
+                        //       of the samples that were last added to it, so
+                        //       no need to go through our graph segment...
+
+                        QRectF segmentRect = graph->lastBoundingRect(pSimulationRun);
 
                         // Update our plot, if our graph segment cannot fit
                         // within our plot's current viewport
 
-                        needFullUpdatePlot =    (minX < plotMinX) || (maxX > plotMaxX)
-                                             || (minY < plotMinY) || (maxY > plotMaxY);
+                        needFullUpdatePlot =    (segmentRect.width() >= 0.0)
+                                             && (   (segmentRect.left() < plotMinX) || (segmentRect.right() > plotMaxX)
+                                                 || (segmentRect.top() < plotMinY) || (segmentRect.bottom() > plotMaxY));
                     }
 
                     if (!needFullUpdatePlot) {
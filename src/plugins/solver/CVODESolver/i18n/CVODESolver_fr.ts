@@ -15,6 +15,10 @@
         <source>the &quot;Integration method&quot; property value could not be retrieved</source>
         <translation>la valeur de la propriété &quot;Méthode d&apos;intégration&quot; n&apos;a pas pu être retrouvée</translation>
     </message>
+    <message>
+        <source>the sparse linear solver requires an analytic Jacobian, which is not available for this model</source>
+        <translation>le solveur linéaire creux requiert un jacobien analytique, qui n&apos;est pas disponible pour ce modèle</translation>
+    </message>
     <message>
         <source>the &quot;Preconditioner&quot; property value could not be retrieved</source>
         <translation>la valeur de la propriété &quot;Préconditionneur&quot; n&apos;a pas pu être retrouvée</translation>
@@ -22,6 +22,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include "cvodesolver.h"
+#include "sparselinearsolver.h"
 
 //==============================================================================
 
@@ -55,7 +56,85 @@ int rhsFunction(double pVoi, N_Vector pStates, N_Vector pRates, void *pUserData)
     userData->computeRates()(pVoi, userData->constants(),
                              N_VGetArrayPointer_Serial(pRates),
                              N_VGetArrayPointer_Serial(pStates),
-                             userData->algebraic());
+                             userData->algebraic(), userData->nlaSolver());
+
+    return 0;
+}
+
+//==============================================================================
+
+int jacobianFunction(double pVoi, N_Vector pStates, N_Vector pRates,
+                     SUNMatrix pJacobian, void *pUserData, N_Vector pTemp1,
+                     N_Vector pTemp2, N_Vector pTemp3)
+{
+    Q_UNUSED(pRates)
+    Q_UNUSED(pTemp2)
+    Q_UNUSED(pTemp3)
+
+    // Compute the non-zero entries of our Jacobian and copy them to the given
+    // matrix
+    // Note #1: our compute Jacobian function also computes our rates, hence we
+    //          use our first temporary vector as a scratch rates array...
+    // Note #2: for a banded matrix, we only copy the entries that are within
+    //          the band of the matrix while, for a sparse matrix, we also set
+    //          its structure since it gets reset by SUNMatZero()...
+
+    auto userData = static_cast<CvodeSolverUserData *>(pUserData);
+    double *jacobian = userData->jacobian();
+    const QVector<int> &columnStarts = userData->jacobianColumnStarts();
+    const QVector<int> &rowIndices = userData->jacobianRowIndices();
+
+    userData->computeJacobian()(pVoi, userData->constants(),
+                                N_VGetArrayPointer_Serial(pTemp1),
+                                N_VGetArrayPointer_Serial(pStates),
+                                userData->algebraic(), jacobian);
+
+    if (SUNMatGetID(pJacobian) == SUNMATRIX_SPARSE) {
+        SUNDIALS::setSparseMatrix(pJacobian, columnStarts, rowIndices, jacobian);
+
+        return 0;
+    }
+
+    SUNMatZero(pJacobian);
+
+    if (SUNMatGetID(pJacobian) == SUNMATRIX_DENSE) {
+        for (int j = 0, jMax = columnStarts.count()-1; j < jMax; ++j) {
+            for (int k = columnStarts[j], kMax = columnStarts[j+1]; k < kMax; ++k) {
+                SM_ELEMENT_D(pJacobian, rowIndices[k], j) = jacobian[k];
+            }
+        }
+    } else {
+        sunindextype upperBandwidth = SUNBandMatrix_UpperBandwidth(pJacobian);
+        sunindextype lowerBandwidth = SUNBandMatrix_LowerBandwidth(pJacobian);
+
+        for (int j = 0, jMax = columnStarts.count()-1; j < jMax; ++j) {
+            for (int k = columnStarts[j], kMax = columnStarts[j+1]; k < kMax; ++k) {
+                int i = rowIndices[k];
+
+                if ((i >= j-upperBandwidth) && (i <= j+lowerBandwidth)) {
+                    SM_ELEMENT_B(pJacobian, i, j) = jacobian[k];
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+//==============================================================================
+
+int rootFunction(double pVoi, N_Vector pStates, double *pRoots, void *pUserData)
+{
+    // Compute our root functions
+    // Note: our compute roots function also computes our rates, hence we use
+    //       our rates array as a scratch array (it gets recomputed at the end
+    //       of CvodeSolver::solve() anyway)...
+
+    auto userData = static_cast<CvodeSolverUserData *>(pUserData);
+
+    userData->computeRoots()(pVoi, userData->constants(), userData->rates(),
+                             N_VGetArrayPointer_Serial(pStates),
+                             userData->algebraic(), pRoots);
 
     return 0;
 }
@@ -77,11 +156,24 @@ void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
 
 //==============================================================================
 
-CvodeSolverUserData::CvodeSolverUserData(double *pConstants, double *pAlgebraic,
-                                         Solver::OdeSolver::ComputeRatesFunction pComputeRates) :
+CvodeSolverUserData::CvodeSolverUserData(double *pConstants, double *pRates,
+                                         double *pAlgebraic,
+                                         Solver::OdeSolver::ComputeRatesFunction pComputeRates,
+                                         Solver::OdeSolver::ComputeJacobianFunction pComputeJacobian,
+                                         const QVector<int> &pJacobianColumnStarts,
+                                         const QVector<int> &pJacobianRowIndices,
+                                         Solver::OdeSolver::ComputeRootsFunction pComputeRoots,
+                                         Solver::NlaSolver *pNlaSolver) :
     mConstants(pConstants),
+    mRates(pRates),
     mAlgebraic(pAlgebraic),
-    mComputeRates(pComputeRates)
+    mComputeRates(pComputeRates),
+    mComputeJacobian(pComputeJacobian),
+    mComputeRoots(pComputeRoots),
+    mJacobianColumnStarts(pJacobianColumnStarts),
+    mJacobianRowIndices(pJacobianRowIndices),
+    mJacobian(pJacobianRowIndices.count()),
+    mNlaSolver(pNlaSolver)
 {
 }
 
@@ -96,6 +188,15 @@ double * CvodeSolverUserData::constants() const
 
 //==============================================================================
 
+double * CvodeSolverUserData::rates() const
+{
+    // Return our rates array
+
+    return mRates;
+}
+
+//==============================================================================
+
 double * CvodeSolverUserData::algebraic() const
 {
     // Return our algebraic array
@@ -114,6 +215,60 @@ Solver::OdeSolver::ComputeRatesFunction CvodeSolverUserData::computeRates() cons
 
 //==============================================================================
 
+Solver::OdeSolver::ComputeJacobianFunction CvodeSolverUserData::computeJacobian() const
+{
+    // Return our compute Jacobian function
+
+    return mComputeJacobian;
+}
+
+//==============================================================================
+
+Solver::OdeSolver::ComputeRootsFunction CvodeSolverUserData::computeRoots() const
+{
+    // Return our compute roots function
+
+    return mComputeRoots;
+}
+
+//==============================================================================
+
+const QVector<int> & CvodeSolverUserData::jacobianColumnStarts() const
+{
+    // Return where each column of our Jacobian starts in its row indices
+
+    return mJacobianColumnStarts;
+}
+
+//==============================================================================
+
+const QVector<int> & CvodeSolverUserData::jacobianRowIndices() const
+{
+    // Return the row index of each non-zero entry of our Jacobian
+
+    return mJacobianRowIndices;
+}
+
+//==============================================================================
+
+double * CvodeSolverUserData::jacobian()
+{
+    // Return the buffer for the non-zero entries of our Jacobian
+
+    return mJacobian.data();
+}
+
+//==============================================================================
+
+Solver::NlaSolver * CvodeSolverUserData::nlaSolver() const
+{
+    // Return our NLA solver
+
+    return mNlaSolver;
+}
+
+//==============================================================================
+
 CvodeSolver::~CvodeSolver()
 {
     // Make sure that the solver has been initialised
@@ -194,6 +349,16 @@ void CvodeSolver::initialize(double pVoi, int pRatesStatesCount,
                     || (linearSolver == DiagonalLinearSolver)) {
                     // We are dealing with a dense/diagonal linear solver, so
                     // nothing more to do
+                } else if (linearSolver == SparseLinearSolver) {
+                    // We are dealing with a sparse linear solver, so we need
+                    // an analytic Jacobian since CVODES can only approximate a
+                    // dense or a banded Jacobian
+
+                    if (mComputeJacobian == nullptr) {
+                        emit error(tr("the sparse linear solver requires an analytic Jacobian, which is not available for this model"));
+
+                        return;
+                    }
                 } else if (linearSolver == BandedLinearSolver) {
                     // We are dealing with a banded linear solver, so we need
                     // both an upper and a lower half bandwidth
@@ -309,10 +474,22 @@ void CvodeSolver::initialize(double pVoi, int pRatesStatesCount,
 
     // Set our user data
 
-    mUserData = new CvodeSolverUserData(pConstants, pAlgebraic, pComputeRates);
+    mUserData = new CvodeSolverUserData(pConstants, pRates, pAlgebraic,
+                                        pComputeRates, mComputeJacobian,
+                                        mJacobianColumnStarts,
+                                        mJacobianRowIndices, mComputeRoots,
+                                        mNlaSolver);
 
     CVodeSetUserData(mSolver, mUserData);
 
+    // Set our root functions, if any, so that we can locate the
+    // discontinuities in our model exactly rather than having to use a small
+    // maximum step not to step over them
+
+    if ((mComputeRoots != nullptr) && (mRootsCount != 0)) {
+        CVodeRootInit(mSolver, mRootsCount, rootFunction);
+    }
+
     // Set our maximum step
 
     CVodeSetMaxStep(mSolver, maximumStep);
@@ -329,12 +506,28 @@ void CvodeSolver::initialize(double pVoi, int pRatesStatesCount,
             mLinearSolver = SUNLinSol_Dense(mStatesVector, mMatrix);
 
             CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+
+            if (mComputeJacobian != nullptr) {
+                CVodeSetJacFn(mSolver, jacobianFunction);
+            }
         } else if (linearSolver == BandedLinearSolver) {
             mMatrix = SUNBandMatrix(pRatesStatesCount, upperHalfBandwidth,
                                                        lowerHalfBandwidth);
             mLinearSolver = SUNLinSol_Band(mStatesVector, mMatrix);
 
             CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+
+            if (mComputeJacobian != nullptr) {
+                CVodeSetJacFn(mSolver, jacobianFunction);
+            }
+        } else if (linearSolver == SparseLinearSolver) {
+            mMatrix = SUNSparseMatrix(pRatesStatesCount, pRatesStatesCount,
+                                      mJacobianRowIndices.count()+pRatesStatesCount,
+                                      CSC_MAT);
+            mLinearSolver = SUNDIALS::sparseLinearSolver(mStatesVector, mMatrix);
+
+            CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+            CVodeSetJacFn(mSolver, jacobianFunction);
         } else if (linearSolver == DiagonalLinearSolver) {
             CVDiag(mSolver);
         } else {
@@ -389,12 +582,28 @@ void CvodeSolver::reinitialize(double pVoi)
 void CvodeSolver::solve(double &pVoi, double pVoiEnd) const
 {
     // Solve the model
+    // Note #1: if we are to interpolate our solution, then CVODES integrates
+    //          our model using its own steps, which may go past the given end
+    //          point, and interpolates its solution at the given end point
+    //          (using CVodeGetDky())...
+    // Note #2: we handle any event (i.e. a discontinuity in our rates) that we
+    //          come across by restarting our integration from it, so that we
+    //          don't have to reduce our step to get past it, and then carry on
+    //          up to the given end point. We do this here rather than let our
+    //          caller do it since solve() must always get us to the given end
+    //          point...
+
+    forever {
+        if (!mInterpolateSolution) {
+            CVodeSetStopTime(mSolver, pVoiEnd);
+        }
 
-    if (!mInterpolateSolution) {
-        CVodeSetStopTime(mSolver, pVoiEnd);
-    }
+        if (CVode(mSolver, pVoiEnd, mStatesVector, &pVoi, CV_NORMAL) != CV_ROOT_RETURN) {
+            break;
+        }
 
-    CVode(mSolver, pVoiEnd, mStatesVector, &pVoi, CV_NORMAL);
+        CVodeReInit(mSolver, pVoi, mStatesVector);
+    }
 
     // Compute the rates one more time to get up to date values for the rates
     // Note: another way of doing this would be to copy the contents of the
@@ -404,7 +613,8 @@ void CvodeSolver::solve(double &pVoi, double pVoiEnd) const
     //       transfers while here we 'only' compute the rates one more time...
 
     mComputeRates(pVoiEnd, mConstants, mRates,
-                  N_VGetArrayPointer_Serial(mStatesVector), mAlgebraic);
+                  N_VGetArrayPointer_Serial(mStatesVector), mAlgebraic,
+                  mNlaSolver);
 }
 
 //==============================================================================
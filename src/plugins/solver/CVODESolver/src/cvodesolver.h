@@ -69,6 +69,7 @@ static const auto NewtonIteration     = QStringLiteral("Newton");
 
 static const auto DenseLinearSolver    = QStringLiteral("Dense");
 static const auto BandedLinearSolver   = QStringLiteral("Banded");
+static const auto SparseLinearSolver   = QStringLiteral("Sparse");
 static const auto DiagonalLinearSolver = QStringLiteral("Diagonal");
 static const auto GmresLinearSolver    = QStringLiteral("GMRES");
 static const auto BiCgStabLinearSolver = QStringLiteral("BiCGStab");
@@ -113,19 +114,44 @@ static const bool InterpolateSolutionDefaultValue = true;
 class CvodeSolverUserData
 {
 public:
-    explicit CvodeSolverUserData(double *pConstants, double *pAlgebraic,
-                                 Solver::OdeSolver::ComputeRatesFunction pComputeRates);
+    explicit CvodeSolverUserData(double *pConstants, double *pRates,
+                                 double *pAlgebraic,
+                                 Solver::OdeSolver::ComputeRatesFunction pComputeRates,
+                                 Solver::OdeSolver::ComputeJacobianFunction pComputeJacobian,
+                                 const QVector<int> &pJacobianColumnStarts,
+                                 const QVector<int> &pJacobianRowIndices,
+                                 Solver::OdeSolver::ComputeRootsFunction pComputeRoots,
+                                 Solver::NlaSolver *pNlaSolver);
 
     double * constants() const;
+    double * rates() const;
     double * algebraic() const;
 
     Solver::OdeSolver::ComputeRatesFunction computeRates() const;
+    Solver::OdeSolver::ComputeJacobianFunction computeJacobian() const;
+    Solver::OdeSolver::ComputeRootsFunction computeRoots() const;
+
+    const QVector<int> & jacobianColumnStarts() const;
+    const QVector<int> & jacobianRowIndices() const;
+
+    double * jacobian();
+
+    Solver::NlaSolver * nlaSolver() const;
 
 private:
     double *mConstants;
+    double *mRates;
     double *mAlgebraic;
 
     Solver::OdeSolver::ComputeRatesFunction mComputeRates;
+    Solver::OdeSolver::ComputeJacobianFunction mComputeJacobian;
+    Solver::OdeSolver::ComputeRootsFunction mComputeRoots;
+
+    QVector<int> mJacobianColumnStarts;
+    QVector<int> mJacobianRowIndices;
+    QVector<double> mJacobian;
+
+    Solver::NlaSolver *mNlaSolver;
 };
 
 //==============================================================================
@@ -154,8 +180,6 @@ private:
     SUNNonlinearSolver mNonLinearSolver = nullptr;
 
     CvodeSolverUserData *mUserData = nullptr;
-
-    bool mInterpolateSolution = InterpolateSolutionDefaultValue;
 };
 
 //==============================================================================
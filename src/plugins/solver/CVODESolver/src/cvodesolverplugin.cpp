@@ -269,6 +269,7 @@ Solver::Properties CVODESolverPlugin::solverProperties() const
 
     QStringList LinearSolverListValues = { DenseLinearSolver,
                                            BandedLinearSolver,
+                                           SparseLinearSolver,
                                            DiagonalLinearSolver,
                                            GmresLinearSolver,
                                            BiCgStabLinearSolver,
@@ -307,8 +308,9 @@ QMap<QString, bool> CVODESolverPlugin::solverPropertiesVisibility(const QMap<QSt
         QString linearSolver = pSolverPropertiesValues.value(LinearSolverId);
 
         if (   (linearSolver == DenseLinearSolver)
+            || (linearSolver == SparseLinearSolver)
             || (linearSolver == DiagonalLinearSolver)) {
-            // Dense/diagonal linear solver
+            // Dense/sparse/diagonal linear solver
 
             res.insert(PreconditionerId, false);
             res.insert(UpperHalfBandwidthId, false);
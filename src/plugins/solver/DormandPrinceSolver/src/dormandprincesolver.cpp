@@ -0,0 +1,486 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Dormand-Prince solver
+//==============================================================================
+
+#include "dormandprincesolver.h"
+
+//==============================================================================
+
+#include <cfloat>
+#include <cmath>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace DormandPrinceSolver {
+
+//==============================================================================
+
+DormandPrinceSolver::~DormandPrinceSolver()
+{
+    // Delete some internal objects
+
+    delete[] mBuffer;
+}
+
+//==============================================================================
+
+void DormandPrinceSolver::initialize(double pVoi, int pRatesStatesCount,
+                                     double *pConstants, double *pRates,
+                                     double *pStates, double *pAlgebraic,
+                                     ComputeRatesFunction pComputeRates)
+{
+    // Retrieve the solver's properties
+
+    if (mProperties.contains(MaximumStepId)) {
+        mMaximumStep = mProperties.value(MaximumStepId).toDouble();
+    } else {
+        emit error(tr(R"(the "Maximum step" property value could not be retrieved)"));
+
+        return;
+    }
+
+    if (mProperties.contains(MaximumNumberOfStepsId)) {
+        mMaximumNumberOfSteps = mProperties.value(MaximumNumberOfStepsId).toInt();
+    } else {
+        emit error(tr(R"(the "Maximum number of steps" property value could not be retrieved)"));
+
+        return;
+    }
+
+    if (mProperties.contains(RelativeToleranceId)) {
+        mRelativeTolerance = mProperties.value(RelativeToleranceId).toDouble();
+    } else {
+        emit error(tr(R"(the "Relative tolerance" property value could not be retrieved)"));
+
+        return;
+    }
+
+    if (mProperties.contains(AbsoluteToleranceId)) {
+        mAbsoluteTolerance = mProperties.value(AbsoluteToleranceId).toDouble();
+    } else {
+        emit error(tr(R"(the "Absolute tolerance" property value could not be retrieved)"));
+
+        return;
+    }
+
+    // Initialise the ODE solver itself
+
+    OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
+                          pAlgebraic, pComputeRates);
+
+    // (Re)create our various arrays
+    // Note: we need our states and intermediate states, our seven stages, and
+    //       the five coefficients of our dense output...
+
+    delete[] mBuffer;
+
+    mBuffer = new double[14*pRatesStatesCount] {};
+
+    double **arrays[] = { &mY, &mYk,
+                          &mK1, &mK2, &mK3, &mK4, &mK5, &mK6, &mK7,
+                          &mR1, &mR2, &mR3, &mR4, &mR5 };
+    double *array = mBuffer;
+
+    for (auto &arrayPointer : arrays) {
+        *arrayPointer = array;
+
+        array += pRatesStatesCount;
+    }
+
+    // Initialise our internal states and let our first call to solve()
+    // estimate our initial step
+    // Note: we always integrate our model using our own steps and use our
+    //       dense output to get our solution at the requested points...
+
+    mInterpolateSolution = true;
+    mStep = 0.0;
+
+    reinitialize(pVoi);
+}
+
+//==============================================================================
+
+void DormandPrinceSolver::reinitialize(double pVoi)
+{
+    // Restart our integration from the given point and our current states
+    // Note: we keep our current step, if any, since it is likely to be a good
+    //       guess for our next step...
+
+    mVoi = pVoi;
+    mPreviousVoi = pVoi;
+    mPreviousError = 1.0e-4;
+    mNeedRates = true;
+    mHasStep = false;
+
+    memcpy(mY, mStates, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+}
+
+//==============================================================================
+
+bool DormandPrinceSolver::supportsBatch() const
+{
+    // We support solving several instances of a model in lockstep
+    // Note: our error is then the largest of the errors of our instances (see
+    //       solve()), which means that our step is controlled by the instance
+    //       that requires the smallest one...
+
+    return true;
+}
+
+//==============================================================================
+
+void DormandPrinceSolver::computeK(double pVoi, double *pK) const
+{
+    // Compute our rates for our intermediate states and keep track of them as
+    // the given stage
+
+    computeRates(pVoi, mYk);
+
+    memcpy(pK, mRates, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+}
+
+//==============================================================================
+
+double DormandPrinceSolver::initialStep() const
+{
+    // Estimate our initial step, using the algorithm described in "Solving
+    // Ordinary Differential Equations I" by E. Hairer, S.P. Nørsett and G.
+    // Wanner (Section II.4)
+
+    double dnf = 0.0;
+    double dny = 0.0;
+
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        double sk = mAbsoluteTolerance+mRelativeTolerance*std::abs(mY[i]);
+
+        dnf += (mK1[i]/sk)*(mK1[i]/sk);
+        dny += (mY[i]/sk)*(mY[i]/sk);
+    }
+
+    double res = ((dnf <= 1.0e-10) || (dny <= 1.0e-10))?
+                     1.0e-6:
+                     0.01*sqrt(dny/dnf);
+
+    if (mMaximumStep > 0.0) {
+        res = qMin(res, mMaximumStep);
+    }
+
+    // Perform an explicit Euler step and use it to estimate the second
+    // derivative of our solution
+
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mYk[i] = mY[i]+res*mK1[i];
+    }
+
+    computeK(mVoi+res, mK2);
+
+    double der2 = 0.0;
+
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        double sk = mAbsoluteTolerance+mRelativeTolerance*std::abs(mY[i]);
+
+        der2 += ((mK2[i]-mK1[i])/sk)*((mK2[i]-mK1[i])/sk);
+    }
+
+    der2 = sqrt(der2)/res;
+
+    double der12 = qMax(der2, sqrt(dnf));
+    double step = (der12 <= 1.0e-15)?
+                      qMax(1.0e-6, 1.0e-3*res):
+                      pow(0.01/der12, 0.2);
+
+    res = qMin(100.0*res, step);
+
+    if (mMaximumStep > 0.0) {
+        res = qMin(res, mMaximumStep);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+void DormandPrinceSolver::interpolate(double pVoi) const
+{
+    // Compute our states at the given point, which is within our last step,
+    // using our dense output
+
+    double theta = (pVoi-mPreviousVoi)/(mVoi-mPreviousVoi);
+    double oneMinusTheta = 1.0-theta;
+
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mStates[i] = mR1[i]+theta*(mR2[i]+oneMinusTheta*(mR3[i]+theta*(mR4[i]+oneMinusTheta*mR5[i])));
+    }
+}
+
+//==============================================================================
+
+void DormandPrinceSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // We use the Dormand-Prince 5(4) method, with a PI step size control and a
+    // fourth-order dense output, as described in "Solving Ordinary
+    // Differential Equations I" by E. Hairer, S.P. Nørsett and G. Wanner
+    // (Sections II.5 and II.6)
+    // Note #1: our last stage is evaluated at the end of our step, using our
+    //          new states, which means that it can be used as the first stage
+    //          of our next step (FSAL)...
+    // Note #2: we integrate past pVoiEnd, if needed, and then use our dense
+    //          output to compute our states at pVoiEnd. This means that our
+    //          steps are not constrained by our output points and that the
+    //          solution at the end of our last step is kept for our next
+    //          call...
+
+    static const double C2 = 1.0/5.0;
+    static const double C3 = 3.0/10.0;
+    static const double C4 = 4.0/5.0;
+    static const double C5 = 8.0/9.0;
+
+    static const double A21 = 1.0/5.0;
+    static const double A31 = 3.0/40.0;
+    static const double A32 = 9.0/40.0;
+    static const double A41 = 44.0/45.0;
+    static const double A42 = -56.0/15.0;
+    static const double A43 = 32.0/9.0;
+    static const double A51 = 19372.0/6561.0;
+    static const double A52 = -25360.0/2187.0;
+    static const double A53 = 64448.0/6561.0;
+    static const double A54 = -212.0/729.0;
+    static const double A61 = 9017.0/3168.0;
+    static const double A62 = -355.0/33.0;
+    static const double A63 = 46732.0/5247.0;
+    static const double A64 = 49.0/176.0;
+    static const double A65 = -5103.0/18656.0;
+    static const double A71 = 35.0/384.0;
+    static const double A73 = 500.0/1113.0;
+    static const double A74 = 125.0/192.0;
+    static const double A75 = -2187.0/6784.0;
+    static const double A76 = 11.0/84.0;
+
+    static const double E1 = 71.0/57600.0;
+    static const double E3 = -71.0/16695.0;
+    static const double E4 = 71.0/1920.0;
+    static const double E5 = -17253.0/339200.0;
+    static const double E6 = 22.0/525.0;
+    static const double E7 = -1.0/40.0;
+
+    static const double D1 = -12715105075.0/11282082432.0;
+    static const double D3 = 87487479700.0/32700410799.0;
+    static const double D4 = -10690763975.0/1880347072.0;
+    static const double D5 = 701980252875.0/199316789632.0;
+    static const double D6 = -1453857185.0/822651844.0;
+    static const double D7 = 69997945.0/29380423.0;
+
+    static const double Safety = 0.9;
+    static const double Beta = 0.04;
+    static const double Exponent = 0.2-0.75*Beta;
+    static const double MinimumFactor = 0.2;
+    static const double MaximumFactor = 10.0;
+
+    // Make sure that we know the rates at our current point, which is only
+    // the case if we have just been (re)initialised (since, otherwise, we
+    // know them from our last step)
+
+    if (mNeedRates) {
+        memcpy(mYk, mY, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+
+        computeK(mVoi, mK1);
+
+        mNeedRates = false;
+    }
+
+    // Estimate our initial step, if needed
+
+    if (mStep <= 0.0) {
+        mStep = initialStep();
+    }
+
+    // Step until we reach or go past pVoiEnd
+
+    int numberOfSteps = 0;
+    bool rejected = false;
+
+    while ((mVoi < pVoiEnd) && !qFuzzyCompare(mVoi, pVoiEnd)) {
+        // Make sure that we haven't taken too many steps
+
+        if (++numberOfSteps > mMaximumNumberOfSteps) {
+            const_cast<DormandPrinceSolver *>(this)->emitError(tr("the maximum number of steps was reached"));
+
+            return;
+        }
+
+        // Determine our step and make sure that it is not too small
+
+        double step = (mMaximumStep > 0.0)?
+                          qMin(mStep, mMaximumStep):
+                          mStep;
+
+        if (0.1*step <= std::abs(mVoi)*DBL_EPSILON) {
+            const_cast<DormandPrinceSolver *>(this)->emitError(tr("the step became too small"));
+
+            return;
+        }
+
+        // Compute our different stages
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*A21*mK1[i];
+        }
+
+        computeK(mVoi+C2*step, mK2);
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*(A31*mK1[i]+A32*mK2[i]);
+        }
+
+        computeK(mVoi+C3*step, mK3);
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*(A41*mK1[i]+A42*mK2[i]+A43*mK3[i]);
+        }
+
+        computeK(mVoi+C4*step, mK4);
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*(A51*mK1[i]+A52*mK2[i]+A53*mK3[i]+A54*mK4[i]);
+        }
+
+        computeK(mVoi+C5*step, mK5);
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*(A61*mK1[i]+A62*mK2[i]+A63*mK3[i]+A64*mK4[i]+A65*mK5[i]);
+        }
+
+        computeK(mVoi+step, mK6);
+
+        // Compute our new states and the rates at the end of our step
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mYk[i] = mY[i]+step*(A71*mK1[i]+A73*mK3[i]+A74*mK4[i]+A75*mK5[i]+A76*mK6[i]);
+        }
+
+        computeK(mVoi+step, mK7);
+
+        // Estimate our local error, using the difference between our fifth-
+        // and fourth-order solutions
+        // Note: if we are solving several instances of a model in lockstep,
+        //       then we compute the RMS norm of the error of each instance and
+        //       use the largest one. Indeed, pooling the errors of all our
+        //       instances would dilute the error of an instance that requires a
+        //       small step (e.g. a stiff one) by the (small) errors of the
+        //       other instances. Also, our arrays use a structure-of-arrays
+        //       layout, hence the values of a given instance are
+        //       instancesCount values apart...
+
+        int instancesCount = qMax(mBatchCount, 1);
+        int instanceRatesStatesCount = mRatesStatesCount/instancesCount;
+        double error = 0.0;
+
+        for (int j = 0; j < instancesCount; ++j) {
+            double instanceError = 0.0;
+
+            for (int i = j; i < mRatesStatesCount; i += instancesCount) {
+                double sk = mAbsoluteTolerance+mRelativeTolerance*qMax(std::abs(mY[i]), std::abs(mYk[i]));
+                double localError = step*(E1*mK1[i]+E3*mK3[i]+E4*mK4[i]+E5*mK5[i]+E6*mK6[i]+E7*mK7[i])/sk;
+
+                instanceError += localError*localError;
+            }
+
+            instanceError = sqrt(instanceError/instanceRatesStatesCount);
+
+            if (std::isnan(instanceError) || (instanceError > error)) {
+                error = instanceError;
+
+                if (std::isnan(error)) {
+                    break;
+                }
+            }
+        }
+
+        // Determine our next step and accept or reject our current one
+        // Note: if our error is not a number, then we reject our current step
+        //       and try again with a much smaller one...
+
+        double factor = pow(error, Exponent);
+
+        if (std::isnan(error)) {
+            mStep = MinimumFactor*step;
+
+            rejected = true;
+        } else if (error <= 1.0) {
+            // Our step is accepted, so compute the coefficients of our dense
+            // output and move on
+
+            for (int i = 0; i < mRatesStatesCount; ++i) {
+                double yDifference = mYk[i]-mY[i];
+                double bSpline = step*mK1[i]-yDifference;
+
+                mR1[i] = mY[i];
+                mR2[i] = yDifference;
+                mR3[i] = bSpline;
+                mR4[i] = yDifference-step*mK7[i]-bSpline;
+                mR5[i] = step*(D1*mK1[i]+D3*mK3[i]+D4*mK4[i]+D5*mK5[i]+D6*mK6[i]+D7*mK7[i]);
+            }
+
+            memcpy(mY, mYk, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+            memcpy(mK1, mK7, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+
+            mPreviousVoi = mVoi;
+            mVoi += step;
+            mHasStep = true;
+
+            double newStep = step/qMax(1.0/MaximumFactor,
+                                       qMin(1.0/MinimumFactor,
+                                            factor/pow(mPreviousError, Beta)/Safety));
+
+            mStep = rejected?
+                        qMin(newStep, step):
+                        newStep;
+            mPreviousError = qMax(error, 1.0e-4);
+
+            rejected = false;
+        } else {
+            mStep = step/qMin(1.0/MinimumFactor, factor/Safety);
+
+            rejected = true;
+        }
+    }
+
+    // Compute our states at pVoiEnd, using our dense output, if possible
+
+    if (mHasStep) {
+        interpolate(pVoiEnd);
+    } else {
+        memcpy(mStates, mY, size_t(mRatesStatesCount)*OpenCOR::Solver::SizeOfDouble);
+    }
+
+    pVoi = pVoiEnd;
+}
+
+//==============================================================================
+
+} // namespace DormandPrinceSolver
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
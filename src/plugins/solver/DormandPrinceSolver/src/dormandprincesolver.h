@@ -0,0 +1,120 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Dormand-Prince solver
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "solverinterface.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace DormandPrinceSolver {
+
+//==============================================================================
+
+static const auto MaximumStepId          = QStringLiteral("MaximumStep");
+static const auto MaximumNumberOfStepsId = QStringLiteral("MaximumNumberOfSteps");
+static const auto RelativeToleranceId    = QStringLiteral("RelativeTolerance");
+static const auto AbsoluteToleranceId    = QStringLiteral("AbsoluteTolerance");
+
+//==============================================================================
+
+// Default Dormand-Prince parameter values
+// Note #1: a maximum step of 0 means that there is no maximum step as such and
+//          that we can use whatever step we see fit...
+// Note #2: an explicit method may need quite a few steps between two output
+//          points, hence our default maximum number of steps is bigger than
+//          that of CVODES...
+
+static const double MaximumStepDefaultValue = 0.0;
+
+enum {
+    MaximumNumberOfStepsDefaultValue = 10000
+};
+
+static const double RelativeToleranceDefaultValue = 1.0e-7;
+static const double AbsoluteToleranceDefaultValue = 1.0e-7;
+
+//==============================================================================
+
+class DormandPrinceSolver : public OpenCOR::Solver::OdeSolver
+{
+    Q_OBJECT
+
+public:
+    ~DormandPrinceSolver() override;
+
+    void initialize(double pVoi, int pRatesStatesCount, double *pConstants,
+                    double *pRates, double *pStates, double *pAlgebraic,
+                    ComputeRatesFunction pComputeRates) override;
+    void reinitialize(double pVoi) override;
+
+    bool supportsBatch() const override;
+
+    void solve(double &pVoi, double pVoiEnd) const override;
+
+private:
+    double mMaximumStep = MaximumStepDefaultValue;
+    int mMaximumNumberOfSteps = MaximumNumberOfStepsDefaultValue;
+    double mRelativeTolerance = RelativeToleranceDefaultValue;
+    double mAbsoluteTolerance = AbsoluteToleranceDefaultValue;
+
+    mutable double mVoi = 0.0;
+    mutable double mPreviousVoi = 0.0;
+    mutable double mStep = 0.0;
+    mutable double mPreviousError = 1.0e-4;
+    mutable bool mNeedRates = true;
+    mutable bool mHasStep = false;
+
+    double *mBuffer = nullptr;
+
+    double *mY = nullptr;
+    double *mYk = nullptr;
+    double *mK1 = nullptr;
+    double *mK2 = nullptr;
+    double *mK3 = nullptr;
+    double *mK4 = nullptr;
+    double *mK5 = nullptr;
+    double *mK6 = nullptr;
+    double *mK7 = nullptr;
+    double *mR1 = nullptr;
+    double *mR2 = nullptr;
+    double *mR3 = nullptr;
+    double *mR4 = nullptr;
+    double *mR5 = nullptr;
+
+    void computeK(double pVoi, double *pK) const;
+    double initialStep() const;
+    void interpolate(double pVoi) const;
+};
+
+//==============================================================================
+
+} // namespace DormandPrinceSolver
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,169 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Dormand-Prince solver tests
+//==============================================================================
+
+#include "dormandprincesolver.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+#include <cmath>
+
+//==============================================================================
+
+static const double OutputPointInterval = 0.05;
+static const int    OutputPointsCount   = 20;
+static const double Tolerance           = 1.0e-5;
+
+//==============================================================================
+
+static OpenCOR::Solver::Solver::Properties properties()
+{
+    // Return the properties to be used by our solver
+
+    OpenCOR::Solver::Solver::Properties res;
+
+    res.insert(OpenCOR::DormandPrinceSolver::MaximumStepId, 0.0);
+    res.insert(OpenCOR::DormandPrinceSolver::MaximumNumberOfStepsId, 100000);
+    res.insert(OpenCOR::DormandPrinceSolver::RelativeToleranceId, 1.0e-9);
+    res.insert(OpenCOR::DormandPrinceSolver::AbsoluteToleranceId, 1.0e-9);
+
+    return res;
+}
+
+//==============================================================================
+
+static void computeRates(double pVoi, double *pConstants, double *pRates,
+                         double *pStates, double *pAlgebraic, void *pNlaSolver)
+{
+    Q_UNUSED(pVoi)
+    Q_UNUSED(pAlgebraic)
+    Q_UNUSED(pNlaSolver)
+
+    // Harmonic oscillator, i.e. y'' = -w^2*y, with w as our only constant
+
+    pRates[0] = pStates[1];
+    pRates[1] = -pConstants[0]*pConstants[0]*pStates[0];
+}
+
+//==============================================================================
+
+static void computeRatesBatch(int pCount, double pVoi, double *pConstants,
+                              double *pRates, double *pStates,
+                              double *pAlgebraic)
+{
+    Q_UNUSED(pVoi)
+    Q_UNUSED(pAlgebraic)
+
+    // Harmonic oscillator for several instances, using a structure-of-arrays
+    // layout
+
+    for (int i = 0; i < pCount; ++i) {
+        pRates[i] = pStates[pCount+i];
+        pRates[pCount+i] = -pConstants[i]*pConstants[i]*pStates[i];
+    }
+}
+
+//==============================================================================
+
+void Tests::analyticTests()
+{
+    // Solve a harmonic oscillator, i.e. y'' = -y with y(0) = 1 and y'(0) = 0,
+    // and check our solution against its analytic solution, i.e. y = cos(t)
+    // and y' = -sin(t)
+
+    OpenCOR::DormandPrinceSolver::DormandPrinceSolver solver;
+    QSignalSpy errorSpy(&solver, &OpenCOR::Solver::Solver::error);
+    double constants[] = { 1.0 };
+    double rates[] = { 0.0, 0.0 };
+    double states[] = { 1.0, 0.0 };
+    double voi = 0.0;
+
+    solver.setProperties(properties());
+    solver.initialize(voi, 2, constants, rates, states, nullptr, computeRates);
+
+    for (int i = 1; i <= OutputPointsCount; ++i) {
+        solver.solve(voi, i*OutputPointInterval);
+
+        QCOMPARE(errorSpy.count(), 0);
+        QVERIFY(std::abs(states[0]-cos(voi)) < Tolerance);
+        QVERIFY(std::abs(states[1]+sin(voi)) < Tolerance);
+    }
+}
+
+//==============================================================================
+
+void Tests::batchTests()
+{
+    // Solve several harmonic oscillators in lockstep, one of which oscillates
+    // much faster than the others (and therefore requires a much smaller
+    // step), and check our solution for each of them against its analytic
+    // solution
+    // Note: the error of our fast oscillator must not be diluted by that of
+    //       our other oscillators...
+
+    static const int Count = 8;
+
+    OpenCOR::DormandPrinceSolver::DormandPrinceSolver solver;
+    QSignalSpy errorSpy(&solver, &OpenCOR::Solver::Solver::error);
+    double constants[Count];
+    double rates[2*Count];
+    double states[2*Count];
+    double voi = 0.0;
+
+    for (int i = 0; i < Count; ++i) {
+        constants[i] = (i == Count-1)?50.0:1.0;
+        rates[i] = rates[Count+i] = 0.0;
+        states[i] = 1.0;
+        states[Count+i] = 0.0;
+    }
+
+    solver.setProperties(properties());
+    solver.initializeBatch(voi, 2, Count, constants, rates, states, nullptr,
+                           computeRatesBatch);
+
+    for (int i = 1; i <= OutputPointsCount; ++i) {
+        solver.solve(voi, i*OutputPointInterval);
+
+        QCOMPARE(errorSpy.count(), 0);
+
+        for (int j = 0; j < Count; ++j) {
+            double w = constants[j];
+
+            QVERIFY(std::abs(states[j]-cos(w*voi)) < Tolerance);
+            QVERIFY(std::abs(states[Count+j]+w*sin(w*voi)) < w*Tolerance);
+        }
+    }
+}
+
+//==============================================================================
+
+QTEST_APPLESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -45,6 +45,14 @@ void ForwardEulerSolver::initialize(double pVoi, int pRatesStatesCount,
         return;
     }
 
+    if (mProperties.contains(InterpolateSolutionId)) {
+        mInterpolateSolution = mProperties.value(InterpolateSolutionId).toBool();
+    } else {
+        emit error(tr(R"(the "Interpolate solution" property value could not be retrieved)"));
+
+        return;
+    }
+
     // Initialise the ODE solver itself
 
     OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
@@ -53,39 +61,36 @@ void ForwardEulerSolver::initialize(double pVoi, int pRatesStatesCount,
 
 //==============================================================================
 
-void ForwardEulerSolver::solve(double &pVoi, double pVoiEnd) const
+bool ForwardEulerSolver::supportsBatch() const
 {
-    // Y_n+1 = Y_n + h * f(t_n, Y_n)
+    // We support solving several instances of a model in lockstep
 
-    double voiStart = pVoi;
+    return true;
+}
 
-    int stepNumber = 0;
-    double realStep = mStep;
+//==============================================================================
 
-    while (!qFuzzyCompare(pVoi, pVoiEnd)) {
-        // Check that the time step is correct
+void ForwardEulerSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // Solve our model using our fixed step
 
-        if (pVoi+realStep > pVoiEnd) {
-            realStep = pVoiEnd-pVoi;
-        }
+    solveWithFixedStep(pVoi, pVoiEnd, mStep);
+}
 
-        // Compute f(t_n, Y_n)
+//==============================================================================
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+void ForwardEulerSolver::step(double pVoi, double pStep) const
+{
+    // Y_n+1 = Y_n + h * f(t_n, Y_n)
 
-        // Compute Y_n+1
+    // Compute f(t_n, Y_n)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mStates[i] += realStep*mRates[i];
-        }
+    computeRates(pVoi, mStates);
 
-        // Advance through time
+    // Compute Y_n+1
 
-        if (!qFuzzyCompare(realStep, mStep)) {
-            pVoi = pVoiEnd;
-        } else {
-            pVoi = voiStart+(++stepNumber)*mStep;
-        }
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mStates[i] += pStep*mRates[i];
     }
 }
 
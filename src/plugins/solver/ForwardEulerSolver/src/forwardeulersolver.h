@@ -34,12 +34,15 @@ namespace ForwardEulerSolver {
 
 //==============================================================================
 
-static const auto StepId = QStringLiteral("Step");
+static const auto StepId                = QStringLiteral("Step");
+static const auto InterpolateSolutionId = QStringLiteral("InterpolateSolution");
 
 //==============================================================================
 
 static const double StepDefaultValue = 1.0;
 
+static const bool InterpolateSolutionDefaultValue = false;
+
 //==============================================================================
 
 class ForwardEulerSolver : public OpenCOR::Solver::OdeSolver
@@ -51,8 +54,13 @@ public:
                     double *pRates, double *pStates, double *pAlgebraic,
                     ComputeRatesFunction pComputeRates) override;
 
+    bool supportsBatch() const override;
+
     void solve(double &pVoi, double pVoiEnd) const override;
 
+protected:
+    void step(double pVoi, double pStep) const override;
+
 private:
     double mStep = StepDefaultValue;
 };
@@ -57,6 +57,14 @@ void FourthOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
         return;
     }
 
+    if (mProperties.contains(InterpolateSolutionId)) {
+        mInterpolateSolution = mProperties.value(InterpolateSolutionId).toBool();
+    } else {
+        emit error(tr(R"(the "Interpolate solution" property value could not be retrieved)"));
+
+        return;
+    }
+
     // Initialise the ODE solver itself
 
     OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
@@ -75,7 +83,25 @@ void FourthOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
 
 //==============================================================================
 
+bool FourthOrderRungeKuttaSolver::supportsBatch() const
+{
+    // We support solving several instances of a model in lockstep
+
+    return true;
+}
+
+//==============================================================================
+
 void FourthOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // Solve our model using our fixed step
+
+    solveWithFixedStep(pVoi, pVoiEnd, mStep);
+}
+
+//==============================================================================
+
+void FourthOrderRungeKuttaSolver::step(double pVoi, double pStep) const
 {
     // k1 = h * f(t_n, Y_n)
     // k2 = h * f(t_n + h / 2, Y_n + k1 / 2)
@@ -89,70 +115,49 @@ void FourthOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
     static const double OneOverThree = 1.0/3.0;
     static const double OneOverSix   = 1.0/6.0;
 
-    double voiStart = pVoi;
-
-    int stepNumber = 0;
-    double realStep = mStep;
-    double realHalfStep = 0.5*realStep;
-
-    while (!qFuzzyCompare(pVoi, pVoiEnd)) {
-        // Check that the time step is correct
+    double halfStep = 0.5*pStep;
 
-        if (pVoi+realStep > pVoiEnd) {
-            realStep = pVoiEnd-pVoi;
-            realHalfStep = 0.5*realStep;
-        }
+    // Compute f(t_n, Y_n)
 
-        // Compute f(t_n, Y_n)
+    computeRates(pVoi, mStates);
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+    // Compute k1 and Yk1
 
-        // Compute k1 and Yk1
-
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mK1[i] = mRates[i];
-            mYk123[i] = mStates[i]+realHalfStep*mK1[i];
-        }
-
-        // Compute f(t_n + h / 2, Y_n + k1 / 2)
-
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk123, mAlgebraic);
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mK1[i] = mRates[i];
+        mYk123[i] = mStates[i]+halfStep*mK1[i];
+    }
 
-        // Compute k2 and Yk2
+    // Compute f(t_n + h / 2, Y_n + k1 / 2)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mK23[i] = mRates[i];
-            mYk123[i] = mStates[i]+realHalfStep*mK23[i];
-        }
+    computeRates(pVoi+halfStep, mYk123);
 
-        // Compute f(t_n + h / 2, Y_n + k2 / 2)
+    // Compute k2 and Yk2
 
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk123, mAlgebraic);
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mK23[i] = mRates[i];
+        mYk123[i] = mStates[i]+halfStep*mK23[i];
+    }
 
-        // Compute k3 and Yk3
+    // Compute f(t_n + h / 2, Y_n + k2 / 2)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mK23[i] += mRates[i];
-            mYk123[i] = mStates[i]+realStep*mK23[i];
-        }
+    computeRates(pVoi+halfStep, mYk123);
 
-        // Compute f(t_n + h, Y_n + k3)
+    // Compute k3 and Yk3
 
-        mComputeRates(pVoi+realStep, mConstants, mRates, mYk123, mAlgebraic);
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mK23[i] += mRates[i];
+        mYk123[i] = mStates[i]+pStep*mK23[i];
+    }
 
-        // Compute k4 and therefore Y_n+1
+    // Compute f(t_n + h, Y_n + k3)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mStates[i] += realStep*(OneOverSix*(mK1[i]+mRates[i])+OneOverThree*mK23[i]);
-        }
+    computeRates(pVoi+pStep, mYk123);
 
-        // Advance through time
+    // Compute k4 and therefore Y_n+1
 
-        if (!qFuzzyCompare(realStep, mStep)) {
-            pVoi = pVoiEnd;
-        } else {
-            pVoi = voiStart+(++stepNumber)*mStep;
-        }
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mStates[i] += pStep*(OneOverSix*(mK1[i]+mRates[i])+OneOverThree*mK23[i]);
     }
 }
 
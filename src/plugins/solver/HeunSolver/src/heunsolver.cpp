@@ -55,6 +55,14 @@ void HeunSolver::initialize(double pVoi, int pRatesStatesCount,
         return;
     }
 
+    if (mProperties.contains(InterpolateSolutionId)) {
+        mInterpolateSolution = mProperties.value(InterpolateSolutionId).toBool();
+    } else {
+        emit error(tr(R"(the "Interpolate solution" property value could not be retrieved)"));
+
+        return;
+    }
+
     // Initialise the ODE solver itself
 
     OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
@@ -71,53 +79,50 @@ void HeunSolver::initialize(double pVoi, int pRatesStatesCount,
 
 //==============================================================================
 
-void HeunSolver::solve(double &pVoi, double pVoiEnd) const
+bool HeunSolver::supportsBatch() const
 {
-    // k = h * f(t_n, Y_n)
-    // Y_n+1 = Y_n + h / 2 * ( f(t_n, Y_n) + f(t_n + h, Y_n + k) )
+    // We support solving several instances of a model in lockstep
 
-    double voiStart = pVoi;
+    return true;
+}
 
-    int stepNumber = 0;
-    double realStep = mStep;
-    double realHalfStep = 0.5*realStep;
+//==============================================================================
 
-    while (!qFuzzyCompare(pVoi, pVoiEnd)) {
-        // Check that the time step is correct
+void HeunSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // Solve our model using our fixed step
 
-        if (pVoi+realStep > pVoiEnd) {
-            realStep = pVoiEnd-pVoi;
-            realHalfStep = 0.5*realStep;
-        }
+    solveWithFixedStep(pVoi, pVoiEnd, mStep);
+}
 
-        // Compute f(t_n, Y_n)
+//==============================================================================
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+void HeunSolver::step(double pVoi, double pStep) const
+{
+    // k = h * f(t_n, Y_n)
+    // Y_n+1 = Y_n + h / 2 * ( f(t_n, Y_n) + f(t_n + h, Y_n + k) )
 
-        // Compute k and Yk
+    double halfStep = 0.5*pStep;
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mK[i] = mRates[i];
-            mYk[i] = mStates[i]+realStep*mRates[i];
-        }
+    // Compute f(t_n, Y_n)
 
-        // Compute f(t_n + h, Y_n + k)
+    computeRates(pVoi, mStates);
 
-        mComputeRates(pVoi+realStep, mConstants, mRates, mYk, mAlgebraic);
+    // Compute k and Yk
+
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mK[i] = mRates[i];
+        mYk[i] = mStates[i]+pStep*mRates[i];
+    }
 
-        // Compute Y_n+1
+    // Compute f(t_n + h, Y_n + k)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mStates[i] += realHalfStep*(mK[i]+mRates[i]);
-        }
+    computeRates(pVoi+pStep, mYk);
 
-        // Advance through time
+    // Compute Y_n+1
 
-        if (!qFuzzyCompare(realStep, mStep)) {
-            pVoi = pVoiEnd;
-        } else {
-            pVoi = voiStart+(++stepNumber)*mStep;
-        }
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mStates[i] += halfStep*(mK[i]+mRates[i]);
     }
 }
 
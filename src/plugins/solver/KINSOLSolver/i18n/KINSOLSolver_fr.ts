@@ -23,6 +23,10 @@
         <source>the &quot;Lower half-bandwidth&quot; property value could not be retrieved</source>
         <translation>la valeur de la propriété &quot;Demi largeur de bande inférieure&quot; n&apos;a pas pu être retrouvée</translation>
     </message>
+    <message>
+        <source>the sparse linear solver requires an analytic Jacobian, which is not available for this model</source>
+        <translation>le solveur linéaire creux requiert un jacobien analytique, qui n&apos;est pas disponible pour ce modèle</translation>
+    </message>
     <message>
         <source>the &quot;Linear solver&quot; property value could not be retrieved</source>
         <translation>la valeur de la propriété &quot;Solveur linéaire&quot; n&apos;a pas pu être retrouvée</translation>
@@ -22,6 +22,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include "kinsolsolver.h"
+#include "sparselinearsolver.h"
 
 //==============================================================================
 
@@ -68,6 +69,119 @@ int systemFunction(N_Vector pY, N_Vector pF, void *pUserData)
 
 //==============================================================================
 
+static bool setSparseJacobian(SUNMatrix pMatrix, const double *pJacobian,
+                              const QVector<int> &pColumnStarts,
+                              const QVector<int> &pRowIndices)
+{
+    // Set the given sparse matrix using the given dense Jacobian, which is
+    // stored in column-major order, and sparsity pattern, and return whether
+    // all the non-zero entries of the Jacobian are part of that pattern
+
+    int size = pColumnStarts.count()-1;
+    sunindextype *columnStarts = SUNSparseMatrix_IndexPointers(pMatrix);
+    sunindextype *rowIndices = SUNSparseMatrix_IndexValues(pMatrix);
+    double *values = SUNSparseMatrix_Data(pMatrix);
+
+    for (int j = 0; j < size; ++j) {
+        const double *column = pJacobian+j*size;
+        int i = 0;
+
+        columnStarts[j] = pColumnStarts[j];
+
+        for (int k = pColumnStarts[j], kMax = pColumnStarts[j+1]; k < kMax; ++k) {
+            int row = pRowIndices[k];
+
+            for (; i < row; ++i) {
+                if (!qIsNull(column[i])) {
+                    return false;
+                }
+            }
+
+            rowIndices[k] = row;
+            values[k] = column[row];
+
+            ++i;
+        }
+
+        for (; i < size; ++i) {
+            if (!qIsNull(column[i])) {
+                return false;
+            }
+        }
+    }
+
+    columnStarts[size] = pColumnStarts[size];
+
+    return true;
+}
+
+//==============================================================================
+
+int jacobianFunction(N_Vector pY, N_Vector pF, SUNMatrix pJacobian,
+                     void *pUserData, N_Vector pTemp1, N_Vector pTemp2)
+{
+    Q_UNUSED(pF)
+    Q_UNUSED(pTemp1)
+    Q_UNUSED(pTemp2)
+
+    // Compute the Jacobian of our system
+    // Note: our Jacobian function computes a dense matrix in column-major
+    //       order, which is how a dense SUNDIALS matrix stores its data, so we
+    //       can compute our Jacobian straight into it. For a sparse/banded
+    //       matrix, we compute our Jacobian into a buffer and then copy the
+    //       entries that are part of our sparsity pattern/within the band of
+    //       the matrix. Our sparsity pattern was determined when we were
+    //       created (see KinsolSolver::solve()), but an entry that was zero
+    //       then may not be zero anymore, in which case we update our sparsity
+    //       pattern and reallocate our matrix accordingly...
+
+    auto userData = static_cast<KinsolSolverUserData *>(pUserData);
+
+    if (SUNMatGetID(pJacobian) == SUNMATRIX_DENSE) {
+        userData->computeSystemJacobian()(N_VGetArrayPointer_Serial(pY),
+                                          SUNDenseMatrix_Data(pJacobian),
+                                          userData->userData());
+    } else if (SUNMatGetID(pJacobian) == SUNMATRIX_SPARSE) {
+        double *jacobian = userData->jacobian();
+
+        userData->computeSystemJacobian()(N_VGetArrayPointer_Serial(pY),
+                                          jacobian, userData->userData());
+
+        if (!setSparseJacobian(pJacobian, jacobian,
+                               userData->jacobianColumnStarts(),
+                               userData->jacobianRowIndices())) {
+            userData->updateJacobianSparsityPattern(int(SUNSparseMatrix_Columns(pJacobian)));
+
+            SUNSparseMatrix_Reallocate(pJacobian, userData->jacobianRowIndices().count());
+
+            setSparseJacobian(pJacobian, jacobian,
+                              userData->jacobianColumnStarts(),
+                              userData->jacobianRowIndices());
+        }
+    } else {
+        double *jacobian = userData->jacobian();
+        sunindextype size = SUNBandMatrix_Columns(pJacobian);
+        sunindextype upperBandwidth = SUNBandMatrix_UpperBandwidth(pJacobian);
+        sunindextype lowerBandwidth = SUNBandMatrix_LowerBandwidth(pJacobian);
+
+        userData->computeSystemJacobian()(N_VGetArrayPointer_Serial(pY),
+                                          jacobian, userData->userData());
+
+        for (sunindextype j = 0; j < size; ++j) {
+            double *column = SUNBandMatrix_Column(pJacobian, j);
+
+            for (sunindextype i = qMax(sunindextype(0), j-upperBandwidth),
+                              iMax = qMin(size-1, j+lowerBandwidth); i <= iMax; ++i) {
+                SM_COLUMN_ELEMENT_B(column, i, j) = jacobian[j*size+i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+//==============================================================================
+
 void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
                   char *pErrorMessage, void *pUserData)
 {
@@ -84,8 +198,11 @@ void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
 //==============================================================================
 
 KinsolSolverUserData::KinsolSolverUserData(Solver::NlaSolver::ComputeSystemFunction pComputeSystem,
-                                           void *pUserData) :
+                                           Solver::NlaSolver::ComputeSystemJacobianFunction pComputeSystemJacobian,
+                                           double *pJacobian, void *pUserData) :
     mComputeSystem(pComputeSystem),
+    mComputeSystemJacobian(pComputeSystemJacobian),
+    mJacobian(pJacobian),
     mUserData(pUserData)
 {
 }
@@ -101,6 +218,81 @@ Solver::NlaSolver::ComputeSystemFunction KinsolSolverUserData::computeSystem() c
 
 //==============================================================================
 
+Solver::NlaSolver::ComputeSystemJacobianFunction KinsolSolverUserData::computeSystemJacobian() const
+{
+    // Return our compute system Jacobian function
+
+    return mComputeSystemJacobian;
+}
+
+//==============================================================================
+
+double * KinsolSolverUserData::jacobian() const
+{
+    // Return our Jacobian buffer
+
+    return mJacobian;
+}
+
+//==============================================================================
+
+QVector<int> KinsolSolverUserData::jacobianColumnStarts() const
+{
+    // Return where each column of our Jacobian starts in its row indices
+
+    return mJacobianColumnStarts;
+}
+
+//==============================================================================
+
+QVector<int> KinsolSolverUserData::jacobianRowIndices() const
+{
+    // Return the row index of each entry of our Jacobian's sparsity pattern
+
+    return mJacobianRowIndices;
+}
+
+//==============================================================================
+
+void KinsolSolverUserData::updateJacobianSparsityPattern(int pSize)
+{
+    // Update the sparsity pattern of our Jacobian, in compressed sparse column
+    // format, so that it includes the non-zero entries of our Jacobian buffer
+    // Note: the diagonal entries are always part of our sparsity pattern since
+    //       they are needed by our sparse linear solver...
+
+    QVector<int> columnStarts(pSize+1);
+    QVector<int> rowIndices;
+    bool hasPattern = !mJacobianColumnStarts.isEmpty();
+
+    for (int j = 0; j < pSize; ++j) {
+        const double *column = mJacobian+j*pSize;
+        int k = hasPattern?mJacobianColumnStarts[j]:0;
+        int kMax = hasPattern?mJacobianColumnStarts[j+1]:0;
+
+        columnStarts[j] = rowIndices.count();
+
+        for (int i = 0; i < pSize; ++i) {
+            bool inPattern = (k < kMax) && (mJacobianRowIndices[k] == i);
+
+            if (inPattern) {
+                ++k;
+            }
+
+            if (inPattern || (i == j) || !qIsNull(column[i])) {
+                rowIndices << i;
+            }
+        }
+    }
+
+    columnStarts[pSize] = rowIndices.count();
+
+    mJacobianColumnStarts = columnStarts;
+    mJacobianRowIndices = rowIndices;
+}
+
+//==============================================================================
+
 void * KinsolSolverUserData::userData() const
 {
     // Return our user data
@@ -110,15 +302,26 @@ void * KinsolSolverUserData::userData() const
 
 //==============================================================================
 
+void KinsolSolverUserData::setUserData(void *pUserData)
+{
+    // Set our user data
+
+    mUserData = pUserData;
+}
+
+//==============================================================================
+
 KinsolSolverData::KinsolSolverData(void *pSolver, N_Vector pParametersVector,
                                    N_Vector pOnesVector, SUNMatrix pMatrix,
                                    SUNLinearSolver pLinearSolver,
+                                   double *pJacobian,
                                    KinsolSolverUserData *pUserData) :
     mSolver(pSolver),
     mParametersVector(pParametersVector),
     mOnesVector(pOnesVector),
     mMatrix(pMatrix),
     mLinearSolver(pLinearSolver),
+    mJacobian(pJacobian),
     mUserData(pUserData)
 {
 }
@@ -136,6 +339,7 @@ KinsolSolverData::~KinsolSolverData()
 
     KINFree(&mSolver);
 
+    delete[] mJacobian;
     delete mUserData;
 }
 
@@ -168,22 +372,20 @@ N_Vector KinsolSolverData::onesVector() const
 
 //==============================================================================
 
-KinsolSolverUserData * KinsolSolverData::userData() const
+double * KinsolSolverData::jacobian() const
 {
-    // Return our user data
+    // Return our Jacobian buffer
 
-    return mUserData;
+    return mJacobian;
 }
 
 //==============================================================================
 
-void KinsolSolverData::setUserData(KinsolSolverUserData *pUserData)
+KinsolSolverUserData * KinsolSolverData::userData() const
 {
-    // Set our user data, after having delete our 'old' ones
-
-    delete mUserData;
+    // Return our user data
 
-    mUserData = pUserData;
+    return mUserData;
 }
 
 //==============================================================================
@@ -200,11 +402,18 @@ KinsolSolver::~KinsolSolver()
 //==============================================================================
 
 void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
+                         ComputeSystemJacobianFunction pComputeSystemJacobian,
                          double *pParameters, int pSize, void *pUserData)
 {
     // Check whether we need to initialise or update ourselves
+    // Note: a model usually solves the same NLA system (or a couple of them)
+    //       over and over again, so we first check whether we are dealing with
+    //       the same NLA system as last time, in which case we can avoid
+    //       looking it up...
 
-    KinsolSolverData *data = mData.value(reinterpret_cast<void *>(pComputeSystem));
+    KinsolSolverData *data = (pComputeSystem == mLastComputeSystem)?
+                                 mLastData:
+                                 mData.value(reinterpret_cast<void *>(pComputeSystem));
 
     if (data == nullptr) {
         // Retrieve our properties
@@ -253,6 +462,15 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
 
                     return;
                 }
+            } else if (   (linearSolverValue == SparseLinearSolver)
+                       && (pComputeSystemJacobian == nullptr)) {
+                // We are dealing with a sparse linear solver, but KINSOL can
+                // only approximate a dense or a banded Jacobian, so we need an
+                // analytic Jacobian, as for CVODES
+
+                emit error(tr("the sparse linear solver requires an analytic Jacobian, which is not available for this model"));
+
+                return;
             }
         } else {
             emit error(tr(R"(the "Linear solver" property value could not be retrieved)"));
@@ -261,10 +479,19 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
         }
 
         // Create some vectors
-
-        N_Vector parametersVector = N_VMake_Serial(pSize, pParameters);
+        // Note: our parameters vector has its own data, which is initialised
+        //       with the initial guess we were given and which, after each
+        //       solve, holds the solution of our NLA system. That solution is
+        //       then used as the initial guess for our next solve, which means
+        //       that the model code doesn't have to keep track of it itself
+        //       (and, therefore, that two instances of the model don't share
+        //       it)...
+
+        N_Vector parametersVector = N_VNew_Serial(pSize);
         N_Vector onesVector = N_VNew_Serial(pSize);
 
+        memcpy(N_VGetArrayPointer_Serial(parametersVector), pParameters, size_t(pSize)*OpenCOR::Solver::SizeOfDouble);
+
         N_VConst(1.0, onesVector);
 
         // Create our KINSOL solver
@@ -280,8 +507,18 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
         KINInit(solver, systemFunction, parametersVector);
 
         // Set our user data
-
-        auto userData = new KinsolSolverUserData(pComputeSystem, pUserData);
+        // Note: we need a Jacobian buffer only if we have a Jacobian function
+        //       and use a sparse/banded linear solver (see
+        //       jacobianFunction())...
+
+        double *jacobian = (   (pComputeSystemJacobian != nullptr)
+                            && (   (linearSolverValue == SparseLinearSolver)
+                                || (linearSolverValue == BandedLinearSolver)))?
+                               new double[size_t(pSize)*size_t(pSize)]:
+                               nullptr;
+        auto userData = new KinsolSolverUserData(pComputeSystem,
+                                                 pComputeSystemJacobian,
+                                                 jacobian, pUserData);
 
         KINSetUserData(solver, userData);
 
@@ -299,12 +536,34 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
             linearSolver = SUNDenseLinearSolver(parametersVector, matrix);
 
             KINSetLinearSolver(solver, linearSolver, matrix);
+
+            if (pComputeSystemJacobian != nullptr) {
+                KINSetJacFn(solver, jacobianFunction);
+            }
         } else if (linearSolverValue == BandedLinearSolver) {
             matrix = SUNBandMatrix(pSize, upperHalfBandwidthValue,
                                           lowerHalfBandwidthValue);
             linearSolver = SUNBandLinearSolver(parametersVector, matrix);
 
             KINSetLinearSolver(solver, linearSolver, matrix);
+
+            if (pComputeSystemJacobian != nullptr) {
+                KINSetJacFn(solver, jacobianFunction);
+            }
+        } else if (linearSolverValue == SparseLinearSolver) {
+            // Determine the sparsity pattern of our Jacobian using our initial
+            // guess, so that our sparse matrix only needs to hold the entries
+            // that are part of it
+
+            pComputeSystemJacobian(pParameters, jacobian, pUserData);
+
+            userData->updateJacobianSparsityPattern(pSize);
+
+            matrix = SUNSparseMatrix(pSize, pSize, userData->jacobianRowIndices().count(), CSC_MAT);
+            linearSolver = SUNDIALS::sparseLinearSolver(parametersVector, matrix);
+
+            KINSetLinearSolver(solver, linearSolver, matrix);
+            KINSetJacFn(solver, jacobianFunction);
         } else if (linearSolverValue == GmresLinearSolver) {
             linearSolver = SUNSPGMR(parametersVector, PREC_NONE, 0);
 
@@ -322,21 +581,29 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
         // Keep track of our data
 
         data = new KinsolSolverData(solver, parametersVector, onesVector,
-                                    matrix, linearSolver, userData);
+                                    matrix, linearSolver, jacobian, userData);
 
         mData.insert(reinterpret_cast<void *>(pComputeSystem), data);
     } else {
         // We are already initiliased, so simply update our user data
+        // Note: KINSOL holds a pointer to our user data, so updating it in
+        //       place means that we don't need to allocate anything nor to
+        //       call KINSetUserData()...
 
-        data->setUserData(new KinsolSolverUserData(pComputeSystem, pUserData));
-
-        KINSetUserData(data->solver(), data->userData());
+        data->userData()->setUserData(pUserData);
     }
 
+    mLastComputeSystem = pComputeSystem;
+    mLastData = data;
+
     // Solve our linear system
 
     KINSol(data->solver(), data->parametersVector(), KIN_LINESEARCH,
            data->onesVector(), data->onesVector());
+
+    // Return the solution of our NLA system
+
+    memcpy(pParameters, N_VGetArrayPointer_Serial(data->parametersVector()), size_t(pSize)*OpenCOR::Solver::SizeOfDouble);
 }
 
 //==============================================================================
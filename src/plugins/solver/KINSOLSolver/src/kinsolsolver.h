@@ -51,6 +51,7 @@ static const auto LowerHalfBandwidthId        = QStringLiteral("LowerHalfBandwid
 
 static const auto DenseLinearSolver    = QStringLiteral("Dense");
 static const auto BandedLinearSolver   = QStringLiteral("Banded");
+static const auto SparseLinearSolver   = QStringLiteral("Sparse");
 static const auto GmresLinearSolver    = QStringLiteral("GMRES");
 static const auto BiCgStabLinearSolver = QStringLiteral("BiCGStab");
 static const auto TfqmrLinearSolver    = QStringLiteral("TFQMR");
@@ -78,14 +79,30 @@ class KinsolSolverUserData
 {
 public:
     explicit KinsolSolverUserData(Solver::NlaSolver::ComputeSystemFunction pComputeSystem,
-                                  void *pUserData);
+                                  Solver::NlaSolver::ComputeSystemJacobianFunction pComputeSystemJacobian,
+                                  double *pJacobian, void *pUserData);
 
     Solver::NlaSolver::ComputeSystemFunction computeSystem() const;
+    Solver::NlaSolver::ComputeSystemJacobianFunction computeSystemJacobian() const;
+
+    double * jacobian() const;
+
+    QVector<int> jacobianColumnStarts() const;
+    QVector<int> jacobianRowIndices() const;
+
+    void updateJacobianSparsityPattern(int pSize);
 
     void * userData() const;
+    void setUserData(void *pUserData);
 
 private:
     Solver::NlaSolver::ComputeSystemFunction mComputeSystem;
+    Solver::NlaSolver::ComputeSystemJacobianFunction mComputeSystemJacobian;
+
+    double *mJacobian;
+
+    QVector<int> mJacobianColumnStarts;
+    QVector<int> mJacobianRowIndices;
 
     void *mUserData;
 };
@@ -97,7 +114,7 @@ class KinsolSolverData
 public:
     explicit KinsolSolverData(void *pSolver, N_Vector pParametersVector,
                               N_Vector pOnesVector, SUNMatrix pMatrix,
-                              SUNLinearSolver pLinearSolver,
+                              SUNLinearSolver pLinearSolver, double *pJacobian,
                               KinsolSolverUserData *pUserData);
     ~KinsolSolverData();
 
@@ -106,8 +123,9 @@ public:
     N_Vector parametersVector() const;
     N_Vector onesVector() const;
 
+    double * jacobian() const;
+
     KinsolSolverUserData * userData() const;
-    void setUserData(KinsolSolverUserData *pUserData);
 
 private:
     void *mSolver;
@@ -118,6 +136,8 @@ private:
     SUNMatrix mMatrix;
     SUNLinearSolver mLinearSolver;
 
+    double *mJacobian;
+
     KinsolSolverUserData *mUserData;
 };
 
@@ -130,11 +150,15 @@ class KinsolSolver : public OpenCOR::Solver::NlaSolver
 public:
     ~KinsolSolver() override;
 
-    void solve(ComputeSystemFunction pComputeSystem, double *pParameters,
-               int pSize, void *pUserData) override;
+    void solve(ComputeSystemFunction pComputeSystem,
+               ComputeSystemJacobianFunction pComputeSystemJacobian,
+               double *pParameters, int pSize, void *pUserData) override;
 
 private:
     QMap<void *, KinsolSolverData *> mData;
+
+    ComputeSystemFunction mLastComputeSystem = nullptr;
+    KinsolSolverData *mLastData = nullptr;
 };
 
 //==============================================================================
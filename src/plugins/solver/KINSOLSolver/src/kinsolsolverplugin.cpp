@@ -173,6 +173,7 @@ Solver::Properties KINSOLSolverPlugin::solverProperties() const
 
     QStringList LinearSolverListValues = { DenseLinearSolver,
                                            BandedLinearSolver,
+                                           SparseLinearSolver,
                                            GmresLinearSolver,
                                            BiCgStabLinearSolver,
                                            TfqmrLinearSolver };
@@ -200,7 +201,7 @@ QMap<QString, bool> KINSOLSolverPlugin::solverPropertiesVisibility(const QMap<QS
         res.insert(UpperHalfBandwidthId, true);
         res.insert(LowerHalfBandwidthId, true);
     } else {
-        // Dense/GMRES/Bi-CGStab/TFQMR linear solver
+        // Dense/sparse/GMRES/Bi-CGStab/TFQMR linear solver
 
         res.insert(UpperHalfBandwidthId, false);
         res.insert(LowerHalfBandwidthId, false);
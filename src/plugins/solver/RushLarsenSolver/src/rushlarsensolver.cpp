@@ -0,0 +1,161 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Rush-Larsen solver
+//==============================================================================
+
+#include "rushlarsensolver.h"
+
+//==============================================================================
+
+#include <cmath>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace RushLarsenSolver {
+
+//==============================================================================
+
+static const double BhThreshold = 1.0e-12;
+
+//==============================================================================
+
+RushLarsenSolver::~RushLarsenSolver()
+{
+    // Delete some internal objects
+
+    delete[] mGates;
+}
+
+//==============================================================================
+
+void RushLarsenSolver::initialize(double pVoi, int pRatesStatesCount,
+                                  double *pConstants, double *pRates,
+                                  double *pStates, double *pAlgebraic,
+                                  ComputeRatesFunction pComputeRates)
+{
+    // Retrieve the solver's properties
+
+    if (mProperties.contains(StepId)) {
+        mStep = mProperties.value(StepId).toDouble();
+    } else {
+        emit error(tr(R"(the "Step" property value could not be retrieved)"));
+
+        return;
+    }
+
+    if (mProperties.contains(InterpolateSolutionId)) {
+        mInterpolateSolution = mProperties.value(InterpolateSolutionId).toBool();
+    } else {
+        emit error(tr(R"(the "Interpolate solution" property value could not be retrieved)"));
+
+        return;
+    }
+
+    // Initialise the ODE solver itself
+
+    OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
+                          pAlgebraic, pComputeRates);
+
+    // (Re)create our gates' coefficients and determine which of our states
+    // are not gates
+    // Note: if our model doesn't have any gates (or if we couldn't determine
+    //       them, e.g. because our model needs to solve an NLA system), then
+    //       we are effectively a forward Euler solver...
+
+    if (mComputeGates == nullptr) {
+        mGateStates.clear();
+    }
+
+    delete[] mGates;
+
+    mGates = new double[pRatesStatesCount] {};
+
+    QVector<bool> isGate(pRatesStatesCount);
+
+    for (auto gateState : mGateStates) {
+        isGate[gateState] = true;
+    }
+
+    mNonGateStates.clear();
+
+    for (int i = 0; i < pRatesStatesCount; ++i) {
+        if (!isGate[i]) {
+            mNonGateStates << i;
+        }
+    }
+}
+
+//==============================================================================
+
+void RushLarsenSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // Solve our model using our fixed step
+
+    solveWithFixedStep(pVoi, pVoiEnd, mStep);
+}
+
+//==============================================================================
+
+void RushLarsenSolver::step(double pVoi, double pStep) const
+{
+    // Our gates are such that f(t_n, Y_n) = a + b * Y_n, with a and b that
+    // don't depend on Y_n, i.e. f(t_n, Y_n) = (Y_inf - Y_n) / tau with
+    // Y_inf = -a / b and tau = -1 / b, meaning that, assuming that a and b are
+    // constant over a step, we can integrate them exactly:
+    //   Y_n+1 = Y_inf + (Y_n - Y_inf) * exp(-h / tau)
+    //         = Y_n + f(t_n, Y_n) / b * (exp(b * h) - 1)
+    // As for our other states, we integrate them using forward Euler:
+    //   Y_n+1 = Y_n + h * f(t_n, Y_n)
+
+    // Compute f(t_n, Y_n) and, if we have gates, b
+
+    if (mGateStates.isEmpty()) {
+        computeRates(pVoi, mStates);
+    } else {
+        mComputeGates(pVoi, mConstants, mRates, mStates, mAlgebraic, mGates);
+    }
+
+    // Compute Y_n+1
+    // Note: we use forward Euler for a gate with a (numerically) zero b,
+    //       since its rate is then (numerically) constant...
+
+    for (auto i : mNonGateStates) {
+        mStates[i] += pStep*mRates[i];
+    }
+
+    for (auto i : mGateStates) {
+        double bh = mGates[i]*pStep;
+
+        mStates[i] += (qAbs(bh) > BhThreshold)?
+                          mRates[i]*std::expm1(bh)/mGates[i]:
+                          pStep*mRates[i];
+    }
+}
+
+//==============================================================================
+
+} // namespace RushLarsenSolver
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,211 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// Rush-Larsen solver tests
+//==============================================================================
+
+#include "rushlarsensolver.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+#include <cmath>
+
+//==============================================================================
+
+static const double OutputPointInterval = 0.1;
+static const int    OutputPointsCount   = 10;
+static const double Tolerance           = 1.0e-12;
+
+//==============================================================================
+
+static OpenCOR::Solver::Solver::Properties properties(double pStep)
+{
+    // Return the properties to be used by our solver
+
+    OpenCOR::Solver::Solver::Properties res;
+
+    res.insert(OpenCOR::RushLarsenSolver::StepId, pStep);
+    res.insert(OpenCOR::RushLarsenSolver::InterpolateSolutionId, false);
+
+    return res;
+}
+
+//==============================================================================
+
+static void computeRates(double pVoi, double *pConstants, double *pRates,
+                         double *pStates, double *pAlgebraic, void *pNlaSolver)
+{
+    Q_UNUSED(pVoi)
+    Q_UNUSED(pAlgebraic)
+    Q_UNUSED(pNlaSolver)
+
+    // A gate, i.e. y' = a+b*y, with a and b as our first two constants, and an
+    // exponential decay, i.e. z' = -k*z, with k as our third constant
+
+    pRates[0] = pConstants[0]+pConstants[1]*pStates[0];
+    pRates[1] = -pConstants[2]*pStates[1];
+}
+
+//==============================================================================
+
+static void computeGates(double pVoi, double *pConstants, double *pRates,
+                         double *pStates, double *pAlgebraic, double *pGates)
+{
+    // Compute our rates, as well as the coefficient of our gate in its own rate
+
+    computeRates(pVoi, pConstants, pRates, pStates, pAlgebraic, nullptr);
+
+    pGates[0] = pConstants[1];
+}
+
+//==============================================================================
+
+void Tests::gateTests()
+{
+    // Solve a gate, i.e. y' = (y_inf-y)/tau with y_inf = 0.3, tau = 0.05 and
+    // y(0) = 1, and check that our solution matches its analytic solution, i.e.
+    // y = y_inf+(y(0)-y_inf)*exp(-t/tau), even though our step is big compared
+    // to tau
+    // Note: our other state is not a gate, so it is integrated using forward
+    //       Euler, i.e. z_n+1 = (1-k*h)*z_n...
+
+    static const double YInf = 0.3;
+    static const double Tau = 0.05;
+    static const double K = 2.0;
+    static const double Step = 0.02;
+
+    OpenCOR::RushLarsenSolver::RushLarsenSolver solver;
+    QSignalSpy errorSpy(&solver, &OpenCOR::Solver::Solver::error);
+    double constants[] = { YInf/Tau, -1.0/Tau, K };
+    double rates[] = { 0.0, 0.0 };
+    double states[] = { 1.0, 1.0 };
+    double voi = 0.0;
+    double z = 1.0;
+
+    solver.setProperties(properties(Step));
+    solver.setGates(computeGates, QVector<int>() << 0);
+    solver.initialize(voi, 2, constants, rates, states, nullptr, computeRates);
+
+    for (int i = 1; i <= OutputPointsCount; ++i) {
+        solver.solve(voi, i*OutputPointInterval);
+
+        for (int j = 0; j < 5; ++j) {
+            z *= 1.0-K*Step;
+        }
+
+        QCOMPARE(errorSpy.count(), 0);
+        QVERIFY(std::abs(states[0]-(YInf+(1.0-YInf)*exp(-voi/Tau))) < Tolerance);
+        QVERIFY(std::abs(states[1]-z) < Tolerance);
+    }
+}
+
+//==============================================================================
+
+void Tests::thresholdTests()
+{
+    // Take one step of size one for a gate with y(0) = 0, a = 1 and some small
+    // b values, and check that we use (exp(b*h)-1)/b above our threshold (i.e.
+    // |b*h| > 1e-12) and forward Euler below it, and that both are
+    // (numerically) the same around our threshold
+
+    static const double Bs[] = { 0.5e-12, 0.99e-12, 1.01e-12, 2.0e-12, 1.0e-6 };
+
+    for (auto b : Bs) {
+        for (auto sign : { 1.0, -1.0 }) {
+            OpenCOR::RushLarsenSolver::RushLarsenSolver solver;
+            QSignalSpy errorSpy(&solver, &OpenCOR::Solver::Solver::error);
+            double constants[] = { 1.0, sign*b, 0.0 };
+            double rates[] = { 0.0, 0.0 };
+            double states[] = { 0.0, 0.0 };
+            double voi = 0.0;
+
+            solver.setProperties(properties(1.0));
+            solver.setGates(computeGates, QVector<int>() << 0);
+            solver.initialize(voi, 2, constants, rates, states, nullptr, computeRates);
+            solver.solve(voi, 1.0);
+
+            QCOMPARE(errorSpy.count(), 0);
+
+            if (b > 1.0e-12) {
+                QVERIFY(states[0] == std::expm1(sign*b)/(sign*b));
+            } else {
+                QVERIFY(states[0] == 1.0);
+            }
+
+            QVERIFY(std::abs(states[0]-1.0) < 2.0*b);
+        }
+    }
+}
+
+//==============================================================================
+
+void Tests::noGatesTests()
+{
+    // Solve our model without any gates, be it because we are not told about
+    // them or because we can't compute them, and check that both of our states
+    // are integrated using forward Euler, i.e. Y_n+1 = Y_n+h*f(t_n, Y_n)
+
+    static const double YInf = 0.3;
+    static const double Tau = 0.05;
+    static const double K = 2.0;
+    static const double Step = 0.02;
+
+    for (auto gateStates : { QVector<int>(), QVector<int>() << 0 }) {
+        OpenCOR::RushLarsenSolver::RushLarsenSolver solver;
+        QSignalSpy errorSpy(&solver, &OpenCOR::Solver::Solver::error);
+        double constants[] = { YInf/Tau, -1.0/Tau, K };
+        double rates[] = { 0.0, 0.0 };
+        double states[] = { 1.0, 1.0 };
+        double voi = 0.0;
+        double y = 1.0;
+        double z = 1.0;
+
+        solver.setProperties(properties(Step));
+        solver.setGates(nullptr, gateStates);
+        solver.initialize(voi, 2, constants, rates, states, nullptr, computeRates);
+
+        for (int i = 1; i <= OutputPointsCount; ++i) {
+            solver.solve(voi, i*OutputPointInterval);
+
+            for (int j = 0; j < 5; ++j) {
+                y += Step*(YInf-y)/Tau;
+                z *= 1.0-K*Step;
+            }
+
+            QCOMPARE(errorSpy.count(), 0);
+            QVERIFY(std::abs(states[0]-y) < Tolerance);
+            QVERIFY(std::abs(states[1]-z) < Tolerance);
+        }
+    }
+}
+
+//==============================================================================
+
+QTEST_APPLESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -55,6 +55,14 @@ void SecondOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
         return;
     }
 
+    if (mProperties.contains(InterpolateSolutionId)) {
+        mInterpolateSolution = mProperties.value(InterpolateSolutionId).toBool();
+    } else {
+        emit error(tr(R"(the "Interpolate solution" property value could not be retrieved)"));
+
+        return;
+    }
+
     // Initialise the ODE solver itself
 
     OdeSolver::initialize(pVoi, pRatesStatesCount, pConstants, pRates, pStates,
@@ -69,7 +77,25 @@ void SecondOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
 
 //==============================================================================
 
+bool SecondOrderRungeKuttaSolver::supportsBatch() const
+{
+    // We support solving several instances of a model in lockstep
+
+    return true;
+}
+
+//==============================================================================
+
 void SecondOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
+{
+    // Solve our model using our fixed step
+
+    solveWithFixedStep(pVoi, pVoiEnd, mStep);
+}
+
+//==============================================================================
+
+void SecondOrderRungeKuttaSolver::step(double pVoi, double pStep) const
 {
     // k1 = h * f(t_n, Y_n)
     // k2 = h * f(t_n + h / 2, Y_n + k1 / 2)
@@ -78,47 +104,26 @@ void SecondOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
     // Note: the algorithm hereafter doesn't compute k1 and k2 as such and this
     //       simply for performance reasons...
 
-    double voiStart = pVoi;
-
-    int stepNumber = 0;
-    double realStep = mStep;
-    double realHalfStep = 0.5*realStep;
+    double halfStep = 0.5*pStep;
 
-    while (!qFuzzyCompare(pVoi, pVoiEnd)) {
-        // Check that the time step is correct
+    // Compute f(t_n, Y_n)
 
-        if (pVoi+realStep > pVoiEnd) {
-            realStep = pVoiEnd-pVoi;
-            realHalfStep = 0.5*realStep;
-        }
+    computeRates(pVoi, mStates);
 
-        // Compute f(t_n, Y_n)
+    // Compute k1 and therefore Yk1
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
-
-        // Compute k1 and therefore Yk1
-
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mYk1[i] = mStates[i]+realHalfStep*mRates[i];
-        }
-
-        // Compute f(t_n + h / 2, Y_n + k1 / 2)
-
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk1, mAlgebraic);
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mYk1[i] = mStates[i]+halfStep*mRates[i];
+    }
 
-        // Compute Y_n+1
+    // Compute f(t_n + h / 2, Y_n + k1 / 2)
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
-            mStates[i] += realStep*mRates[i];
-        }
+    computeRates(pVoi+halfStep, mYk1);
 
-        // Advance through time
+    // Compute Y_n+1
 
-        if (!qFuzzyCompare(realStep, mStep)) {
-            pVoi = pVoiEnd;
-        } else {
-            pVoi = voiStart+(++stepNumber)*mStep;
-        }
+    for (int i = 0; i < mRatesStatesCount; ++i) {
+        mStates[i] += pStep*mRates[i];
     }
 }
 
@@ -25,18 +25,24 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
-void doNonLinearSolve(char *pRuntime,
+void doNonLinearSolve(void *pNlaSolver,
                       void (*pFunction)(double *, double *, void *),
+                      void (*pJacobianFunction)(double *, double *, void *),
                       double *pParameters, int pSize, void *pUserData)
 {
     // Retrieve the NLA solver which we should use and solve our NLA system
-    // Note: we should always have an NLA solver, but better be safe than
-    //       sorry...
+    // Note #1: the NLA solver is the one that was passed to the model function
+    //          that needs to solve our NLA system (see
+    //          CellmlFileRuntime::cleanCode()), i.e. it is specific to the
+    //          instance of the model being computed...
+    // Note #2: we should always have an NLA solver, but better be safe than
+    //          sorry...
 
-    OpenCOR::Solver::NlaSolver *nlaSolver = OpenCOR::Solver::nlaSolver(pRuntime);
+    auto nlaSolver = static_cast<OpenCOR::Solver::NlaSolver *>(pNlaSolver);
 
     if (nlaSolver != nullptr) {
-        nlaSolver->solve(pFunction, pParameters, pSize, pUserData);
+        nlaSolver->solve(pFunction, pJacobianFunction, pParameters, pSize,
+                         pUserData);
     } else {
         qWarning("WARNING | %s:%d: no NLA solver could be found.", __FILE__, __LINE__);
     }
@@ -52,7 +58,7 @@ extern "C" Q_DECL_EXPORT int solverInterfaceVersion()
 {
     // Version of the solver interface
 
-    return 2;
+    return 8;
 }
 
 //==============================================================================
@@ -108,12 +114,79 @@ void OdeSolver::initialize(double pVoi, int pRatesStatesCount,
 
     mRatesStatesCount = pRatesStatesCount;
 
+    mRestart = true;
+
     mConstants = pConstants;
     mRates = pRates;
     mStates = pStates;
     mAlgebraic = pAlgebraic;
 
     mComputeRates = pComputeRates;
+
+    mBatchCount = 0;
+    mComputeRatesBatch = nullptr;
+}
+
+//==============================================================================
+
+void OdeSolver::setJacobian(ComputeJacobianFunction pComputeJacobian,
+                            const QVector<int> &pColumnStarts,
+                            const QVector<int> &pRowIndices)
+{
+    // Keep track of the function that computes the Jacobian of our rates with
+    // respect to our states, if any, and of its sparsity pattern, which is
+    // given in compressed sparse column format
+    // Note: this is to be called before initialize() and is used by solvers
+    //       that can make use of an analytic Jacobian (e.g. CVODES), the other
+    //       ones simply ignoring it...
+
+    mComputeJacobian = pComputeJacobian;
+    mJacobianColumnStarts = pColumnStarts;
+    mJacobianRowIndices = pRowIndices;
+}
+
+//==============================================================================
+
+void OdeSolver::setGates(ComputeGatesFunction pComputeGates,
+                         const QVector<int> &pGateStates)
+{
+    // Keep track of the function that computes our rates together with the
+    // coefficient of each of our gates in its own rate, if any, and of the
+    // index of the states that are gates
+    // Note: this is to be called before initialize() and is used by solvers
+    //       that can integrate gates exactly (e.g. Rush-Larsen), the other
+    //       ones simply ignoring it...
+
+    mComputeGates = pComputeGates;
+    mGateStates = pGateStates;
+}
+
+//==============================================================================
+
+void OdeSolver::setRoots(ComputeRootsFunction pComputeRoots, int pRootsCount)
+{
+    // Keep track of the function that computes the root functions of our
+    // model, if any, i.e. functions that change sign whenever there is a
+    // discontinuity in our rates, and of their number
+    // Note: this is to be called before initialize() and is used by solvers
+    //       that can locate discontinuities (e.g. CVODES), the other ones
+    //       simply ignoring it...
+
+    mComputeRoots = pComputeRoots;
+    mRootsCount = pRootsCount;
+}
+
+//==============================================================================
+
+void OdeSolver::setNlaSolver(NlaSolver *pNlaSolver)
+{
+    // Keep track of the NLA solver to be used by our model, if it needs one,
+    // when computing its rates
+    // Note: this is to be called before initialize() and means that each
+    //       instance of our model (and therefore each thread) has its own NLA
+    //       solver...
+
+    mNlaSolver = pNlaSolver;
 }
 
 //==============================================================================
@@ -122,47 +195,211 @@ void OdeSolver::reinitialize(double pVoi)
 {
     Q_UNUSED(pVoi)
 
-    // Nothing to do by default...
+    // Restart our integration from our current states, should we be
+    // interpolating our solution (see solveWithFixedStep())
+
+    mRestart = true;
 }
 
 //==============================================================================
 
-NlaSolver::~NlaSolver() = default;
+bool OdeSolver::supportsBatch() const
+{
+    // By default, we don't support solving several instances of a model in
+    // lockstep
+
+    return false;
+}
 
 //==============================================================================
 
-QString objectAddress(QObject *pObject)
+bool OdeSolver::interpolatesSolution() const
 {
-    // Return the given object's address as a string
+    // Return whether we integrate our model using our own steps, independently
+    // of the points at which we are asked for a solution, which we then get
+    // through interpolation
 
-    return QString::number(quint64(pObject));
+    return mInterpolateSolution;
 }
 
 //==============================================================================
 
-NlaSolver * nlaSolver(const QString &pObjectAddress)
+void OdeSolver::initializeBatch(double pVoi, int pRatesStatesCount, int pCount,
+                                double *pConstants, double *pRates,
+                                double *pStates, double *pAlgebraic,
+                                ComputeRatesBatchFunction pComputeRatesBatch)
 {
-    // Return the runtime's NLA solver
+    // Initialise the ODE solver so that it solves the given number of
+    // instances of a model in lockstep
+    // Note #1: our arrays are expected to use a structure-of-arrays layout,
+    //          i.e. the value of a given model parameter for all of our
+    //          instances is stored contiguously. Since a fixed-step solver
+    //          updates its states element-wise, it can therefore handle all of
+    //          our instances as if they were one big model, as long as it
+    //          computes its rates using computeRates()...
+    // Note #2: this is only to be called if supportsBatch() returns true...
+
+    initialize(pVoi, pRatesStatesCount*pCount, pConstants, pRates, pStates,
+               pAlgebraic, nullptr);
+
+    mBatchCount = pCount;
+    mComputeRatesBatch = pComputeRatesBatch;
+}
+
+//==============================================================================
 
-    QObject *object = reinterpret_cast<NlaSolver *>(QVariant(pObjectAddress).toULongLong());
+void OdeSolver::computeRates(double pVoi, double *pStates) const
+{
+    // Compute our rates for the given states, either for one instance of our
+    // model or for all of our instances at once
+
+    if (mComputeRatesBatch != nullptr) {
+        mComputeRatesBatch(mBatchCount, pVoi, mConstants, mRates, pStates, mAlgebraic);
+    } else {
+        mComputeRates(pVoi, mConstants, mRates, pStates, mAlgebraic, mNlaSolver);
+    }
+}
+
+//==============================================================================
+
+void OdeSolver::step(double pVoi, double pStep) const
+{
+    Q_UNUSED(pVoi)
+    Q_UNUSED(pStep)
 
-    return reinterpret_cast<NlaSolver *>(QVariant(object->objectName()).toULongLong());
+    // Nothing to do by default...
+    // Note: this is to be reimplemented by fixed-step solvers, which are to
+    //       take one step of the given size from the given point, updating our
+    //       states in place...
 }
 
 //==============================================================================
 
-void setNlaSolver(QObject *pObject, NlaSolver *pNlaSolver)
+void OdeSolver::solveWithFixedStep(double &pVoi, double pVoiEnd,
+                                   double pStep) const
 {
-    // Keep track of the runtime's NLA solver
-    // Note: normally, we would use QObject::setProperty(), but it doesn't play
-    //       well on Windows without a GUI (see https://bit.ly/2YCpzew). So,
-    //       instead, we use QObject::setObjectName() (!!)...
+    // Solve our model up to the given point using steps of the given size
+
+    if (!mInterpolateSolution) {
+        // Use steps that are all relative to the given point, shortening our
+        // last one, if needed, so that we stop exactly at the given end point
+
+        double voiStart = pVoi;
+
+        int stepNumber = 0;
+        double realStep = pStep;
+
+        while (!qFuzzyCompare(pVoi, pVoiEnd)) {
+            // Check that the time step is correct
+
+            if (pVoi+realStep > pVoiEnd) {
+                realStep = pVoiEnd-pVoi;
+            }
+
+            // Take one step
+
+            step(pVoi, realStep);
+
+            // Advance through time
+
+            if (!qFuzzyCompare(realStep, pStep)) {
+                pVoi = pVoiEnd;
+            } else {
+                pVoi = voiStart+(++stepNumber)*pStep;
+            }
+        }
+
+        return;
+    }
+
+    // Integrate our model using our own steps, independently of the given end
+    // point, which means that our last step may go past it, and interpolate our
+    // solution at the given end point
+    // Note #1: our own steps are all relative to the point from which we
+    //          (re)started, and our solution at the end of our last step is
+    //          kept in mStates1 since our states get overwritten with our
+    //          interpolated solution...
+    // Note #2: we use cubic Hermite interpolation, which requires the rates at
+    //          both ends of our last step, but we only compute them when we
+    //          actually need to interpolate our solution...
+
+    size_t size = size_t(mRatesStatesCount)*SizeOfDouble;
+
+    if (mRestart) {
+        mStates0.resize(mRatesStatesCount);
+        mStates1.resize(mRatesStatesCount);
+        mRates0.resize(mRatesStatesCount);
+        mRates1.resize(mRatesStatesCount);
+
+        memcpy(mStates1.data(), mStates, size);
+
+        mStartVoi = pVoi;
+        mStepNumber = 0;
+
+        mVoi0 = pVoi;
+        mVoi1 = pVoi;
+
+        mRestart = false;
+        mHasDenseRates = false;
+    }
+
+    while ((mVoi1 < pVoiEnd) && !qFuzzyCompare(mVoi1, pVoiEnd)) {
+        // Keep track of the start of our step and take it
 
-    pObject->setObjectName(objectAddress(pNlaSolver));
+        mVoi0 = mVoi1;
+        mVoi1 = mStartVoi+(++mStepNumber)*pStep;
+
+        memcpy(mStates0.data(), mStates1.data(), size);
+        memcpy(mStates, mStates1.data(), size);
+
+        step(mVoi0, mVoi1-mVoi0);
+
+        memcpy(mStates1.data(), mStates, size);
+
+        mHasDenseRates = false;
+    }
+
+    if (qFuzzyCompare(mVoi1, pVoiEnd)) {
+        // The end of our last step is the given end point
+
+        memcpy(mStates, mStates1.data(), size);
+    } else {
+        // Interpolate our solution at the given end point
+
+        if (!mHasDenseRates) {
+            computeRates(mVoi0, mStates0.data());
+
+            memcpy(mRates0.data(), mRates, size);
+
+            computeRates(mVoi1, mStates1.data());
+
+            memcpy(mRates1.data(), mRates, size);
+
+            mHasDenseRates = true;
+        }
+
+        double h = mVoi1-mVoi0;
+        double s = (pVoiEnd-mVoi0)/h;
+        double oneMinusS = 1.0-s;
+        double h00 = (1.0+2.0*s)*oneMinusS*oneMinusS;
+        double h10 = h*s*oneMinusS*oneMinusS;
+        double h01 = s*s*(3.0-2.0*s);
+        double h11 = -h*s*s*oneMinusS;
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mStates[i] = h00*mStates0[i]+h10*mRates0[i]+h01*mStates1[i]+h11*mRates1[i];
+        }
+    }
+
+    pVoi = pVoiEnd;
 }
 
 //==============================================================================
 
+NlaSolver::~NlaSolver() = default;
+
+//==============================================================================
+
 Property::Property(Type pType, const QString &pId,
                    const Descriptions &pDescriptions,
                    const QStringList &pListValues,
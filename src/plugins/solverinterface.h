@@ -30,11 +30,13 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QVariant>
+#include <QVector>
 
 //==============================================================================
 
-extern "C" void doNonLinearSolve(char *pRuntime,
+extern "C" void doNonLinearSolve(void *pNlaSolver,
                                  void (*pFunction)(double *, double *, void *),
+                                 void (*pJacobianFunction)(double *, double *, void *),
                                  double *pParameters, int pSize,
                                  void *pUserData);
 
@@ -71,10 +73,26 @@ signals:
 
 //==============================================================================
 
+class NlaSolver;
+
+//==============================================================================
+
 class OdeSolver : public Solver
 {
 public:
-    using ComputeRatesFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic);
+    using ComputeRatesFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, void *pNlaSolver);
+    using ComputeRatesBatchFunction = void (*)(int pCount, double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic);
+    using ComputeJacobianFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, double *pJacobian);
+    using ComputeGatesFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, double *pGates);
+    using ComputeRootsFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, double *pRoots);
+
+    void setJacobian(ComputeJacobianFunction pComputeJacobian,
+                     const QVector<int> &pColumnStarts,
+                     const QVector<int> &pRowIndices);
+    void setGates(ComputeGatesFunction pComputeGates,
+                  const QVector<int> &pGateStates);
+    void setRoots(ComputeRootsFunction pComputeRoots, int pRootsCount);
+    void setNlaSolver(NlaSolver *pNlaSolver);
 
     virtual void initialize(double pVoi, int pRatesStatesCount,
                             double *pConstants, double *pRates, double *pStates,
@@ -82,6 +100,15 @@ public:
                             ComputeRatesFunction pComputeRates);
     virtual void reinitialize(double pVoi);
 
+    virtual bool supportsBatch() const;
+
+    bool interpolatesSolution() const;
+
+    void initializeBatch(double pVoi, int pRatesStatesCount, int pCount,
+                         double *pConstants, double *pRates, double *pStates,
+                         double *pAlgebraic,
+                         ComputeRatesBatchFunction pComputeRatesBatch);
+
     virtual void solve(double &pVoi, double pVoiEnd) const = 0;
 
 protected:
@@ -93,6 +120,44 @@ protected:
     double *mAlgebraic = nullptr;
 
     ComputeRatesFunction mComputeRates = nullptr;
+
+    int mBatchCount = 0;
+    ComputeRatesBatchFunction mComputeRatesBatch = nullptr;
+
+    ComputeJacobianFunction mComputeJacobian = nullptr;
+    QVector<int> mJacobianColumnStarts;
+    QVector<int> mJacobianRowIndices;
+
+    ComputeGatesFunction mComputeGates = nullptr;
+    QVector<int> mGateStates;
+
+    ComputeRootsFunction mComputeRoots = nullptr;
+    int mRootsCount = 0;
+
+    NlaSolver *mNlaSolver = nullptr;
+
+    bool mInterpolateSolution = false;
+
+    void computeRates(double pVoi, double *pStates) const;
+
+    virtual void step(double pVoi, double pStep) const;
+
+    void solveWithFixedStep(double &pVoi, double pVoiEnd, double pStep) const;
+
+private:
+    mutable bool mRestart = true;
+    mutable bool mHasDenseRates = false;
+
+    mutable double mStartVoi = 0.0;
+    mutable int mStepNumber = 0;
+
+    mutable double mVoi0 = 0.0;
+    mutable double mVoi1 = 0.0;
+
+    mutable QVector<double> mStates0;
+    mutable QVector<double> mStates1;
+    mutable QVector<double> mRates0;
+    mutable QVector<double> mRates1;
 };
 
 //==============================================================================
@@ -103,22 +168,16 @@ public:
     ~NlaSolver() override;
 
     using ComputeSystemFunction = void (*)(double *, double *, void *);
+    using ComputeSystemJacobianFunction = void (*)(double *, double *, void *);
 
     virtual void solve(ComputeSystemFunction pComputeSystem,
+                       ComputeSystemJacobianFunction pComputeSystemJacobian,
                        double *pParameters, int pSize,
                        void *pUserData = nullptr) = 0;
 };
 
 //==============================================================================
 
-QString objectAddress(QObject *pObject);
-
-NlaSolver * nlaSolver(const QString &pObjectAddress);
-
-void setNlaSolver(QObject *pObject, NlaSolver *pNlaSolver);
-
-//==============================================================================
-
 enum class Type {
     Nla,
     Ode
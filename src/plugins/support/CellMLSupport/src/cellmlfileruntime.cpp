@@ -29,6 +29,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 #include "cellmlfile.h"
 #include "cellmlfileruntime.h"
+#include "cellmlfileruntimejacobian.h"
 #include "compilerengine.h"
 #include "compilermath.h"
 #include "corecliutils.h"
@@ -503,9 +504,9 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
                       "    double *aALGEBRAIC;\n"
                       "};\n"
                       "\n"
-                      "extern void doNonLinearSolve(char *, void (*)(double *, double *, void*), double *, int, void *);\n"
+                      "extern void doNonLinearSolve(void *, void (*)(double *, double *, void*), void (*)(double *, double *, void*), double *, int, void *);\n"
                       "\n"
-                     +functionsString
+                     +nlaJacobiansCode(functionsString)
                      +"\n";
     }
 
@@ -532,15 +533,124 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
         }
     }
 
+    // Note: the methods that may need to solve an NLA system are given the NLA
+    //       solver to use, so that several instances of our model can be
+    //       computed concurrently, each with its own NLA solver (see
+    //       cleanCode())...
+
     modelCode +=  methodCode("initializeConstants(double *CONSTANTS, double *RATES, double *STATES)",
                              initConsts)
-                 +methodCode("computeComputedConstants(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
+                 +methodCode("computeComputedConstants(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER)",
                              compCompConsts)
-                 +methodCode("computeVariables(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *CONDVAR)",
+                 +methodCode("computeVariables(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER, double *CONDVAR)",
                              mCodeInformation->variablesString())
-                 +methodCode("computeRates(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
+                 +methodCode("computeRates(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER)",
                              mCodeInformation->ratesString());
 
+    // Generate a batch version of computeRates(), which computes the rates of
+    // several instances of our model at once, but only if our model doesn't
+    // need to solve NLA systems (since our NLA solver can only handle one
+    // instance at a time)
+    // Note #1: our batch arrays use a structure-of-arrays layout, i.e. the
+    //          value of a given model parameter for all of our instances is
+    //          stored contiguously. This means that the body of our loop over
+    //          our instances can be vectorised, each of our instances being
+    //          computed in its own SIMD lane...
+    // Note #2: our batch function gets compiled only if it gets used (see
+    //          CompilerEngine::getFunction())...
+
+    if (!mAtLeastOneNlaSystem) {
+        static const QRegularExpression ArrayElementRegEx = QRegularExpression(R"(\b(CONSTANTS|RATES|STATES|ALGEBRAIC)\[(\d+)\])");
+
+        QString ratesBatch = cleanCode(mCodeInformation->ratesString());
+
+        ratesBatch.replace(ArrayElementRegEx, "\\1[\\2*COUNT+INSTANCE]");
+        ratesBatch.replace("\n", "\n    ");
+
+        modelCode += methodCode("computeRatesBatch(int COUNT, double VOI, double * __restrict CONSTANTS, double * __restrict RATES, double * __restrict STATES, double * __restrict ALGEBRAIC)",
+                                "for (int INSTANCE = 0; INSTANCE < COUNT; ++INSTANCE) {\n"
+                                "    "+ratesBatch+"\n"
+                                "}");
+    }
+
+    // Generate the code that computes the Jacobian of our rates with respect to
+    // our states, if we can differentiate our rates (which we can't, for
+    // example, if they need to solve an NLA system)
+    // Note: our Jacobian is sparse, so we only compute its non-zero entries,
+    //       which are stored in compressed sparse column format...
+
+    CellmlFileRuntimeJacobian jacobian(cleanCode(mCodeInformation->ratesString()),
+                                       "STATES", "RATES", mStatesRatesCount);
+
+    if (jacobian.isValid()) {
+        mJacobianColumnStarts = jacobian.columnStarts();
+        mJacobianRowIndices = jacobian.rowIndices();
+
+        modelCode += methodCode("computeJacobian(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *JACOBIAN)",
+                                jacobian.code("JACOBIAN"));
+
+        // Determine which of our states are gates, i.e. states the rate of
+        // which is linear in themselves (e.g. dm/dt = (m_inf-m)/tau_m), which
+        // is the case when the diagonal entry of our Jacobian for a state
+        // exists and doesn't itself depend on that state. Then, generate the
+        // code that computes our rates together with the coefficient of each
+        // gate in its own rate (i.e. -1/tau_m), so that a solver can integrate
+        // our gates exactly over a step (e.g. the Rush-Larsen solver)
+        // Note: we only differentiate our rates with respect to our gates,
+        //       which is usually much cheaper than computing our Jacobian...
+
+        CellmlFileRuntimeJacobian secondDerivatives(jacobian.diagonalCode("GATES"),
+                                                    "STATES", "GATES", mStatesRatesCount);
+
+        if (secondDerivatives.isValid()) {
+            QSet<int> gateStates;
+
+            for (int i = 0; i < mStatesRatesCount; ++i) {
+                if (jacobian.hasEntry(i, i) && !secondDerivatives.hasEntry(i, i)) {
+                    mGateStates << i;
+
+                    gateStates << i;
+                }
+            }
+
+            if (!gateStates.isEmpty()) {
+                CellmlFileRuntimeJacobian gates(cleanCode(mCodeInformation->ratesString()),
+                                                "STATES", "RATES", mStatesRatesCount,
+                                                gateStates);
+
+                if (gates.isValid()) {
+                    modelCode += methodCode("computeGates(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *GATES)",
+                                            gates.diagonalCode("GATES"));
+                } else {
+                    mGateStates.clear();
+                }
+            }
+        }
+
+        // Generate the code that computes our root functions, i.e. functions
+        // that change sign whenever one of the conditions in our rates (e.g.
+        // VOI>=CONSTANTS[3] for the start of a stimulus) changes value, so that
+        // a solver can locate our discontinuities exactly (e.g. CVODES)
+        // Note: we only consider the conditions that may change value over
+        //       time, i.e. those that depend on our VOI or our model
+        //       parameters that are not constants...
+
+        static const QRegularExpression VariableRegEx = QRegularExpression(R"(\b(VOI|STATES|RATES|ALGEBRAIC)\b)");
+
+        QString rootsCode;
+
+        for (const auto &condition : jacobian.conditions()) {
+            if (VariableRegEx.match(condition).hasMatch()) {
+                rootsCode += QString("ROOTS[%1] = %2;\n").arg(mRootsCount++).arg(condition);
+            }
+        }
+
+        if (mRootsCount != 0) {
+            modelCode += methodCode("computeRoots(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *ROOTS)",
+                                    cleanCode(mCodeInformation->ratesString())+"\n"+rootsCode);
+        }
+    }
+
     // Check whether the model code contains a definite integral, otherwise
     // compute it and check that everything went fine
 
@@ -571,10 +681,30 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
         mComputeVariables = reinterpret_cast<ComputeVariablesFunction>(mCompilerEngine->getFunction("computeVariables"));
         mComputeRates = reinterpret_cast<ComputeRatesFunction>(mCompilerEngine->getFunction("computeRates"));
 
+        if (!mAtLeastOneNlaSystem) {
+            mComputeRatesBatch = reinterpret_cast<ComputeRatesBatchFunction>(mCompilerEngine->getFunction("computeRatesBatch"));
+        }
+
+        if (!mJacobianColumnStarts.isEmpty()) {
+            mComputeJacobian = reinterpret_cast<ComputeJacobianFunction>(mCompilerEngine->getFunction("computeJacobian"));
+        }
+
+        if (!mGateStates.isEmpty()) {
+            mComputeGates = reinterpret_cast<ComputeGatesFunction>(mCompilerEngine->getFunction("computeGates"));
+        }
+
+        if (mRootsCount != 0) {
+            mComputeRoots = reinterpret_cast<ComputeRootsFunction>(mCompilerEngine->getFunction("computeRoots"));
+        }
+
         // Make sure that we managed to retrieve all the ODE functions
 
         if (   (mInitializeConstants == nullptr) || (mComputeComputedConstants == nullptr)
-            || (mComputeVariables == nullptr) || (mComputeRates == nullptr)) {
+            || (mComputeVariables == nullptr) || (mComputeRates == nullptr)
+            || (!mAtLeastOneNlaSystem && (mComputeRatesBatch == nullptr))
+            || (!mJacobianColumnStarts.isEmpty() && (mComputeJacobian == nullptr))
+            || (!mGateStates.isEmpty() && (mComputeGates == nullptr))
+            || ((mRootsCount != 0) && (mComputeRoots == nullptr))) {
             mIssues << CellmlFileIssue(CellmlFileIssue::Type::Error,
                                        tr("an unexpected problem occurred while trying to retrieve the model functions"));
 
@@ -601,6 +731,7 @@ bool CellmlFileRuntime::needNlaSolver() const
     return mAtLeastOneNlaSystem;
 }
 
+
 //==============================================================================
 
 void CellmlFileRuntime::importData(const QString &pName,
@@ -651,6 +782,15 @@ int CellmlFileRuntime::algebraicCount() const
 
 //==============================================================================
 
+int CellmlFileRuntime::rootsCount() const
+{
+    // Return the number of root functions in the model
+
+    return mRootsCount;
+}
+
+//==============================================================================
+
 CellmlFileRuntime::InitializeConstantsFunction CellmlFileRuntime::initializeConstants() const
 {
     // Return the initializeConstants function
@@ -687,6 +827,80 @@ CellmlFileRuntime::ComputeRatesFunction CellmlFileRuntime::computeRates() const
 
 //==============================================================================
 
+CellmlFileRuntime::ComputeRatesBatchFunction CellmlFileRuntime::computeRatesBatch() const
+{
+    // Return the computeRatesBatch function, if any
+
+    return mComputeRatesBatch;
+}
+
+//==============================================================================
+
+CellmlFileRuntime::ComputeJacobianFunction CellmlFileRuntime::computeJacobian() const
+{
+    // Return the computeJacobian function, if any
+
+    return mComputeJacobian;
+}
+
+//==============================================================================
+
+CellmlFileRuntime::ComputeGatesFunction CellmlFileRuntime::computeGates() const
+{
+    // Return the computeGates function, if any
+
+    return mComputeGates;
+}
+
+//==============================================================================
+
+CellmlFileRuntime::ComputeRootsFunction CellmlFileRuntime::computeRoots() const
+{
+    // Return the computeRoots function, if any
+
+    return mComputeRoots;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntime::jacobianColumnStarts() const
+{
+    // Return where each column of our Jacobian starts in its row indices
+
+    return mJacobianColumnStarts;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntime::jacobianRowIndices() const
+{
+    // Return the row index of each non-zero entry of our Jacobian
+
+    return mJacobianRowIndices;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntime::gateStates() const
+{
+    // Return the index of our states that are gates
+
+    return mGateStates;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntime::compilationReport() const
+{
+    // Return the report on the compilation of our model code, if any
+
+    return (mCompilerEngine != nullptr)?
+               mCompilerEngine->compilationReport():
+               QString();
+}
+
+//==============================================================================
+
 CellmlFileIssues CellmlFileRuntime::issues() const
 {
     // Return the issue(s)
@@ -742,6 +956,17 @@ void CellmlFileRuntime::resetFunctions()
     mComputeComputedConstants = nullptr;
     mComputeVariables = nullptr;
     mComputeRates = nullptr;
+    mComputeRatesBatch = nullptr;
+    mComputeJacobian = nullptr;
+    mComputeGates = nullptr;
+    mComputeRoots = nullptr;
+
+    mRootsCount = 0;
+
+    mJacobianColumnStarts.clear();
+    mJacobianRowIndices.clear();
+
+    mGateStates.clear();
 }
 
 //==============================================================================
@@ -859,6 +1084,85 @@ void CellmlFileRuntime::retrieveCodeInformation(iface::cellml_api::Model *pModel
 
 //==============================================================================
 
+QString CellmlFileRuntime::nlaJacobiansCode(const QString &pFunctionsString)
+{
+    // Generate, after each objective function in the given functions code, the
+    // code that computes the Jacobian of that objective function, if we can
+    // differentiate it, and pass it to our calls to doNonLinearSolve()
+    // Note #1: the Jacobian of an objective function is computed as a dense
+    //          matrix, in column-major order, since that is what our NLA
+    //          solver expects...
+    // Note #2: an objective function that solves for only one variable uses
+    //          *p and *hx rather than p[0] and hx[0], hence we replace the
+    //          former with the latter before differentiating it...
+
+    static const QRegularExpression ObjectiveFunctionRegEx = QRegularExpression(R"(void objfunc_(\d+)\([^)]*\)\s*\{\n(.*?)\n\}\n)",
+                                                                                QRegularExpression::DotMatchesEverythingOption);
+    static const QRegularExpression ParameterRegEx = QRegularExpression(R"(\bp\[(\d+)\])");
+
+    QString res = pFunctionsString;
+    QRegularExpressionMatchIterator objectiveFunctionIterator = ObjectiveFunctionRegEx.globalMatch(pFunctionsString);
+    QMap<QString, QString> jacobianFunctions;
+    int offset = 0;
+
+    while (objectiveFunctionIterator.hasNext()) {
+        QRegularExpressionMatch objectiveFunction = objectiveFunctionIterator.next();
+        QString id = objectiveFunction.captured(1);
+        QString prologue;
+        QString statements;
+        QString epilogue;
+
+        for (const auto &line : objectiveFunction.captured(2).split('\n')) {
+            QString trimmedLine = line.trimmed();
+
+            if (trimmedLine.startsWith("#undef")) {
+                epilogue += line+"\n";
+            } else if (trimmedLine.startsWith('#') || trimmedLine.startsWith("struct ")) {
+                prologue += line+"\n";
+            } else {
+                statements += line+"\n";
+            }
+        }
+
+        statements.replace(" = *p;", " = p[0];");
+        statements.replace("*hx = ", "hx[0] = ");
+
+        int size = 0;
+        QRegularExpressionMatchIterator parameterIterator = ParameterRegEx.globalMatch(statements);
+
+        while (parameterIterator.hasNext()) {
+            size = qMax(size, parameterIterator.next().captured(1).toInt()+1);
+        }
+
+        CellmlFileRuntimeJacobian jacobian(statements, "p", "hx", size);
+
+        if (jacobian.isValid()) {
+            QString jacobianCode = methodCode(QString("objjac_%1(double *p, double *J, void *adata)").arg(id),
+                                              prologue+jacobian.denseCode("J")+epilogue);
+
+            jacobianCode.chop(1);
+
+            res.insert(objectiveFunction.capturedEnd()+offset, jacobianCode);
+
+            offset += jacobianCode.size();
+
+            jacobianFunctions.insert(id, QString("objjac_%1").arg(id));
+        } else {
+            jacobianFunctions.insert(id, "0");
+        }
+    }
+
+    for (auto jacobianFunction = jacobianFunctions.constBegin(), jacobianFunctionEnd = jacobianFunctions.constEnd();
+         jacobianFunction != jacobianFunctionEnd; ++jacobianFunction) {
+        res.replace(QString("objfunc_%1, ").arg(jacobianFunction.key()),
+                    QString("objfunc_%1, %2, ").arg(jacobianFunction.key(), jacobianFunction.value()));
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 QString CellmlFileRuntime::methodCode(const QString &pCodeSignature,
                                       const QString &pCodeBody)
 {
@@ -942,22 +1246,38 @@ QString CellmlFileRuntime::cleanCode(const std::wstring &pCode)
     }
 
     // Further clean up the given code by removing any reference to a 'return'
-    // value)
+    // value), except that our rootfind_N() functions get our NLA solver
+    // instead
+    // Note: our NLA solver is passed explicitly from the method that needs to
+    //       solve an NLA system all the way down to doNonLinearSolve(), which
+    //       means that our model code doesn't hold any global state and can
+    //       therefore be used by several threads at once...
 
-    res.remove(", int* pret");
-    res.remove(", pret");
+    static const QRegularExpression RootfindCallRegEx = QRegularExpression(R"(\b(rootfind_\d+\([^)]*), pret\))");
 
     res.remove("#define pret rfi->aPRET\n");
     res.remove("#undef pret\n");
     res.remove("  rfi.aPRET = pret;\n");
 
-    // Also rename do_nonlinearsolve() to doNonLinearSolve() since CellML's CIS
+    res.replace(RootfindCallRegEx, "\\1, NLA_SOLVER)");
+    res.replace(", int* pret", ", void* NLA_SOLVER");
+
+    res.remove(", pret");
+
+    // Also make sure that the initial guess of an NLA system is not held in a
+    // static variable, which would otherwise be shared by all the instances of
+    // our model
+    // Note: our NLA solver keeps track of the solution of each of its NLA
+    //       systems and uses it as the initial guess for the next solve...
+
+    res.replace("static double ", "double ");
+
+    // Rename do_nonlinearsolve() to doNonLinearSolve() since CellML's CIS
     // service already defines do_nonlinearsolve() and, yet, we want to use our
-    // own non-linear solve routine defined in our Solver interface, and add a
-    // new parameter to all our calls to doNonLinearSolve() so that
-    // doNonLinearSolve() can retrieve the correct instance of our NLA solver
+    // own non-linear solve routine defined in our Solver interface, and add
+    // our NLA solver as a new parameter to all our calls to doNonLinearSolve()
 
-    res.replace("do_nonlinearsolve(", QString(R"(doNonLinearSolve("%1", )").arg(Solver::objectAddress(this)));
+    res.replace("do_nonlinearsolve(", "doNonLinearSolve(NLA_SOLVER, ");
 
     return res;
 }
@@ -33,9 +33,9 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include <QIcon>
 #include <QList>
 #include <QMap>
+#include <QVector>
 #ifdef Q_OS_WIN
     #include <QSet>
-    #include <QVector>
 #endif
 
 //==============================================================================
@@ -131,9 +131,13 @@ class CELLMLSUPPORT_EXPORT CellmlFileRuntime : public QObject
 
 public:
     using InitializeConstantsFunction = void (*)(double *CONSTANTS, double *RATES, double *STATES);
-    using ComputeComputedConstantsFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
-    using ComputeVariablesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
-    using ComputeRatesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
+    using ComputeComputedConstantsFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER);
+    using ComputeVariablesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER);
+    using ComputeRatesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, void *NLA_SOLVER);
+    using ComputeRatesBatchFunction = void (*)(int COUNT, double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
+    using ComputeJacobianFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *JACOBIAN);
+    using ComputeGatesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *GATES);
+    using ComputeRootsFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *ROOTS);
 
     explicit CellmlFileRuntime(CellmlFile *pCellmlFile);
     ~CellmlFileRuntime() override;
@@ -152,11 +156,23 @@ public:
     int statesCount() const;
     int ratesCount() const;
     int algebraicCount() const;
+    int rootsCount() const;
 
     InitializeConstantsFunction initializeConstants() const;
     ComputeComputedConstantsFunction computeComputedConstants() const;
     ComputeVariablesFunction computeVariables() const;
     ComputeRatesFunction computeRates() const;
+    ComputeRatesBatchFunction computeRatesBatch() const;
+    ComputeJacobianFunction computeJacobian() const;
+    ComputeGatesFunction computeGates() const;
+    ComputeRootsFunction computeRoots() const;
+
+    QVector<int> jacobianColumnStarts() const;
+    QVector<int> jacobianRowIndices() const;
+
+    QVector<int> gateStates() const;
+
+    QString compilationReport() const;
 
     CellmlFileIssues issues() const;
 
@@ -173,6 +189,7 @@ private:
     int mConstantsCount = 0;
     int mStatesRatesCount = 0;
     int mAlgebraicCount = 0;
+    int mRootsCount = 0;
 
     Compiler::CompilerEngine *mCompilerEngine = nullptr;
 
@@ -185,6 +202,15 @@ private:
     ComputeComputedConstantsFunction mComputeComputedConstants = nullptr;
     ComputeVariablesFunction mComputeVariables = nullptr;
     ComputeRatesFunction mComputeRates = nullptr;
+    ComputeRatesBatchFunction mComputeRatesBatch = nullptr;
+    ComputeJacobianFunction mComputeJacobian = nullptr;
+    ComputeGatesFunction mComputeGates = nullptr;
+    ComputeRootsFunction mComputeRoots = nullptr;
+
+    QVector<int> mJacobianColumnStarts;
+    QVector<int> mJacobianRowIndices;
+
+    QVector<int> mGateStates;
 
     void resetCodeInformation();
 
@@ -200,6 +226,7 @@ private:
     void retrieveCodeInformation(iface::cellml_api::Model *pModel);
 
     QString cleanCode(const std::wstring &pCode);
+    QString nlaJacobiansCode(const QString &pFunctionsString);
     QString methodCode(const QString &pCodeSignature, const QString &pCodeBody);
     QString methodCode(const QString &pCodeSignature,
                        const std::wstring &pCodeBody);
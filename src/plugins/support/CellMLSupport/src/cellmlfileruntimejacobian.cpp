@@ -0,0 +1,816 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// CellML file runtime Jacobian
+//==============================================================================
+
+#include "cellmlfileruntimejacobian.h"
+
+//==============================================================================
+
+#include <QRegularExpression>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace CellMLSupport {
+
+//==============================================================================
+
+static const auto Zero = QStringLiteral("0.0");
+static const auto One = QStringLiteral("1.0");
+
+//==============================================================================
+
+static const int MaximumCodeSize = 4*1024*1024;
+
+//==============================================================================
+
+static QString product(const QString &pFactor1, const QString &pFactor2)
+{
+    // Return the product of the two given factors
+
+    if (pFactor1 == One) {
+        return pFactor2;
+    }
+
+    if (pFactor2 == One) {
+        return pFactor1;
+    }
+
+    return "("+pFactor1+")*("+pFactor2+")";
+}
+
+//==============================================================================
+
+static QMap<int, QString> chain(const QMap<int, QString> &pDerivatives,
+                                const QString &pFactor)
+{
+    // Apply the chain rule, i.e. multiply the given derivatives by the given
+    // factor
+
+    QMap<int, QString> res;
+
+    for (auto derivative = pDerivatives.constBegin(), derivativeEnd = pDerivatives.constEnd();
+         derivative != derivativeEnd; ++derivative) {
+        res.insert(derivative.key(), product(derivative.value(), pFactor));
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+static QMap<int, QString> combine(const QMap<int, QString> &pDerivatives1,
+                                  const QMap<int, QString> &pDerivatives2,
+                                  const QString &pOperator)
+{
+    // Combine the two given sets of derivatives using the given operator (i.e.
+    // '+' or '-')
+
+    QMap<int, QString> res = pDerivatives1;
+
+    for (auto derivative = pDerivatives2.constBegin(), derivativeEnd = pDerivatives2.constEnd();
+         derivative != derivativeEnd; ++derivative) {
+        if (res.contains(derivative.key())) {
+            res.insert(derivative.key(), "("+res.value(derivative.key())+")"+pOperator+"("+derivative.value()+")");
+        } else {
+            res.insert(derivative.key(), (pOperator == "-")?
+                                             "-("+derivative.value()+")":
+                                             derivative.value());
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::CellmlFileRuntimeJacobian(const QString &pCode,
+                                                     const QString &pIndependentArray,
+                                                     const QString &pDependentArray,
+                                                     int pSize,
+                                                     const QSet<int> &pIndependentIndices) :
+    mIndependentArray(pIndependentArray),
+    mDependentArray(pDependentArray),
+    mSize(pSize),
+    mIndependentIndices(pIndependentIndices)
+{
+    // Differentiate the given code, which must consist of assignments only,
+    // with respect to the elements of the given independent array (or only
+    // the given ones, if any)
+    // Note #1: we use forward-mode differentiation, keeping track, for each
+    //          assigned variable, of its derivatives with respect to only the
+    //          elements of the independent array on which it actually depends,
+    //          meaning that we also get the sparsity pattern of our Jacobian
+    //          for free...
+    // Note #2: the derivatives are computed alongside the original assignments
+    //          (which we keep), so that the values of intermediate variables
+    //          are available when computing the derivatives that depend on
+    //          them...
+
+    static const QRegularExpression TokenRegEx = QRegularExpression(R"(\d+\.?\d*(?:[eE][+-]?\d+)?|\.\d+(?:[eE][+-]?\d+)?|[A-Za-z_]\w*|<=|>=|==|!=|&&|\|\||\S)");
+
+    QRegularExpressionMatchIterator tokenIterator = TokenRegEx.globalMatch(pCode);
+
+    while (tokenIterator.hasNext()) {
+        mTokens << tokenIterator.next().captured();
+    }
+
+    while (mValid && (mPosition < mTokens.count())) {
+        parseStatement();
+
+        if (mStatements.size() > MaximumCodeSize) {
+            mValid = false;
+        }
+    }
+
+    if (!mValid) {
+        return;
+    }
+
+    // Determine the sparsity pattern of our Jacobian, using a compressed
+    // sparse column format
+
+    QVector<QMap<int, QString>> columns(mSize);
+
+    for (int i = 0; i < mSize; ++i) {
+        QMap<int, QString> derivatives = mDerivatives.value(QString("%1[%2]").arg(mDependentArray).arg(i));
+
+        for (auto derivative = derivatives.constBegin(), derivativeEnd = derivatives.constEnd();
+             derivative != derivativeEnd; ++derivative) {
+            columns[derivative.key()].insert(i, derivative.value());
+        }
+    }
+
+    mColumnStarts << 0;
+
+    for (const auto &column : columns) {
+        for (auto entry = column.constBegin(), entryEnd = column.constEnd();
+             entry != entryEnd; ++entry) {
+            mRowIndices << entry.key();
+            mEntries << entry.value();
+        }
+
+        mColumnStarts << mRowIndices.count();
+    }
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::isValid() const
+{
+    // Return whether we could differentiate our code
+
+    return mValid;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::code(const QString &pJacobianArray) const
+{
+    // Return the code that computes the non-zero entries of our Jacobian, in
+    // the order given by our sparsity pattern
+
+    QString res = mStatements;
+
+    for (int i = 0, iMax = mEntries.count(); i < iMax; ++i) {
+        res += QString("%1[%2] = %3;\n").arg(pJacobianArray).arg(i).arg(mEntries[i]);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::denseCode(const QString &pJacobianArray) const
+{
+    // Return the code that computes our Jacobian as a dense matrix, stored in
+    // column-major order
+
+    QString res = QString("for (int i = 0; i < %1; ++i) {\n"
+                          "    %2[i] = 0.0;\n"
+                          "}\n").arg(mSize*mSize).arg(pJacobianArray)
+                 +mStatements;
+
+    for (int j = 0; j < mSize; ++j) {
+        for (int i = mColumnStarts[j]; i < mColumnStarts[j+1]; ++i) {
+            res += QString("%1[%2] = %3;\n").arg(pJacobianArray).arg(j*mSize+mRowIndices[i]).arg(mEntries[i]);
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::diagonalCode(const QString &pDiagonalArray) const
+{
+    // Return the code that computes the entries of the diagonal of our
+    // Jacobian that are part of our sparsity pattern
+    // Note: the other entries of the diagonal array are left untouched...
+
+    QString res = mStatements;
+
+    for (int j = 0; j < mSize; ++j) {
+        for (int i = mColumnStarts[j]; i < mColumnStarts[j+1]; ++i) {
+            if (mRowIndices[i] == j) {
+                res += QString("%1[%2] = %3;\n").arg(pDiagonalArray).arg(j).arg(mEntries[i]);
+            }
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::hasEntry(int pRow, int pColumn) const
+{
+    // Return whether the given entry of our Jacobian is part of our sparsity
+    // pattern
+
+    if (!mValid || (pColumn < 0) || (pColumn >= mSize)) {
+        return false;
+    }
+
+    for (int i = mColumnStarts[pColumn]; i < mColumnStarts[pColumn+1]; ++i) {
+        if (mRowIndices[i] == pRow) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//==============================================================================
+
+QStringList CellmlFileRuntimeJacobian::conditions() const
+{
+    // Return the relational conditions found in our code, each as an
+    // expression that changes sign whenever the condition changes value
+
+    return mConditions;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntimeJacobian::columnStarts() const
+{
+    // Return where each column of our Jacobian starts in our row indices
+
+    return mColumnStarts;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntimeJacobian::rowIndices() const
+{
+    // Return the row index of each non-zero entry of our Jacobian
+
+    return mRowIndices;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::token() const
+{
+    // Return our current token, if any
+
+    return mTokens.value(mPosition);
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::accept(const QString &pToken)
+{
+    // Move on to our next token if our current one is the given one
+
+    if (mValid && (token() == pToken)) {
+        ++mPosition;
+
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+
+void CellmlFileRuntimeJacobian::expect(const QString &pToken)
+{
+    // Move on to our next token, which must be the given one
+
+    if (!accept(pToken)) {
+        mValid = false;
+    }
+}
+
+//==============================================================================
+
+void CellmlFileRuntimeJacobian::parseStatement()
+{
+    // Parse an assignment of the form <array>[<index>] = <expression>; or
+    // [double ]<variable> = <expression>;
+    // Note: the latter form allows us to differentiate code that we have
+    //       generated ourselves (see diagonalCode())...
+
+    static const QRegularExpression IdentifierRegEx = QRegularExpression(R"(^[A-Za-z_]\w*$)");
+
+    bool declaration = accept("double");
+    QString array = token();
+
+    if (!IdentifierRegEx.match(array).hasMatch() || (array == mIndependentArray)) {
+        mValid = false;
+
+        return;
+    }
+
+    ++mPosition;
+
+    QString derivativePrefix = "D_"+array+"_";
+
+    if (accept("[")) {
+        bool validIndex = false;
+        int index = token().toInt(&validIndex);
+
+        if (!mValid || !validIndex) {
+            mValid = false;
+
+            return;
+        }
+
+        ++mPosition;
+
+        expect("]");
+
+        mTarget = QString("%1[%2]").arg(array).arg(index);
+        derivativePrefix += QString("%1_").arg(index);
+    } else {
+        mTarget = array;
+    }
+
+    expect("=");
+
+    Expression expression = parseTernary();
+
+    expect(";");
+
+    if (!mValid) {
+        return;
+    }
+
+    // Compute the derivatives of our target and then our target itself
+
+    QMap<int, QString> derivatives;
+
+    for (auto derivative = expression.derivatives.constBegin(), derivativeEnd = expression.derivatives.constEnd();
+         derivative != derivativeEnd; ++derivative) {
+        QString derivativeName = derivativePrefix+QString::number(derivative.key());
+
+        if (mDeclaredDerivatives.contains(derivativeName)) {
+            mStatements += derivativeName+" = "+derivative.value()+";\n";
+        } else {
+            mStatements += "double "+derivativeName+" = "+derivative.value()+";\n";
+
+            mDeclaredDerivatives << derivativeName;
+        }
+
+        derivatives.insert(derivative.key(), derivativeName);
+    }
+
+    mStatements += QString(declaration?"double ":"")+mTarget+" = "+expression.value+";\n";
+
+    mDerivatives.insert(mTarget, derivatives);
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseTernary()
+{
+    // Parse a conditional expression
+
+    Expression res = parseLogicalOr();
+
+    if (accept("?")) {
+        Expression trueExpression = parseTernary();
+
+        expect(":");
+
+        Expression falseExpression = parseTernary();
+        QString condition = res.value;
+        QList<int> keys = trueExpression.derivatives.keys()+falseExpression.derivatives.keys();
+
+        res.value = "("+condition+"?"+trueExpression.value+":"+falseExpression.value+")";
+        res.derivatives.clear();
+
+        for (auto key : keys) {
+            res.derivatives.insert(key, "("+condition+")?("
+                                       +trueExpression.derivatives.value(key, Zero)+"):("
+                                       +falseExpression.derivatives.value(key, Zero)+")");
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseLogicalOr()
+{
+    // Parse a logical or expression, which has no derivatives
+
+    Expression res = parseLogicalAnd();
+
+    while (accept("||")) {
+        res.value = "("+res.value+"||"+parseLogicalAnd().value+")";
+        res.derivatives.clear();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseLogicalAnd()
+{
+    // Parse a logical and expression, which has no derivatives
+
+    Expression res = parseEquality();
+
+    while (accept("&&")) {
+        res.value = "("+res.value+"&&"+parseEquality().value+")";
+        res.derivatives.clear();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseEquality()
+{
+    // Parse an equality expression, which has no derivatives
+
+    Expression res = parseRelational();
+
+    forever {
+        QString currentToken = token();
+
+        if (!accept("==") && !accept("!=")) {
+            break;
+        }
+
+        res.value = "("+res.value+currentToken+parseRelational().value+")";
+        res.derivatives.clear();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseRelational()
+{
+    // Parse a relational expression, which has no derivatives, and keep track
+    // of it as a condition (i.e. u-v for u<v)
+
+    Expression res = parseAdditive();
+
+    forever {
+        QString currentToken = token();
+
+        if (   !accept("<") && !accept(">")
+            && !accept("<=") && !accept(">=")) {
+            break;
+        }
+
+        QString operand = parseAdditive().value;
+        QString condition = "("+res.value+")-("+operand+")";
+
+        if (!mConditions.contains(condition)) {
+            mConditions << condition;
+        }
+
+        res.value = "("+res.value+currentToken+operand+")";
+        res.derivatives.clear();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseAdditive()
+{
+    // Parse an additive expression
+    // Note: d(u+v) = du+dv and d(u-v) = du-dv...
+
+    Expression res = parseMultiplicative();
+
+    forever {
+        QString currentToken = token();
+
+        if (!accept("+") && !accept("-")) {
+            break;
+        }
+
+        Expression operand = parseMultiplicative();
+
+        res.value = "("+res.value+currentToken+operand.value+")";
+        res.derivatives = combine(res.derivatives, operand.derivatives, currentToken);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseMultiplicative()
+{
+    // Parse a multiplicative expression
+    // Note: d(u*v) = du*v+u*dv and d(u/v) = (du-(u/v)*dv)/v...
+
+    Expression res = parseUnary();
+
+    forever {
+        QString currentToken = token();
+
+        if (!accept("*") && !accept("/") && !accept("%")) {
+            break;
+        }
+
+        Expression operand = parseUnary();
+        QString value = "("+res.value+currentToken+operand.value+")";
+
+        if (currentToken == "*") {
+            res.derivatives = combine(chain(res.derivatives, operand.value),
+                                      chain(operand.derivatives, res.value), "+");
+        } else if (currentToken == "/") {
+            res.derivatives = chain(combine(res.derivatives,
+                                            chain(operand.derivatives, value), "-"),
+                                    "1.0/"+operand.value);
+        } else if (!res.derivatives.isEmpty() || !operand.derivatives.isEmpty()) {
+            mValid = false;
+        }
+
+        res.value = value;
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseUnary()
+{
+    // Parse a unary expression
+
+    if (accept("-")) {
+        Expression res = parseUnary();
+
+        res.value = "(-"+res.value+")";
+        res.derivatives = combine({}, res.derivatives, "-");
+
+        return res;
+    }
+
+    if (accept("+")) {
+        return parseUnary();
+    }
+
+    if (accept("!")) {
+        Expression res = parseUnary();
+
+        res.value = "(!"+res.value+")";
+        res.derivatives.clear();
+
+        return res;
+    }
+
+    return parsePrimary();
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parsePrimary()
+{
+    // Parse a primary expression, i.e. a parenthesised expression, a number,
+    // an array element, an identifier or a function call
+
+    QString currentToken = token();
+    Expression res;
+
+    if (!mValid || currentToken.isEmpty()) {
+        mValid = false;
+
+        return res;
+    }
+
+    if (accept("(")) {
+        res = parseTernary();
+
+        expect(")");
+
+        res.value = "("+res.value+")";
+
+        return res;
+    }
+
+    if (currentToken[0].isDigit() || (currentToken[0] == '.')) {
+        ++mPosition;
+
+        res.value = currentToken;
+
+        return res;
+    }
+
+    if (!currentToken[0].isLetter() && (currentToken[0] != '_')) {
+        mValid = false;
+
+        return res;
+    }
+
+    ++mPosition;
+
+    if (accept("(")) {
+        return parseFunction(currentToken);
+    }
+
+    if (accept("[")) {
+        bool validIndex = false;
+        int index = token().toInt(&validIndex);
+
+        if (!validIndex) {
+            mValid = false;
+
+            return res;
+        }
+
+        ++mPosition;
+
+        expect("]");
+
+        res.value = QString("%1[%2]").arg(currentToken).arg(index);
+
+        if (currentToken == mIndependentArray) {
+            if (index >= mSize) {
+                mValid = false;
+            } else if (mIndependentIndices.isEmpty() || mIndependentIndices.contains(index)) {
+                res.derivatives.insert(index, One);
+            }
+
+            return res;
+        }
+    } else {
+        res.value = currentToken;
+    }
+
+    if (res.value == mTarget) {
+        // Our target depends on itself, which we don't support since its new
+        // derivatives would then overwrite the ones on which they depend
+
+        mValid = false;
+    } else {
+        res.derivatives = mDerivatives.value(res.value);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::Expression CellmlFileRuntimeJacobian::parseFunction(const QString &pName)
+{
+    // Parse the arguments of a function call and differentiate it
+
+    static const QMap<QString, QString> Derivatives = {
+                                                          { "exp", "exp(%1)" },
+                                                          { "log", "1.0/(%1)" },
+                                                          { "fabs", "(((%1)<0.0)?-1.0:1.0)" },
+                                                          { "sin", "cos(%1)" },
+                                                          { "cos", "-sin(%1)" },
+                                                          { "tan", "1.0/(cos(%1)*cos(%1))" },
+                                                          { "sinh", "cosh(%1)" },
+                                                          { "cosh", "sinh(%1)" },
+                                                          { "tanh", "1.0-tanh(%1)*tanh(%1)" },
+                                                          { "asin", "1.0/pow(1.0-(%1)*(%1),0.5)" },
+                                                          { "acos", "-1.0/pow(1.0-(%1)*(%1),0.5)" },
+                                                          { "atan", "1.0/(1.0+(%1)*(%1))" },
+                                                          { "asinh", "1.0/pow((%1)*(%1)+1.0,0.5)" },
+                                                          { "acosh", "1.0/pow((%1)*(%1)-1.0,0.5)" },
+                                                          { "atanh", "1.0/(1.0-(%1)*(%1))" },
+                                                          { "sec", "sec(%1)*tan(%1)" },
+                                                          { "sech", "-sech(%1)*tanh(%1)" },
+                                                          { "asec", "1.0/(fabs(%1)*pow((%1)*(%1)-1.0,0.5))" },
+                                                          { "asech", "-1.0/((%1)*pow(1.0-(%1)*(%1),0.5))" },
+                                                          { "csc", "-csc(%1)*cot(%1)" },
+                                                          { "csch", "-csch(%1)*coth(%1)" },
+                                                          { "acsc", "-1.0/(fabs(%1)*pow((%1)*(%1)-1.0,0.5))" },
+                                                          { "acsch", "-1.0/(fabs(%1)*pow(1.0+(%1)*(%1),0.5))" },
+                                                          { "cot", "-1.0/(sin(%1)*sin(%1))" },
+                                                          { "coth", "-1.0/(sinh(%1)*sinh(%1))" },
+                                                          { "acot", "-1.0/(1.0+(%1)*(%1))" },
+                                                          { "acoth", "1.0/(1.0-(%1)*(%1))" }
+                                                      };
+    static const QStringList PiecewiseConstantFunctions = { "floor", "ceil", "gcd_multi", "lcm_multi" };
+
+    QList<Expression> arguments;
+    QStringList values;
+    bool hasDerivatives = false;
+
+    if (!accept(")")) {
+        do {
+            arguments << parseTernary();
+            values << arguments.last().value;
+
+            hasDerivatives = hasDerivatives || !arguments.last().derivatives.isEmpty();
+        } while (accept(","));
+
+        expect(")");
+    }
+
+    Expression res;
+
+    res.value = pName+"("+values.join(",")+")";
+
+    if (!hasDerivatives || PiecewiseConstantFunctions.contains(pName)) {
+        return res;
+    }
+
+    if ((arguments.count() == 1) && Derivatives.contains(pName)) {
+        // d(f(u)) = f'(u)*du
+
+        res.derivatives = chain(arguments[0].derivatives,
+                                Derivatives.value(pName).arg(values[0]));
+    } else if ((arguments.count() == 2) && (pName == "pow")) {
+        // d(u^v) = v*u^(v-1)*du if v is constant, and u^v*(dv*log(u)+v*du/u)
+        // otherwise
+
+        if (arguments[1].derivatives.isEmpty()) {
+            res.derivatives = chain(arguments[0].derivatives,
+                                    "("+values[1]+")*pow("+values[0]+",("+values[1]+")-1.0)");
+        } else {
+            res.derivatives = chain(combine(chain(arguments[1].derivatives, "log("+values[0]+")"),
+                                            chain(arguments[0].derivatives, "("+values[1]+")/("+values[0]+")"), "+"),
+                                    res.value);
+        }
+    } else if ((arguments.count() == 2) && (pName == "arbitrary_log")) {
+        // d(log_b(u)) = du/(u*log(b))-log(u)*db/(b*log(b)^2)
+
+        res.derivatives = combine(chain(arguments[0].derivatives, "1.0/(("+values[0]+")*log("+values[1]+"))"),
+                                  chain(arguments[1].derivatives, "log("+values[0]+")/(("+values[1]+")*log("+values[1]+")*log("+values[1]+"))"), "-");
+    } else if (   ((pName == "multi_min") || (pName == "multi_max"))
+               && (arguments.count() > 1) && arguments[0].derivatives.isEmpty()) {
+        // The derivative of a minimum/maximum is that of the argument that is
+        // the minimum/maximum
+
+        QList<int> keys;
+
+        for (int i = 1, iMax = arguments.count(); i < iMax; ++i) {
+            keys << arguments[i].derivatives.keys();
+        }
+
+        for (auto key : keys) {
+            QString derivative = arguments.last().derivatives.value(key, Zero);
+
+            for (int i = arguments.count()-2; i >= 1; --i) {
+                derivative = "(("+values[i]+")=="+res.value+")?("+arguments[i].derivatives.value(key, Zero)+"):("+derivative+")";
+            }
+
+            res.derivatives.insert(key, derivative);
+        }
+    } else {
+        // We don't know how to differentiate this function
+
+        mValid = false;
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+} // namespace CellMLSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
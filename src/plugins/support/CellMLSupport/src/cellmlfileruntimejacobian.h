@@ -0,0 +1,121 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// CellML file runtime Jacobian
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "cellmlsupportglobal.h"
+
+//==============================================================================
+
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace CellMLSupport {
+
+//==============================================================================
+
+class CELLMLSUPPORT_EXPORT CellmlFileRuntimeJacobian
+{
+public:
+    explicit CellmlFileRuntimeJacobian(const QString &pCode,
+                                       const QString &pIndependentArray,
+                                       const QString &pDependentArray,
+                                       int pSize,
+                                       const QSet<int> &pIndependentIndices = {});
+
+    bool isValid() const;
+
+    QString code(const QString &pJacobianArray) const;
+    QString denseCode(const QString &pJacobianArray) const;
+    QString diagonalCode(const QString &pDiagonalArray) const;
+
+    bool hasEntry(int pRow, int pColumn) const;
+
+    QStringList conditions() const;
+
+    QVector<int> columnStarts() const;
+    QVector<int> rowIndices() const;
+
+private:
+    struct Expression
+    {
+        QString value;
+        QMap<int, QString> derivatives;
+    };
+
+    QString mIndependentArray;
+    QString mDependentArray;
+    int mSize;
+    QSet<int> mIndependentIndices;
+
+    bool mValid = true;
+
+    QStringList mTokens;
+    int mPosition = 0;
+
+    QString mStatements;
+
+    QMap<QString, QMap<int, QString>> mDerivatives;
+    QSet<QString> mDeclaredDerivatives;
+    QString mTarget;
+
+    QVector<int> mColumnStarts;
+    QVector<int> mRowIndices;
+    QStringList mEntries;
+
+    QStringList mConditions;
+
+    QString token() const;
+    bool accept(const QString &pToken);
+    void expect(const QString &pToken);
+
+    void parseStatement();
+
+    Expression parseTernary();
+    Expression parseLogicalOr();
+    Expression parseLogicalAnd();
+    Expression parseEquality();
+    Expression parseRelational();
+    Expression parseAdditive();
+    Expression parseMultiplicative();
+    Expression parseUnary();
+    Expression parsePrimary();
+    Expression parseFunction(const QString &pName);
+};
+
+//==============================================================================
+
+} // namespace CellMLSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
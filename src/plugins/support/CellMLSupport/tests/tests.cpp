@@ -134,6 +134,243 @@ void Tests::runtimeTests()
 
 //==============================================================================
 
+void Tests::batchTests()
+{
+    // Retrieve a runtime for the Noble 1962 model and initialise four instances
+    // of it, each with slightly different states
+
+    static const int Count = 4;
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(OpenCOR::fileName("models/noble_model_1962.cellml"));
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeRatesBatch() != nullptr);
+
+    int constantsCount = runtime->constantsCount();
+    int ratesCount = runtime->ratesCount();
+    int statesCount = runtime->statesCount();
+    int algebraicCount = runtime->algebraicCount();
+    QVector<QVector<double>> constants(Count, QVector<double>(constantsCount));
+    QVector<QVector<double>> rates(Count, QVector<double>(ratesCount));
+    QVector<QVector<double>> states(Count, QVector<double>(statesCount));
+    QVector<QVector<double>> algebraic(Count, QVector<double>(algebraicCount));
+
+    for (int i = 0; i < Count; ++i) {
+        runtime->initializeConstants()(constants[i].data(), rates[i].data(), states[i].data());
+        runtime->computeComputedConstants()(0.0, constants[i].data(), rates[i].data(), states[i].data(), algebraic[i].data(), nullptr);
+
+        for (int j = 0; j < statesCount; ++j) {
+            states[i][j] *= 1.0+0.1*i;
+        }
+    }
+
+    // Lay out our instances using a structure-of-arrays layout and compute
+    // their rates at once
+
+    QVector<double> batchConstants(constantsCount*Count);
+    QVector<double> batchRates(ratesCount*Count);
+    QVector<double> batchStates(statesCount*Count);
+    QVector<double> batchAlgebraic(algebraicCount*Count);
+
+    for (int i = 0; i < Count; ++i) {
+        for (int j = 0; j < constantsCount; ++j) {
+            batchConstants[j*Count+i] = constants[i][j];
+        }
+
+        for (int j = 0; j < statesCount; ++j) {
+            batchStates[j*Count+i] = states[i][j];
+        }
+    }
+
+    runtime->computeRatesBatch()(Count, 0.0, batchConstants.data(), batchRates.data(), batchStates.data(), batchAlgebraic.data());
+
+    // Make sure that we get the same rates as when computing our instances one
+    // at a time
+
+    for (int i = 0; i < Count; ++i) {
+        runtime->computeRates()(0.0, constants[i].data(), rates[i].data(), states[i].data(), algebraic[i].data(), nullptr);
+
+        for (int j = 0; j < ratesCount; ++j) {
+            QVERIFY(qFuzzyCompare(1.0+batchRates[j*Count+i], 1.0+rates[i][j]));
+        }
+    }
+}
+
+//==============================================================================
+
+void Tests::jacobianTests()
+{
+    // Retrieve a runtime for the Noble 1962 model and compute the Jacobian of
+    // its rates with respect to its states
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(OpenCOR::fileName("models/noble_model_1962.cellml"));
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeJacobian() != nullptr);
+
+    int statesCount = runtime->statesCount();
+    QVector<double> constants(runtime->constantsCount());
+    QVector<double> rates(runtime->ratesCount());
+    QVector<double> states(statesCount);
+    QVector<double> algebraic(runtime->algebraicCount());
+    QVector<int> columnStarts = runtime->jacobianColumnStarts();
+    QVector<int> rowIndices = runtime->jacobianRowIndices();
+    QVector<double> jacobian(rowIndices.count());
+
+    QCOMPARE(columnStarts.count(), statesCount+1);
+    QCOMPARE(columnStarts.last(), rowIndices.count());
+
+    runtime->initializeConstants()(constants.data(), rates.data(), states.data());
+    runtime->computeComputedConstants()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), nullptr);
+    runtime->computeJacobian()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), jacobian.data());
+
+    // Make sure that our Jacobian matches the one that we get using central
+    // finite differences, and that the entries that are not part of its
+    // sparsity pattern are indeed zero
+
+    QVector<double> ratesPlus(rates.count());
+    QVector<double> ratesMinus(rates.count());
+
+    for (int j = 0; j < statesCount; ++j) {
+        double state = states[j];
+        double delta = 1.0e-6*qMax(1.0, qAbs(state));
+
+        states[j] = state+delta;
+
+        runtime->computeRates()(0.0, constants.data(), ratesPlus.data(), states.data(), algebraic.data(), nullptr);
+
+        states[j] = state-delta;
+
+        runtime->computeRates()(0.0, constants.data(), ratesMinus.data(), states.data(), algebraic.data(), nullptr);
+
+        states[j] = state;
+
+        QVector<double> column(statesCount);
+
+        for (int k = columnStarts[j]; k < columnStarts[j+1]; ++k) {
+            column[rowIndices[k]] = jacobian[k];
+        }
+
+        for (int i = 0; i < statesCount; ++i) {
+            double finiteDifference = (ratesPlus[i]-ratesMinus[i])/(2.0*delta);
+
+            QVERIFY(qAbs(column[i]-finiteDifference) <= 1.0e-4*qMax(1.0, qAbs(finiteDifference)));
+        }
+    }
+}
+
+//==============================================================================
+
+void Tests::gatesTests()
+{
+    // Retrieve a runtime for the Noble 1962 model and make sure that it has
+    // gates (i.e. m, h and n, at least)
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(OpenCOR::fileName("models/noble_model_1962.cellml"));
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeGates() != nullptr);
+
+    QVector<int> gateStates = runtime->gateStates();
+
+    QVERIFY(gateStates.count() >= 3);
+
+    int statesCount = runtime->statesCount();
+    QVector<double> constants(runtime->constantsCount());
+    QVector<double> rates(runtime->ratesCount());
+    QVector<double> gatesRates(runtime->ratesCount());
+    QVector<double> states(statesCount);
+    QVector<double> algebraic(runtime->algebraicCount());
+    QVector<double> gates(statesCount);
+
+    runtime->initializeConstants()(constants.data(), rates.data(), states.data());
+    runtime->computeComputedConstants()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), nullptr);
+    runtime->computeRates()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), nullptr);
+    runtime->computeGates()(0.0, constants.data(), gatesRates.data(), states.data(), algebraic.data(), gates.data());
+
+    // Make sure that our rates are the same as the ones computed by
+    // computeRates()
+
+    for (int i = 0; i < statesCount; ++i) {
+        QCOMPARE(gatesRates[i], rates[i]);
+    }
+
+    // Make sure that the rate of each gate is linear in the gate itself, with
+    // the coefficient that we were given
+
+    QVector<double> ratesPlus(rates.count());
+
+    for (auto i : gateStates) {
+        double state = states[i];
+
+        states[i] = state+1.0;
+
+        runtime->computeRates()(0.0, constants.data(), ratesPlus.data(), states.data(), algebraic.data(), nullptr);
+
+        states[i] = state;
+
+        QVERIFY(qAbs(ratesPlus[i]-rates[i]-gates[i]) <= 1.0e-9*qMax(1.0, qAbs(gates[i])));
+    }
+}
+
+//==============================================================================
+
+void Tests::rootsTests()
+{
+    // Retrieve a runtime for the Hodgkin-Huxley 1952 model and make sure that
+    // it has root functions for its stimulus (i.e. at least one for its start
+    // and one for its end)
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(OpenCOR::fileName("models/hodgkin_huxley_squid_axon_model_1952.cellml"));
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeRoots() != nullptr);
+    QVERIFY(runtime->rootsCount() >= 2);
+
+    QVector<double> constants(runtime->constantsCount());
+    QVector<double> rates(runtime->ratesCount());
+    QVector<double> states(runtime->statesCount());
+    QVector<double> algebraic(runtime->algebraicCount());
+    QVector<double> roots(runtime->rootsCount());
+    QVector<double> stimulusRoots(runtime->rootsCount());
+    QVector<double> afterStimulusRoots(runtime->rootsCount());
+
+    runtime->initializeConstants()(constants.data(), rates.data(), states.data());
+    runtime->computeComputedConstants()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), nullptr);
+    runtime->computeRoots()(0.0, constants.data(), rates.data(), states.data(), algebraic.data(), roots.data());
+    runtime->computeRoots()(10.25, constants.data(), rates.data(), states.data(), algebraic.data(), stimulusRoots.data());
+    runtime->computeRoots()(20.0, constants.data(), rates.data(), states.data(), algebraic.data(), afterStimulusRoots.data());
+
+    // Make sure that at least one of our root functions changes sign when
+    // our stimulus starts and at least one when it ends
+
+    int startRoots = 0;
+    int endRoots = 0;
+
+    for (int i = 0, iMax = roots.count(); i < iMax; ++i) {
+        if (roots[i]*stimulusRoots[i] < 0.0) {
+            ++startRoots;
+        }
+
+        if (stimulusRoots[i]*afterStimulusRoots[i] < 0.0) {
+            ++endRoots;
+        }
+    }
+
+    QVERIFY(startRoots >= 1);
+    QVERIFY(endRoots >= 1);
+}
+
+//==============================================================================
+
 QTEST_GUILESS_MAIN(Tests)
 
 //==============================================================================
@@ -39,6 +39,10 @@ private:
 
 private slots:
     void runtimeTests();
+    void batchTests();
+    void jacobianTests();
+    void gatesTests();
+    void rootsTests();
 };
 
 //==============================================================================
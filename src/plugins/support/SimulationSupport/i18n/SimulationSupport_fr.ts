@@ -15,6 +15,26 @@
         <source>the starting point cannot be greater than the ending point</source>
         <translation>le point de départ ne peut pas être plus grand que le point d&apos;arrivée</translation>
     </message>
+    <message>
+        <source>an ensemble must have at least one member</source>
+        <translation>un ensemble doit avoir au moins un membre</translation>
+    </message>
+    <message>
+        <source>the same number of constants and states vectors must be provided</source>
+        <translation>le même nombre de vecteurs de constantes et d&apos;états doit être fourni</translation>
+    </message>
+    <message>
+        <source>a constants vector must have %1 values</source>
+        <translation>un vecteur de constantes doit avoir %1 valeurs</translation>
+    </message>
+    <message>
+        <source>a states vector must have %1 values</source>
+        <translation>un vecteur d&apos;états doit avoir %1 valeurs</translation>
+    </message>
+    <message>
+        <source>the memory required for the ensemble could not be allocated</source>
+        <translation>la mémoire requise pour l&apos;ensemble n&apos;a pas pu être allouée</translation>
+    </message>
 </context>
 <context>
     <name>OpenCOR::SimulationSupport::SimulationSupportPythonWrapper</name>
@@ -30,6 +50,10 @@
         <source>The memory required for the simulation could not be allocated.</source>
         <translation>La mémoire requise pour la simulation n&apos;a pas pu être allouée.</translation>
     </message>
+    <message>
+        <source>The ensemble could not be run.</source>
+        <translation>L&apos;ensemble n&apos;a pas pu être exécuté.</translation>
+    </message>
 </context>
 <context>
     <name>QObject</name>
@@ -53,6 +77,10 @@
         <source>The requested solver (%1) could not be found.</source>
         <translation>Le solveur demandé (%1) n&apos;a pas pu être trouvé.</translation>
     </message>
+    <message>
+        <source>Ensemble values must be numbers.</source>
+        <translation>Les valeurs d&apos;un ensemble doivent être des nombres.</translation>
+    </message>
     <message>
         <source>unable to close the simulation.</source>
         <translation>incapable de fermer la simulation.</translation>
@@ -24,15 +24,18 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include "cellmlfilemanager.h"
 #include "cellmlfileruntime.h"
 #include "combinefilemanager.h"
+#include "corecliutils.h"
 #include "filemanager.h"
 #include "interfaces.h"
 #include "sedmlfilemanager.h"
 #include "simulation.h"
+#include "simulationensemble.h"
 #include "simulationworker.h"
 
 //==============================================================================
 
 #include <QThread>
+#include <QVarLengthArray>
 
 //==============================================================================
 
@@ -534,8 +537,6 @@ void SimulationData::reset(bool pInitialize, bool pAll)
 
         nlaSolver = static_cast<Solver::NlaSolver *>(nlaSolverInterface()->solverInstance());
 
-        Solver::setNlaSolver(runtime, nlaSolver);
-
         // Keep track of any error that might be reported by our NLA solver
 
         connect(nlaSolver, &Solver::NlaSolver::error,
@@ -567,7 +568,8 @@ void SimulationData::reset(bool pInitialize, bool pAll)
 
     // Recompute our computed constants and variables
 
-    recomputeComputedConstantsAndVariables(mStartingPoint, pInitialize);
+    recomputeComputedConstantsAndVariables(mStartingPoint, pInitialize,
+                                           nlaSolver);
 
     // Keep track of our various initial values
 
@@ -587,7 +589,8 @@ void SimulationData::reset(bool pInitialize, bool pAll)
     // "current" constants
 
     if (!pAll) {
-        recomputeComputedConstantsAndVariables(mStartingPoint, pInitialize);
+        recomputeComputedConstantsAndVariables(mStartingPoint, pInitialize,
+                                               nlaSolver);
     }
 
     // Delete our NLA solver, if any
@@ -626,10 +629,11 @@ void SimulationData::updateInitialValues()
 //==============================================================================
 
 void SimulationData::recomputeComputedConstantsAndVariables(double pCurrentPoint,
-                                                            bool pInitialize)
+                                                            bool pInitialize,
+                                                            Solver::NlaSolver *pNlaSolver)
 {
     // Recompute our 'computed constants', some 'constant' algebraic variables
-    // and our 'variables'
+    // and our 'variables', using the given NLA solver, if our model needs one
 
     CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
 
@@ -637,9 +641,9 @@ void SimulationData::recomputeComputedConstantsAndVariables(double pCurrentPoint
                                         pInitialize?
                                             states():
                                             mDummyStates,
-                                        algebraic());
-    runtime->computeRates()(pCurrentPoint, constants(), rates(), states(), algebraic());
-    runtime->computeVariables()(pCurrentPoint, constants(), rates(), states(), algebraic());
+                                        algebraic(), pNlaSolver);
+    runtime->computeRates()(pCurrentPoint, constants(), rates(), states(), algebraic(), pNlaSolver);
+    runtime->computeVariables()(pCurrentPoint, constants(), rates(), states(), algebraic(), pNlaSolver);
 
     // Let people know that our data has been updated
 
@@ -648,14 +652,16 @@ void SimulationData::recomputeComputedConstantsAndVariables(double pCurrentPoint
 
 //==============================================================================
 
-void SimulationData::recomputeVariables(double pCurrentPoint)
+void SimulationData::recomputeVariables(double pCurrentPoint,
+                                        Solver::NlaSolver *pNlaSolver)
 {
-    // Recompute our 'variables'
+    // Recompute our 'variables', using the given NLA solver, if our model needs
+    // one
 
     CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
 
-    runtime->computeRates()(pCurrentPoint, constants(), rates(), states(), algebraic());
-    runtime->computeVariables()(pCurrentPoint, constants(), rates(), states(), algebraic());
+    runtime->computeRates()(pCurrentPoint, constants(), rates(), states(), algebraic(), pNlaSolver);
+    runtime->computeVariables()(pCurrentPoint, constants(), rates(), states(), algebraic(), pNlaSolver);
 }
 
 //==============================================================================
@@ -827,6 +833,119 @@ SimulationDataUpdatedFunction & SimulationData::simulationDataUpdatedFunction()
 
 //==============================================================================
 
+SimulationImportedData::SimulationImportedData(DataStore::DataStoreVariable *pVoi,
+                                               const DataStore::DataStoreVariables &pVariables) :
+    mVoiValues(pVoi->values()),
+    mSize(pVoi->size())
+{
+    // Keep track of the values of our VOI and variables
+    // Note: the values of a data store run never move (see DataStoreArray), so
+    //       we can safely keep track of them...
+
+    for (auto variable : pVariables) {
+        mVariablesValues << variable->values();
+    }
+}
+
+//==============================================================================
+
+int SimulationImportedData::variablesCount() const
+{
+    // Return our number of variables
+
+    return mVariablesValues.count();
+}
+
+//==============================================================================
+
+void SimulationImportedData::values(double pPoint, double *pValues) const
+{
+    // Return, in the given array, the value of our variables at the given
+    // point, doing a linear interpolation, if needed
+
+    int variablesCount = mVariablesValues.count();
+
+    if (   (mSize == 0)
+        || !((pPoint >= mVoiValues[0]) && (pPoint <= mVoiValues[mSize-1]))) {
+        for (int i = 0; i < variablesCount; ++i) {
+            pValues[i] = qQNaN();
+        }
+
+        return;
+    }
+
+    // Determine the position of the last VOI value that is not greater than
+    // the given point, starting from our previous position and galloping
+    // towards the given point before doing a binary search
+    // Note #1: our points normally increase, so we are typically only one step
+    //          away from our new position...
+    // Note #2: we may be used by several threads at once (e.g. by the members
+    //          of an ensemble), in which case our previous position is only a
+    //          hint, hence it is fine for it to be overwritten by another
+    //          thread...
+
+    quint64 position = qMin(mPosition.load(), mSize-1);
+    quint64 low;
+    quint64 high;
+    quint64 step = 1;
+
+    if (mVoiValues[position] > pPoint) {
+        high = position;
+
+        while ((step <= position) && (mVoiValues[position-step] > pPoint)) {
+            high = position-step;
+            step *= 2;
+        }
+
+        low = (step <= position)?
+                  position-step:
+                  0;
+    } else {
+        low = position;
+
+        while ((position+step < mSize) && (mVoiValues[position+step] <= pPoint)) {
+            low = position+step;
+            step *= 2;
+        }
+
+        high = qMin(position+step, mSize);
+    }
+
+    while (high-low > 1) {
+        quint64 middle = low+(high-low)/2;
+
+        if (mVoiValues[middle] <= pPoint) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    mPosition.store(low);
+
+    // Compute the value of our variables, using the same VOI values for all of
+    // them
+
+    double lowVoiValue = mVoiValues[low];
+
+    if ((low == mSize-1) || (lowVoiValue == pPoint)) {
+        for (int i = 0; i < variablesCount; ++i) {
+            pValues[i] = mVariablesValues[i][low];
+        }
+    } else {
+        double ratio = (pPoint-lowVoiValue)/(mVoiValues[low+1]-lowVoiValue);
+
+        for (int i = 0; i < variablesCount; ++i) {
+            const double *variableValues = mVariablesValues[i];
+            double lowValue = variableValues[low];
+
+            pValues[i] = lowValue+ratio*(variableValues[low+1]-lowValue);
+        }
+    }
+}
+
+//==============================================================================
+
 SimulationResults::SimulationResults(Simulation *pSimulation) :
     SimulationObject(pSimulation)
 {
@@ -840,8 +959,14 @@ SimulationResults::SimulationResults(Simulation *pSimulation) :
 SimulationResults::~SimulationResults()
 {
     // Delete some internal objects
+    // Note: our temporary directory must be deleted after our data store since
+    //       the latter may have some files in the former...
 
     deleteDataStore();
+
+    delete mTemporaryDirectory;
+
+    qDeleteAll(mDataImportedData);
 }
 
 //==============================================================================
@@ -937,12 +1062,7 @@ void SimulationResults::createDataStore()
 
         mData.insert(data, variables);
 
-        DataStore::DataStoreVariable *importVoi = importDataStore->voi();
-        DataStore::DataStoreVariables importVariables = importDataStore->variables();
-
-        for (int i = 0, iMax = importVariables.count(); i < iMax; ++i) {
-            data[i] = realValue(mSimulation->currentPoint(), importVoi, importVariables[i]);
-        }
+        mDataImportedData.value(data)->values(mSimulation->currentPoint(), data);
     }
 
     // Let people know that our (imported) data, if any, has been updated
@@ -983,7 +1103,10 @@ void SimulationResults::reload()
     // our imported data stores (since we don't keep track of imported data when
     // reloading a file)
 
+    qDeleteAll(mDataImportedData);
+
     mDataDataStores.clear();
+    mDataImportedData.clear();
 
     reset();
 }
@@ -1023,6 +1146,18 @@ void SimulationResults::importData(DataStore::DataStoreImportData *pImportData)
     mData.insert(resultsValues, resultsVariables);
     mDataDataStores.insert(resultsValues, importDataStore);
 
+    // Keep track of our imported data, so that we can interpolate it at any
+    // point
+    // Note: we use the variables of our import data store in the order in
+    //       which they were added, i.e. in the same order as our results
+    //       variables, rather than call DataStore::variables(), which sorts
+    //       them...
+
+    auto importedData = new SimulationImportedData(importDataStore->voi(),
+                                                   pImportData->importVariables());
+
+    mDataImportedData.insert(resultsValues, importedData);
+
     // Customise our imported data
 
     for (auto parameter : runtime->dataParameters(resultsValues)) {
@@ -1036,24 +1171,35 @@ void SimulationResults::importData(DataStore::DataStoreImportData *pImportData)
 
     // Compute the values of our imported data, so we can plot it straightaway
     // along our other simulation results, if any
+    // Note: we compute our values a block of points at a time, so that we can
+    //       add them to our results variables in one go...
 
     int runsCount = pImportData->runSizes().count();
-    DataStore::DataStoreVariable *importVoi = importDataStore->voi();
-    DataStore::DataStoreVariables importVariables = pImportData->importVariables();
+    int variablesCount = resultsVariables.count();
 
     if (runsCount != 0) {
+        static const quint64 BlockSize = 4096;
+
         DataStore::DataStoreVariable *resultsVoi = pImportData->resultsDataStore()->voi();
+        QVector<double> values(int(BlockSize)*variablesCount);
 
         for (int i = 0; i < runsCount; ++i) {
             // Add the value of our imported data to our the corresponding run
 
             double *voiValues = resultsVoi->values(i);
+            double realPointOffset = realPoint(0.0, i);
+
+            for (quint64 j = 0, jMax = resultsVoi->size(i); j < jMax; j += BlockSize) {
+                quint64 count = qMin(BlockSize, jMax-j);
 
-            for (quint64 j = 0, jMax = resultsVoi->size(i); j < jMax; ++j) {
-                double realPoint = SimulationResults::realPoint(voiValues[j], i);
+                for (quint64 k = 0; k < count; ++k) {
+                    importedData->values(realPointOffset+voiValues[j+k],
+                                         values.data()+k*quint64(variablesCount));
+                }
 
-                for (int k = 0, kMax = resultsVariables.count(); k < kMax; ++k) {
-                    resultsVariables[k]->addValue(realValue(realPoint, importVoi, importVariables[k]), i);
+                for (int k = 0; k < variablesCount; ++k) {
+                    resultsVariables[k]->addValues(values.constData()+k, count,
+                                                   quint64(variablesCount), i);
                 }
             }
         }
@@ -1063,16 +1209,14 @@ void SimulationResults::importData(DataStore::DataStoreImportData *pImportData)
 
         quint64 lastPosition = size()-1;
 
-        for (int i = 0, iMax = resultsVariables.count(); i < iMax; ++i) {
+        for (int i = 0; i < variablesCount; ++i) {
             resultsValues[i] = resultsVariables[i]->value(lastPosition);
         }
     } else {
         // There are no runs, so update our imported data array so that it
         // contains the computed values for our start point
 
-        for (int i = 0, iMax = importVariables.count(); i < iMax; ++i) {
-            resultsValues[i] = realValue(mSimulation->currentPoint(), importVoi, importVariables[i]);
-        }
+        importedData->values(mSimulation->currentPoint(), resultsValues);
     }
 }
 
@@ -1099,6 +1243,29 @@ bool SimulationResults::addRun()
     quint64 simulationSize = mSimulation->size();
 
     if (simulationSize != 0) {
+        // Determine where our run should be stored, i.e. in our directory, if
+        // we have one, or in memory, unless it would require more memory than
+        // is available, in which case we use a temporary directory
+        // Note: in the case of a directory, our run is stored in a file that is
+        //       mapped in memory, so it is up to the OS to page our results in
+        //       and out...
+
+        QString directory = mDirectory;
+
+        if (directory.isEmpty()) {
+            quint64 requiredMemory = quint64(mDataStore->variables().count()+1)*simulationSize*Solver::SizeOfDouble;
+
+            if (requiredMemory > Core::freeMemory()) {
+                if (mTemporaryDirectory == nullptr) {
+                    mTemporaryDirectory = new QTemporaryDir();
+                }
+
+                directory = mTemporaryDirectory->path();
+            }
+        }
+
+        mDataStore->setDirectory(directory);
+
         bool res = mDataStore->addRun(simulationSize);
 
         if (res) {
@@ -1133,81 +1300,146 @@ double SimulationResults::realPoint(double pPoint, int pRun) const
 
 //==============================================================================
 
-double SimulationResults::realValue(double pPoint,
-                                    DataStore::DataStoreVariable *pVoi,
-                                    DataStore::DataStoreVariable *pVariable) const
-{
-    // Return the value of the given variable at the given point, doing a linear
-    // interpolation, if needed
+void SimulationResults::addPoints(double *pPoints, quint64 pCount,
+                                  bool pRecomputeVariables)
+{
+    // Add the given points to our current run
+    // Note #1: each point consists of the value of our VOI followed by the
+    //          value of our constants, rates, states and algebraic variables,
+    //          i.e. it is laid out as by SimulationWorker...
+    // Note #2: we are called from our results writer's thread, so we don't
+    //          want to rely on DataStore::addValues(), which works from our
+    //          simulation's data, hence we add our values column by column.
+    //          Also, as for DataStore::addValues(), we must add the VOI values
+    //          last, since the size of our data store is that of our VOI...
+
+    int constantsCount = mConstantsVariables.count();
+    int ratesCount = mRatesVariables.count();
+    int statesCount = mStatesVariables.count();
+    int algebraicCount = mAlgebraicVariables.count();
+    quint64 pointSize = quint64(1+constantsCount+ratesCount+statesCount+algebraicCount);
+    double *constants = pPoints+1;
+    double *rates = constants+constantsCount;
+    double *states = rates+ratesCount;
+    double *algebraic = states+statesCount;
+
+    // Make sure that all our variables are up to date, if needed
+    // Note: we are never asked to recompute our variables if our model needs
+    //       an NLA solver (see SimulationWorker::run()), hence we don't pass
+    //       one to our model functions...
+
+    if (pRecomputeVariables) {
+        CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
+        CellMLSupport::CellmlFileRuntime::ComputeRatesFunction computeRates = runtime->computeRates();
+        CellMLSupport::CellmlFileRuntime::ComputeVariablesFunction computeVariables = runtime->computeVariables();
+
+        for (quint64 i = 0; i < pCount; ++i) {
+            quint64 offset = i*pointSize;
+
+            computeRates(pPoints[offset], constants+offset, rates+offset,
+                         states+offset, algebraic+offset, nullptr);
+            computeVariables(pPoints[offset], constants+offset, rates+offset,
+                             states+offset, algebraic+offset, nullptr);
+        }
+    }
 
-    quint64 first = 0;
-    quint64 last = pVoi->size()-1;
+    // Add our constants, rates, states and algebraic variables
 
-    if (   (pPoint < pVoi->value(first))
-        || (pPoint > pVoi->value(last))) {
-        return qQNaN();
+    for (int i = 0; i < constantsCount; ++i) {
+        mConstantsVariables.at(i)->addValues(constants+i, pCount, pointSize);
     }
 
-    quint64 middle = 0;
-    double middleVoiValue = 0.0;
+    for (int i = 0; i < ratesCount; ++i) {
+        mRatesVariables.at(i)->addValues(rates+i, pCount, pointSize);
+    }
 
-    while (first <= last) {
-        middle = (first+last)/2;
-        middleVoiValue = pVoi->value(middle);
+    for (int i = 0; i < statesCount; ++i) {
+        mStatesVariables.at(i)->addValues(states+i, pCount, pointSize);
+    }
 
-        if (middleVoiValue < pPoint) {
-            first = middle+1;
-        } else if (middleVoiValue > pPoint) {
-            last = middle-1;
-        } else {
-            break;
-        }
+    for (int i = 0; i < algebraicCount; ++i) {
+        mAlgebraicVariables.at(i)->addValues(algebraic+i, pCount, pointSize);
     }
 
-    if (middleVoiValue < pPoint) {
-        double afterVoiValue = pVoi->value(middle+1);
-        double afterDataValue = pVariable->value(middle+1);
+    // Add the imported data values for our points, keeping in mind that we may
+    // have several runs, and keep track of the last ones as our current ones
 
-        return afterDataValue-(afterVoiValue-pPoint)*(afterDataValue-pVariable->value(middle))/(afterVoiValue-middleVoiValue);
-    }
+    if (!mDataImportedData.isEmpty() && (pCount != 0)) {
+        double realPointOffset = realPoint(0.0);
 
-    if (middleVoiValue > pPoint) {
-        double beforeVoiValue = pVoi->value(middle-1);
-        double beforeDataValue = pVariable->value(middle-1);
+        for (auto data = mDataImportedData.constBegin(),
+                  dataEnd = mDataImportedData.constEnd(); data != dataEnd; ++data) {
+            SimulationImportedData *importedData = data.value();
+            DataStore::DataStoreVariables variables = mData.value(data.key());
+            int variablesCount = importedData->variablesCount();
+            QVector<double> values(int(pCount)*variablesCount);
 
-        return beforeDataValue+(pPoint-beforeVoiValue)*(pVariable->value(middle)-beforeDataValue)/(middleVoiValue-beforeVoiValue);
+            for (quint64 i = 0; i < pCount; ++i) {
+                importedData->values(realPointOffset+pPoints[i*pointSize],
+                                     values.data()+i*quint64(variablesCount));
+            }
+
+            for (int i = 0; i < variablesCount; ++i) {
+                variables.at(i)->addValues(values.constData()+i, pCount,
+                                           quint64(variablesCount));
+            }
+
+            memcpy(data.key(), values.constData()+(pCount-1)*quint64(variablesCount),
+                   size_t(variablesCount)*Solver::SizeOfDouble);
+        }
     }
 
-    return pVariable->value(middle);
+    // Finally, add our VOI values
+
+    mPointsVariable->addValues(pPoints, pCount, pointSize);
 }
 
 //==============================================================================
 
-void SimulationResults::addPoint(double pPoint)
+void SimulationResults::addPoint(double pPoint, int pRun, double pRealPoint,
+                                 const double *pConstants,
+                                 const double *pRates, const double *pStates,
+                                 const double *pAlgebraic)
 {
-    // Make sure that all our variables are up to date
+    // Add the given values to the given run
+    // Note #1: this is used by ensemble members, which all have their own
+    //          arrays and their own run, so we cannot rely on
+    //          DataStore::addValues(). Also, as for DataStore::addValues(), we
+    //          must add the VOI value last...
+    // Note #2: we may be called from several threads at once, hence we use
+    //          QList::at() rather than QList::operator[]() since the latter
+    //          might detach our lists...
 
-    mSimulation->data()->recomputeVariables(pPoint);
+    for (int i = 0, iMax = mConstantsVariables.count(); i < iMax; ++i) {
+        mConstantsVariables.at(i)->addValue(pConstants[i], pRun);
+    }
 
-    // Make sure that we have the correct imported data values for the given
-    // point, keeping in mind that we may have several runs
+    for (int i = 0, iMax = mRatesVariables.count(); i < iMax; ++i) {
+        mRatesVariables.at(i)->addValue(pRates[i], pRun);
+    }
 
-    QList<double *> dataKeys = mDataDataStores.keys();
-    double realPoint = SimulationResults::realPoint(pPoint);
+    for (int i = 0, iMax = mStatesVariables.count(); i < iMax; ++i) {
+        mStatesVariables.at(i)->addValue(pStates[i], pRun);
+    }
 
-    for (auto data : dataKeys) {
-        DataStore::DataStore *dataStore = mDataDataStores.value(data);
-        DataStore::DataStoreVariable *voi = dataStore->voi();
-        DataStore::DataStoreVariables variables = dataStore->variables();
+    for (int i = 0, iMax = mAlgebraicVariables.count(); i < iMax; ++i) {
+        mAlgebraicVariables.at(i)->addValue(pAlgebraic[i], pRun);
+    }
+
+    for (auto data = mDataImportedData.constBegin(),
+              dataEnd = mDataImportedData.constEnd(); data != dataEnd; ++data) {
+        SimulationImportedData *importedData = data.value();
+        DataStore::DataStoreVariables variables = mData.value(data.key());
+        QVarLengthArray<double, 256> values(importedData->variablesCount());
 
-        for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
-            data[i] = realValue(realPoint, voi, variables[i]);
+        importedData->values(pRealPoint, values.data());
+
+        for (int i = 0, iMax = values.count(); i < iMax; ++i) {
+            variables.at(i)->addValue(values[i], pRun);
         }
     }
 
-    // Now that we are all set, we can add the data to our data store
-
-    mDataStore->addValues(pPoint);
+    mPointsVariable->addValue(pPoint, pRun);
 }
 
 //==============================================================================
@@ -1223,6 +1455,45 @@ quint64 SimulationResults::size(int pRun) const
 
 //==============================================================================
 
+QString SimulationResults::directory() const
+{
+    // Return our directory
+
+    return mDirectory;
+}
+
+//==============================================================================
+
+void SimulationResults::setDirectory(const QString &pDirectory)
+{
+    // Set our directory, i.e. where our runs are to be stored, as files, from
+    // now on
+
+    mDirectory = pDirectory;
+}
+
+//==============================================================================
+
+bool SimulationResults::loadRun(const QString &pFileName)
+{
+    // Load a run from the given file, which must have been created for a model
+    // like ours, and let people know about it, if we were able to load it
+
+    if ((mDataStore == nullptr) || mSimulation->isRunning()) {
+        return false;
+    }
+
+    bool res = mDataStore->loadRun(pFileName);
+
+    if (res) {
+        emit runAdded();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 DataStore::DataStore * SimulationResults::dataStore() const
 {
     // Return our data store
@@ -1406,10 +1677,13 @@ Simulation::Simulation(const QString &pFileName) :
 
 Simulation::~Simulation()
 {
-    // Stop our worker
+    // Stop our worker, as well as our ensemble, waiting for the latter to be
+    // done (see ~SimulationEnsemble())
 
     stop();
 
+    delete mEnsemble;
+
     // Delete some internal objects
 
     delete mRuntime;
@@ -1862,21 +2136,34 @@ bool Simulation::addRun()
 
 bool Simulation::isRunning() const
 {
-    // Return whether we are running
+    // Return whether we are running, be it a single simulation or an ensemble
 
     return (mWorker != nullptr)?
                 mWorker->isRunning():
-                false;
+                isRunningEnsemble();
 }
 
 //==============================================================================
 
 bool Simulation::isPaused() const
 {
-    // Return whether we are paused
+    // Return whether we are paused, be it a single simulation or an ensemble
 
     return (mWorker != nullptr)?
                 mWorker->isPaused():
+                (mEnsemble != nullptr)?
+                    mEnsemble->isPaused():
+                    false;
+}
+
+//==============================================================================
+
+bool Simulation::isRunningEnsemble() const
+{
+    // Return whether we are running an ensemble
+
+    return (mEnsemble != nullptr)?
+                mEnsemble->isRunning():
                 false;
 }
 
@@ -1961,7 +2248,7 @@ void Simulation::run()
     // Initialise our worker, if we don't already have one and if the simulation
     // settings we were given are sound
 
-    if ((mWorker == nullptr) && simulationSettingsOk()) {
+    if ((mWorker == nullptr) && (mEnsemble == nullptr) && simulationSettingsOk()) {
         // Create and move our worker to a thread
 
         auto thread = new QThread();
@@ -1998,35 +2285,127 @@ void Simulation::run()
 
 //==============================================================================
 
+bool Simulation::runEnsemble(const QList<QVector<double>> &pConstants,
+                             const QList<QVector<double>> &pStates)
+{
+    // Make sure that we have a runtime, that we are not already running and
+    // that the simulation settings we were given are sound
+
+    if (   (mRuntime == nullptr) || (mWorker != nullptr) || (mEnsemble != nullptr)
+        || !simulationSettingsOk()) {
+        return false;
+    }
+
+    // Make sure that the given constants and states are consistent with our
+    // model
+
+    int membersCount = qMax(pConstants.count(), pStates.count());
+
+    if (membersCount == 0) {
+        emit error(tr("an ensemble must have at least one member"));
+
+        return false;
+    }
+
+    if (   (!pConstants.isEmpty() && (pConstants.count() != membersCount))
+        || (!pStates.isEmpty() && (pStates.count() != membersCount))) {
+        emit error(tr("the same number of constants and states vectors must be provided"));
+
+        return false;
+    }
+
+    for (const auto &constants : pConstants) {
+        if (!constants.isEmpty() && (constants.count() != mRuntime->constantsCount())) {
+            emit error(tr("a constants vector must have %1 values").arg(mRuntime->constantsCount()));
+
+            return false;
+        }
+    }
+
+    for (const auto &states : pStates) {
+        if (!states.isEmpty() && (states.count() != mRuntime->statesCount())) {
+            emit error(tr("a states vector must have %1 values").arg(mRuntime->statesCount()));
+
+            return false;
+        }
+    }
+
+    // Add a run for each of our members
+
+    int firstRun = runsCount();
+
+    for (int i = 0; i < membersCount; ++i) {
+        if (!addRun()) {
+            emit error(tr("the memory required for the ensemble could not be allocated"));
+
+            return false;
+        }
+    }
+
+    // Create and start our ensemble
+
+    mEnsemble = new SimulationEnsemble(this, pConstants, pStates, firstRun,
+                                       mEnsemble);
+
+    connect(mEnsemble, &SimulationEnsemble::running,
+            this, &Simulation::running);
+    connect(mEnsemble, &SimulationEnsemble::paused,
+            this, &Simulation::paused);
+
+    connect(mEnsemble, &SimulationEnsemble::done,
+            this, &Simulation::done);
+
+    connect(mEnsemble, &SimulationEnsemble::error,
+            this, &Simulation::error);
+
+    mEnsemble->start();
+
+    return true;
+}
+
+//==============================================================================
+
 void Simulation::pause()
 {
-    // Pause our worker
+    // Pause our worker or ensemble
 
     if (mWorker != nullptr) {
         mWorker->pause();
     }
+
+    if (mEnsemble != nullptr) {
+        mEnsemble->pause();
+    }
 }
 
 //==============================================================================
 
 void Simulation::resume()
 {
-    // Resume our worker
+    // Resume our worker or ensemble
 
     if (mWorker != nullptr) {
         mWorker->resume();
     }
+
+    if (mEnsemble != nullptr) {
+        mEnsemble->resume();
+    }
 }
 
 //==============================================================================
 
 void Simulation::stop()
 {
-    // Stop our worker
+    // Stop our worker and/or ensemble
 
     if (mWorker != nullptr) {
         mWorker->stop();
     }
+
+    if (mEnsemble != nullptr) {
+        mEnsemble->stop();
+    }
 }
 
 //==============================================================================
@@ -31,6 +31,12 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QAtomicInteger>
+#include <QTemporaryDir>
+#include <QVector>
+
+//==============================================================================
+
 #include <functional>
 
 //==============================================================================
@@ -70,6 +76,7 @@ namespace SimulationSupport {
 
 class Simulation;
 class SimulationData;
+class SimulationEnsemble;
 class SimulationWorker;
 
 //==============================================================================
@@ -244,8 +251,10 @@ public slots:
     void reset(bool pInitialize = true, bool pAll = true);
 
     void recomputeComputedConstantsAndVariables(double pCurrentPoint,
-                                                bool pInitialize);
-    void recomputeVariables(double pCurrentPoint);
+                                                bool pInitialize,
+                                                Solver::NlaSolver *pNlaSolver = nullptr);
+    void recomputeVariables(double pCurrentPoint,
+                            Solver::NlaSolver *pNlaSolver = nullptr);
 
     bool isStatesModified() const;
     bool isModified() const;
@@ -257,6 +266,27 @@ public slots:
 
 //==============================================================================
 
+class SimulationImportedData
+{
+public:
+    explicit SimulationImportedData(DataStore::DataStoreVariable *pVoi,
+                                    const DataStore::DataStoreVariables &pVariables);
+
+    int variablesCount() const;
+
+    void values(double pPoint, double *pValues) const;
+
+private:
+    const double *mVoiValues;
+    quint64 mSize;
+
+    QVector<const double *> mVariablesValues;
+
+    mutable QAtomicInteger<quint64> mPosition = 0;
+};
+
+//==============================================================================
+
 class SIMULATIONSUPPORT_EXPORT SimulationResults : public SimulationObject
 {
     Q_OBJECT
@@ -269,7 +299,12 @@ public:
 
     bool addRun();
 
-    void addPoint(double pPoint);
+    void addPoints(double *pPoints, quint64 pCount, bool pRecomputeVariables);
+    void addPoint(double pPoint, int pRun, double pRealPoint,
+                  const double *pConstants, const double *pRates,
+                  const double *pStates, const double *pAlgebraic);
+
+    double realPoint(double pPoint, int pRun = -1) const;
 
     double * points(int pRun = -1) const;
 
@@ -299,17 +334,16 @@ private:
 
     QMap<double *, DataStore::DataStoreVariables> mData;
     QMap<double *, DataStore::DataStore *> mDataDataStores;
+    QMap<double *, SimulationImportedData *> mDataImportedData;
+
+    QString mDirectory;
+    QTemporaryDir *mTemporaryDirectory = nullptr;
 
     void createDataStore();
     void deleteDataStore();
 
     QString uri(const QStringList &pComponentHierarchy, const QString &pName);
 
-    double realPoint(double pPoint, int pRun = -1) const;
-
-    double realValue(double pPoint, DataStore::DataStoreVariable *pVoi,
-                     DataStore::DataStoreVariable *pVariable) const;
-
 signals:
     void resultsReset();
     void runAdded();
@@ -323,6 +357,11 @@ public slots:
 
     quint64 size(int pRun = -1) const;
 
+    QString directory() const;
+    void setDirectory(const QString &pDirectory);
+
+    bool loadRun(const QString &pFileName);
+
     OpenCOR::DataStore::DataStore * dataStore() const;
 };
 
@@ -380,6 +419,8 @@ public:
     bool addRun();
 
     void run();
+    bool runEnsemble(const QList<QVector<double>> &pConstants,
+                     const QList<QVector<double>> &pStates);
     void pause();
     void resume();
     void stop();
@@ -402,6 +443,7 @@ private:
     CellMLSupport::CellmlFileRuntime *mRuntime = nullptr;
 
     SimulationWorker *mWorker = nullptr;
+    SimulationEnsemble *mEnsemble = nullptr;
 
     SimulationData *mData = nullptr;
     SimulationResults *mResults = nullptr;
@@ -441,6 +483,7 @@ public slots:
 
     bool isRunning() const;
     bool isPaused() const;
+    bool isRunningEnsemble() const;
 
     double currentPoint() const;
 
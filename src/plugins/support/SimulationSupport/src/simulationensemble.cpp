@@ -0,0 +1,680 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation ensemble
+//==============================================================================
+
+#include "cellmlfileruntime.h"
+#include "corecliutils.h"
+#include "simulation.h"
+#include "simulationensemble.h"
+
+//==============================================================================
+
+#include <QThread>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+static const int MaximumBatchSize = 8;
+
+//==============================================================================
+
+static void scatter(const QVector<double> &pValues, double *pBatchValues,
+                    int pInstance, int pCount)
+{
+    // Copy the given values of one instance into the given batch values, which
+    // use a structure-of-arrays layout
+
+    for (int i = 0, iMax = pValues.count(); i < iMax; ++i) {
+        pBatchValues[i*pCount+pInstance] = pValues[i];
+    }
+}
+
+//==============================================================================
+
+static void gather(const double *pBatchValues, QVector<double> &pValues,
+                   int pInstance, int pCount)
+{
+    // Copy the values of one instance from the given batch values, which use a
+    // structure-of-arrays layout
+
+    for (int i = 0, iMax = pValues.count(); i < iMax; ++i) {
+        pValues[i] = pBatchValues[i*pCount+pInstance];
+    }
+}
+
+//==============================================================================
+
+SimulationEnsembleWorker::SimulationEnsembleWorker(SimulationEnsemble *pEnsemble) :
+    mEnsemble(pEnsemble)
+{
+}
+
+//==============================================================================
+
+void SimulationEnsembleWorker::run()
+{
+    // Keep asking our ensemble for a member (or a batch of members) to
+    // compute until there are none left or we have been asked to stop
+    // Note: members are handed out one (batch) at a time, so a worker that is
+    //       done with a cheap member will simply pick up the next one rather
+    //       than sit idle while other workers are still busy with expensive
+    //       ones...
+
+    int batchSize = mEnsemble->mBatchSize;
+
+    forever {
+        int member = mEnsemble->nextMember(batchSize);
+
+        if ((member == -1) || mEnsemble->mStopped) {
+            break;
+        }
+
+        if (batchSize == 1) {
+            runMember(member);
+        } else {
+            runMembers(member, qMin(batchSize, mEnsemble->membersCount()-member));
+        }
+    }
+
+    // Let people know that we are done
+
+    emit done();
+}
+
+//==============================================================================
+
+void SimulationEnsembleWorker::runMember(int pMember)
+{
+    // Create our own copy of the model's arrays, using either the constants and
+    // states for the given member, if any, or the ones of our simulation
+
+    CellMLSupport::CellmlFileRuntime *runtime = mEnsemble->mRuntime;
+    QVector<double> constants = mEnsemble->mConstants.value(pMember);
+    QVector<double> states = mEnsemble->mStates.value(pMember);
+    bool hasStates = !states.isEmpty();
+
+    if (constants.isEmpty()) {
+        constants = mEnsemble->mDefaultConstants;
+    }
+
+    if (!hasStates) {
+        states = mEnsemble->mDefaultStates;
+    }
+
+    QVector<double> rates(runtime->ratesCount());
+    QVector<double> algebraic(runtime->algebraicCount());
+    QVector<double> dummyStates(runtime->statesCount());
+
+    // Set up our ODE solver
+
+    auto odeSolver = static_cast<Solver::OdeSolver *>(mEnsemble->mOdeSolverInterface->solverInstance());
+
+    // Set up our NLA solver, if needed
+
+    Solver::NlaSolver *nlaSolver = nullptr;
+
+    if (runtime->needNlaSolver()) {
+        nlaSolver = static_cast<Solver::NlaSolver *>(mEnsemble->mNlaSolverInterface->solverInstance());
+
+        nlaSolver->setProperties(mEnsemble->mSimulation->data()->nlaSolverProperties());
+    }
+
+    // Keep track of any error that might be reported by any of our solvers
+
+    mError = false;
+
+    connect(odeSolver, &Solver::OdeSolver::error,
+            this, &SimulationEnsembleWorker::emitError);
+
+    if (nlaSolver != nullptr) {
+        connect(nlaSolver, &Solver::NlaSolver::error,
+                this, &SimulationEnsembleWorker::emitError);
+    }
+
+    // Compute our 'computed constants' and 'variables'
+    // Note: if we were given some states, then we don't want them to be
+    //       overwritten by our 'computed constants', hence we use dummy states
+    //       in that case...
+
+    SimulationData *simulationData = mEnsemble->mSimulation->data();
+    double startingPoint = simulationData->startingPoint();
+    double endingPoint = simulationData->endingPoint();
+    double pointInterval = simulationData->pointInterval();
+    double currentPoint = startingPoint;
+    quint64 pointCounter = 0;
+
+    runtime->computeComputedConstants()(currentPoint, constants.data(), rates.data(),
+                                        hasStates?
+                                            dummyStates.data():
+                                            states.data(),
+                                        algebraic.data(), nlaSolver);
+
+    // Initialise our ODE solver
+
+    odeSolver->setProperties(simulationData->odeSolverProperties());
+    odeSolver->setJacobian(runtime->computeJacobian(),
+                           runtime->jacobianColumnStarts(),
+                           runtime->jacobianRowIndices());
+    odeSolver->setGates(runtime->computeGates(), runtime->gateStates());
+    odeSolver->setRoots(runtime->computeRoots(), runtime->rootsCount());
+    odeSolver->setNlaSolver(nlaSolver);
+
+    odeSolver->initialize(currentPoint, runtime->statesCount(),
+                          constants.data(), rates.data(), states.data(),
+                          algebraic.data(), runtime->computeRates());
+
+    // Compute our member, but only if no error has occurred so far
+
+    if (!mError) {
+        SimulationResults *results = mEnsemble->mSimulation->results();
+        int run = mEnsemble->mFirstRun+pMember;
+        double realPointOffset = mEnsemble->mRealPointOffset;
+
+        runtime->computeRates()(currentPoint, constants.data(), rates.data(), states.data(), algebraic.data(), nlaSolver);
+        runtime->computeVariables()(currentPoint, constants.data(), rates.data(), states.data(), algebraic.data(), nlaSolver);
+
+        results->addPoint(currentPoint, run, realPointOffset+currentPoint,
+                          constants.data(), rates.data(), states.data(),
+                          algebraic.data());
+
+        forever {
+            // Reinitialise our solver, if we have an NLA solver
+
+            if (nlaSolver != nullptr) {
+                odeSolver->reinitialize(currentPoint);
+            }
+
+            // Determine our next point and compute our model up to it
+
+            odeSolver->solve(currentPoint,
+                             qMin(endingPoint,
+                                  startingPoint+double(++pointCounter)*pointInterval));
+
+            if (mError) {
+                break;
+            }
+
+            // Add our new point
+
+            runtime->computeRates()(currentPoint, constants.data(), rates.data(), states.data(), algebraic.data(), nlaSolver);
+            runtime->computeVariables()(currentPoint, constants.data(), rates.data(), states.data(), algebraic.data(), nlaSolver);
+
+            results->addPoint(currentPoint, run, realPointOffset+currentPoint,
+                              constants.data(), rates.data(), states.data(),
+                              algebraic.data());
+
+            // Leave our loop, if we have reached our ending point or if we
+            // have been asked to stop
+
+            if (qFuzzyCompare(currentPoint, endingPoint) || mEnsemble->mStopped) {
+                break;
+            }
+
+            // Delay things a bit and/or pause ourselves, if needed
+
+            mEnsemble->waitIfPaused();
+        }
+    }
+
+    // Delete our solver(s)
+
+    delete odeSolver;
+
+    if (nlaSolver != nullptr) {
+        delete nlaSolver;
+    }
+}
+
+//==============================================================================
+
+void SimulationEnsembleWorker::runMembers(int pFirstMember, int pCount)
+{
+    // Create our own copy of the model's arrays for the given members, using a
+    // structure-of-arrays layout so that our ODE solver can compute all of our
+    // members in lockstep (see OdeSolver::initializeBatch()), as well as
+    // arrays for one member at a time
+
+    CellMLSupport::CellmlFileRuntime *runtime = mEnsemble->mRuntime;
+    int constantsCount = runtime->constantsCount();
+    int ratesCount = runtime->ratesCount();
+    int statesCount = runtime->statesCount();
+    int algebraicCount = runtime->algebraicCount();
+    QVector<double> constants(constantsCount*pCount);
+    QVector<double> rates(ratesCount*pCount);
+    QVector<double> states(statesCount*pCount);
+    QVector<double> algebraic(algebraicCount*pCount);
+    QVector<double> memberConstants;
+    QVector<double> memberRates(ratesCount);
+    QVector<double> memberStates;
+    QVector<double> memberAlgebraic(algebraicCount);
+    QVector<double> dummyStates(statesCount);
+
+    // Compute the 'computed constants' of our members, using either the
+    // constants and states for a given member, if any, or the ones of our
+    // simulation
+    // Note: if we were given some states, then we don't want them to be
+    //       overwritten by our 'computed constants', hence we use dummy states
+    //       in that case...
+
+    SimulationData *simulationData = mEnsemble->mSimulation->data();
+    double startingPoint = simulationData->startingPoint();
+    double endingPoint = simulationData->endingPoint();
+    double pointInterval = simulationData->pointInterval();
+    double currentPoint = startingPoint;
+    quint64 pointCounter = 0;
+
+    for (int i = 0; i < pCount; ++i) {
+        memberConstants = mEnsemble->mConstants.value(pFirstMember+i);
+        memberStates = mEnsemble->mStates.value(pFirstMember+i);
+
+        bool hasStates = !memberStates.isEmpty();
+
+        if (memberConstants.isEmpty()) {
+            memberConstants = mEnsemble->mDefaultConstants;
+        }
+
+        if (!hasStates) {
+            memberStates = mEnsemble->mDefaultStates;
+        }
+
+        runtime->computeComputedConstants()(currentPoint, memberConstants.data(), memberRates.data(),
+                                            hasStates?
+                                                dummyStates.data():
+                                                memberStates.data(),
+                                            memberAlgebraic.data(), nullptr);
+
+        scatter(memberConstants, constants.data(), i, pCount);
+        scatter(memberRates, rates.data(), i, pCount);
+        scatter(memberStates, states.data(), i, pCount);
+        scatter(memberAlgebraic, algebraic.data(), i, pCount);
+    }
+
+    // Set up and initialise our ODE solver, keeping track of any error that
+    // it might report
+
+    auto odeSolver = static_cast<Solver::OdeSolver *>(mEnsemble->mOdeSolverInterface->solverInstance());
+
+    mError = false;
+
+    connect(odeSolver, &Solver::OdeSolver::error,
+            this, &SimulationEnsembleWorker::emitError);
+
+    odeSolver->setProperties(simulationData->odeSolverProperties());
+
+    odeSolver->initializeBatch(currentPoint, statesCount, pCount,
+                               constants.data(), rates.data(), states.data(),
+                               algebraic.data(), runtime->computeRatesBatch());
+
+    // Compute our members, but only if no error has occurred so far
+    // Note: our points are added one member at a time, after having computed
+    //       the rates and 'variables' of that member...
+
+    if (!mError) {
+        SimulationResults *results = mEnsemble->mSimulation->results();
+        int firstRun = mEnsemble->mFirstRun+pFirstMember;
+        double realPointOffset = mEnsemble->mRealPointOffset;
+
+        forever {
+            for (int i = 0; i < pCount; ++i) {
+                gather(constants.data(), memberConstants, i, pCount);
+                gather(states.data(), memberStates, i, pCount);
+                gather(algebraic.data(), memberAlgebraic, i, pCount);
+
+                runtime->computeRates()(currentPoint, memberConstants.data(), memberRates.data(), memberStates.data(), memberAlgebraic.data(), nullptr);
+                runtime->computeVariables()(currentPoint, memberConstants.data(), memberRates.data(), memberStates.data(), memberAlgebraic.data(), nullptr);
+
+                results->addPoint(currentPoint, firstRun+i, realPointOffset+currentPoint,
+                                  memberConstants.data(), memberRates.data(),
+                                  memberStates.data(), memberAlgebraic.data());
+            }
+
+            // Leave our loop, if we have reached our ending point or if we
+            // have been asked to stop
+
+            if (qFuzzyCompare(currentPoint, endingPoint) || mEnsemble->mStopped) {
+                break;
+            }
+
+            // Delay things a bit and/or pause ourselves, if needed
+
+            mEnsemble->waitIfPaused();
+
+            // Determine our next point and compute our members up to it
+
+            odeSolver->solve(currentPoint,
+                             qMin(endingPoint,
+                                  startingPoint+double(++pointCounter)*pointInterval));
+
+            if (mError) {
+                break;
+            }
+        }
+    }
+
+    // Delete our solver
+
+    delete odeSolver;
+}
+
+//==============================================================================
+
+void SimulationEnsembleWorker::emitError(const QString &pMessage)
+{
+    // A solver error occurred, so keep track of it and let people know about
+    // it, but only if another error hasn't already been received for our
+    // current member
+
+    if (!mError) {
+        mError = true;
+
+        emit error(pMessage);
+    }
+}
+
+//==============================================================================
+
+SimulationEnsemble::SimulationEnsemble(Simulation *pSimulation,
+                                       const QList<QVector<double>> &pConstants,
+                                       const QList<QVector<double>> &pStates,
+                                       int pFirstRun,
+                                       SimulationEnsemble *&pSelf) :
+    mSimulation(pSimulation),
+    mRuntime(pSimulation->runtime()),
+    mOdeSolverInterface(pSimulation->data()->odeSolverInterface()),
+    mNlaSolverInterface(pSimulation->data()->nlaSolverInterface()),
+    mConstants(pConstants),
+    mStates(pStates),
+    mFirstRun(pFirstRun),
+    mRealPointOffset(pSimulation->results()->realPoint(0.0, pFirstRun)),
+    mSelf(pSelf)
+{
+    // Keep track of the constants and states of our simulation, which are to
+    // be used by members for which no constants and/or states were given
+    // Note: we do this here rather than in our workers since our simulation's
+    //       data might get modified (e.g. through the GUI) while our workers
+    //       are running...
+
+    SimulationData *simulationData = pSimulation->data();
+
+    mDefaultConstants = QVector<double>(mRuntime->constantsCount());
+    mDefaultStates = QVector<double>(mRuntime->statesCount());
+
+    memcpy(mDefaultConstants.data(), simulationData->constants(), size_t(mRuntime->constantsCount())*Solver::SizeOfDouble);
+    memcpy(mDefaultStates.data(), simulationData->states(), size_t(mRuntime->statesCount())*Solver::SizeOfDouble);
+
+    // Determine whether our members can be computed in batches, i.e. whether
+    // our ODE solver can compute several instances of our model in lockstep
+    // and our runtime can compute their rates at once, and if so the size of
+    // our batches
+    // Note: we don't want to use batches of the maximum size if it means
+    //       leaving some of our cores idle (e.g. 16 members on 8 cores should
+    //       result in 8 batches of 2 members rather than 2 batches of 8
+    //       members), hence we spread our members over our cores...
+
+    int idealThreadsCount = qMax(QThread::idealThreadCount(), 1);
+    auto odeSolver = static_cast<Solver::OdeSolver *>(mOdeSolverInterface->solverInstance());
+
+    mBatchSize = (odeSolver->supportsBatch() && (mRuntime->computeRatesBatch() != nullptr))?
+                     qBound(1, (membersCount()+idealThreadsCount-1)/idealThreadsCount, MaximumBatchSize):
+                     1;
+
+    delete odeSolver;
+
+    // Determine the number of threads to use, based on our batch size
+    // Note: each of our members has its own NLA solver, if needed, which is
+    //       passed explicitly to our model functions, so our members can
+    //       always be run concurrently...
+
+    mThreadsCount = qMin(idealThreadsCount,
+                         (membersCount()+mBatchSize-1)/mBatchSize);
+}
+
+//==============================================================================
+
+SimulationEnsemble::~SimulationEnsemble()
+{
+    // Stop our workers, if they are still running, and wait for their thread
+    // to be finished before deleting it
+    // Note: our workers use our simulation's runtime, data and results, so we
+    //       must be sure that they are all done before our simulation can go
+    //       ahead with deleting those...
+
+    stop();
+
+    for (auto thread : mThreads) {
+        thread->wait();
+
+        delete thread;
+    }
+}
+
+//==============================================================================
+
+int SimulationEnsemble::membersCount() const
+{
+    // Return our number of members
+
+    return qMax(mConstants.count(), mStates.count());
+}
+
+//==============================================================================
+
+int SimulationEnsemble::threadsCount() const
+{
+    // Return the number of threads we are using
+
+    return mThreadsCount;
+}
+
+//==============================================================================
+
+bool SimulationEnsemble::isRunning() const
+{
+    // Return whether we are running
+
+    return (mRunningWorkersCount != 0) && !mPaused;
+}
+
+//==============================================================================
+
+bool SimulationEnsemble::isPaused() const
+{
+    // Return whether we are paused
+
+    return (mRunningWorkersCount != 0) && mPaused;
+}
+
+//==============================================================================
+
+int SimulationEnsemble::nextMember(int pCount)
+{
+    // Return the next member to be computed, if any, reserving the given
+    // number of members
+
+    int res = mNextMember.fetchAndAddOrdered(pCount);
+
+    return (res < membersCount())?res:-1;
+}
+
+//==============================================================================
+
+void SimulationEnsemble::waitIfPaused()
+{
+    // Delay things a bit, if needed, and wait for us to be resumed (or stopped),
+    // if we are paused
+    // Note: this is called by our workers after each of their points, so that
+    //       an ensemble can be slowed down and paused just like a single
+    //       simulation...
+
+    const quint64 *delay = mSimulation->delay();
+
+    if (delay != nullptr) {
+        Core::doNothing(delay, &mStopped);
+    }
+
+    mPausedMutex.lock();
+        while (mPaused && !mStopped) {
+            mPausedCondition.wait(&mPausedMutex);
+        }
+    mPausedMutex.unlock();
+}
+
+//==============================================================================
+
+void SimulationEnsemble::start()
+{
+    // Create our workers and move each of them to their own thread
+    // Note: our threads are quit directly from our workers' thread, rather
+    //       than through the event loop of our thread, so that they can be
+    //       waited for in our destructor (see ~SimulationEnsemble())...
+
+    mRunningWorkersCount = mThreadsCount;
+
+    for (int i = 0; i < mThreadsCount; ++i) {
+        auto thread = new QThread();
+        auto worker = new SimulationEnsembleWorker(this);
+
+        worker->moveToThread(thread);
+
+        connect(thread, &QThread::started,
+                worker, &SimulationEnsembleWorker::run);
+
+        connect(worker, &SimulationEnsembleWorker::error,
+                this, &SimulationEnsemble::emitError);
+
+        connect(worker, &SimulationEnsembleWorker::done,
+                this, &SimulationEnsemble::workerDone);
+        connect(worker, &SimulationEnsembleWorker::done,
+                thread, &QThread::quit, Qt::DirectConnection);
+        connect(worker, &SimulationEnsembleWorker::done,
+                worker, &SimulationEnsembleWorker::deleteLater);
+
+        mThreads << thread;
+
+        thread->start();
+    }
+
+    // Let people know that we are running and start our timer
+
+    emit running(false);
+
+    mTimer.start();
+}
+
+//==============================================================================
+
+void SimulationEnsemble::pause()
+{
+    // Pause ourselves, if we are currently running, stopping our timer in the
+    // process
+    // Note: our workers will actually pause themselves once they are done with
+    //       their current point...
+
+    if (isRunning()) {
+        mPausedMutex.lock();
+            mPaused = true;
+        mPausedMutex.unlock();
+
+        mElapsedTime += mTimer.elapsed();
+
+        emit paused();
+    }
+}
+
+//==============================================================================
+
+void SimulationEnsemble::resume()
+{
+    // Resume ourselves, if we are currently paused, (re)starting our timer in
+    // the process
+
+    if (isPaused()) {
+        mPausedMutex.lock();
+            mPaused = false;
+
+            mPausedCondition.wakeAll();
+        mPausedMutex.unlock();
+
+        emit running(true);
+
+        mTimer.start();
+    }
+}
+
+//==============================================================================
+
+void SimulationEnsemble::stop()
+{
+    // Ask our workers to stop, waking them up if we are paused
+
+    mPausedMutex.lock();
+        mStopped = true;
+
+        mPausedCondition.wakeAll();
+    mPausedMutex.unlock();
+}
+
+//==============================================================================
+
+void SimulationEnsemble::workerDone()
+{
+    // One of our workers is done, so check whether it was our last one and, if
+    // so, reset our simulation owner's knowledge of us and let people know that
+    // we are done
+
+    if (--mRunningWorkersCount == 0) {
+        mSelf = nullptr;
+
+        emit done(mError?
+                      -1:
+                      mElapsedTime+(mPaused?0:mTimer.elapsed()));
+
+        deleteLater();
+    }
+}
+
+//==============================================================================
+
+void SimulationEnsemble::emitError(const QString &pMessage)
+{
+    // A member reported an error, so keep track of it and let people know about
+    // it, but only if another error hasn't already been received
+
+    if (!mError) {
+        mError = true;
+
+        emit error(pMessage);
+    }
+}
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,180 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation ensemble
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+
+//==============================================================================
+
+class QThread;
+
+//==============================================================================
+
+namespace OpenCOR {
+
+//==============================================================================
+
+class SolverInterface;
+
+//==============================================================================
+
+namespace CellMLSupport {
+    class CellmlFileRuntime;
+} // namespace CellMLSupport
+
+//==============================================================================
+
+namespace SimulationSupport {
+
+//==============================================================================
+
+class Simulation;
+class SimulationEnsemble;
+
+//==============================================================================
+
+class SimulationEnsembleWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SimulationEnsembleWorker(SimulationEnsemble *pEnsemble);
+
+private:
+    SimulationEnsemble *mEnsemble;
+
+    bool mError = false;
+
+    void runMember(int pMember);
+    void runMembers(int pFirstMember, int pCount);
+
+signals:
+    void done();
+
+    void error(const QString &pMessage);
+
+public slots:
+    void run();
+
+private slots:
+    void emitError(const QString &pMessage);
+};
+
+//==============================================================================
+
+class SimulationEnsemble : public QObject
+{
+    Q_OBJECT
+
+    friend class SimulationEnsembleWorker;
+
+public:
+    explicit SimulationEnsemble(Simulation *pSimulation,
+                                const QList<QVector<double>> &pConstants,
+                                const QList<QVector<double>> &pStates,
+                                int pFirstRun, SimulationEnsemble *&pSelf);
+    ~SimulationEnsemble() override;
+
+    int membersCount() const;
+    int threadsCount() const;
+
+    bool isRunning() const;
+    bool isPaused() const;
+
+    void start();
+    void pause();
+    void resume();
+    void stop();
+
+private:
+    Simulation *mSimulation;
+
+    CellMLSupport::CellmlFileRuntime *mRuntime;
+
+    SolverInterface *mOdeSolverInterface;
+    SolverInterface *mNlaSolverInterface;
+
+    QList<QVector<double>> mConstants;
+    QList<QVector<double>> mStates;
+
+    QVector<double> mDefaultConstants;
+    QVector<double> mDefaultStates;
+
+    int mFirstRun;
+    double mRealPointOffset;
+
+    int mBatchSize = 1;
+    int mThreadsCount = 0;
+
+    QList<QThread *> mThreads;
+
+    QAtomicInt mNextMember = 0;
+    int mRunningWorkersCount = 0;
+
+    bool mPaused = false;
+    bool mStopped = false;
+    bool mError = false;
+
+    QMutex mPausedMutex;
+    QWaitCondition mPausedCondition;
+
+    QElapsedTimer mTimer;
+    qint64 mElapsedTime = 0;
+
+    SimulationEnsemble *&mSelf;
+
+    int nextMember(int pCount);
+
+    void waitIfPaused();
+
+signals:
+    void running(bool pIsResuming);
+    void paused();
+
+    void done(qint64 pElapsedTime);
+
+    void error(const QString &pMessage);
+
+private slots:
+    void workerDone();
+
+    void emitError(const QString &pMessage);
+};
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,194 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation results buffer
+//==============================================================================
+
+#include "simulation.h"
+#include "simulationresultsbuffer.h"
+
+//==============================================================================
+
+#include <QThread>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+static const quint64 MinimumCapacity = 16;
+static const quint64 MaximumCapacity = 65536;
+static const quint64 MaximumMemory = 16*1024*1024;
+
+//==============================================================================
+
+SimulationResultsBuffer::SimulationResultsBuffer(int pPointSize) :
+    mPointSize(pPointSize)
+{
+    // Determine our capacity, i.e. the number of points we can hold, so that we
+    // don't use more than a given amount of memory, and allocate our points
+
+    mCapacity = qBound(MinimumCapacity,
+                       MaximumMemory/(quint64(mPointSize)*Solver::SizeOfDouble),
+                       MaximumCapacity);
+
+    mPoints = new double[mCapacity*quint64(mPointSize)];
+}
+
+//==============================================================================
+
+SimulationResultsBuffer::~SimulationResultsBuffer()
+{
+    // Delete some internal objects
+
+    delete[] mPoints;
+}
+
+//==============================================================================
+
+int SimulationResultsBuffer::pointSize() const
+{
+    // Return our point size
+
+    return mPointSize;
+}
+
+//==============================================================================
+
+quint64 SimulationResultsBuffer::capacity() const
+{
+    // Return our capacity
+
+    return mCapacity;
+}
+
+//==============================================================================
+
+double * SimulationResultsBuffer::writablePoint() const
+{
+    // Return the point that can next be written to, if we are not full
+    // Note: this is only to be called by our producer...
+
+    quint64 writePosition = mWritePosition.load();
+
+    if (writePosition-mReadPosition.loadAcquire() == mCapacity) {
+        return nullptr;
+    }
+
+    return mPoints+(writePosition%mCapacity)*quint64(mPointSize);
+}
+
+//==============================================================================
+
+void SimulationResultsBuffer::commitPoint()
+{
+    // Make the point that has just been written to available to our consumer
+    // Note: this is only to be called by our producer...
+
+    mWritePosition.storeRelease(mWritePosition.load()+1);
+}
+
+//==============================================================================
+
+double * SimulationResultsBuffer::readablePoints(quint64 &pCount) const
+{
+    // Return the points that can be read and their number
+    // Note #1: this is only to be called by our consumer...
+    // Note #2: our points are returned as one contiguous block, meaning that if
+    //          the readable points wrap around the end of our buffer, only
+    //          those up to the end of our buffer are returned. The remaining
+    //          ones will be returned by our next call...
+
+    quint64 readPosition = mReadPosition.load();
+    quint64 readIndex = readPosition%mCapacity;
+
+    pCount = qMin(mWritePosition.loadAcquire()-readPosition, mCapacity-readIndex);
+
+    return mPoints+readIndex*quint64(mPointSize);
+}
+
+//==============================================================================
+
+void SimulationResultsBuffer::releasePoints(quint64 pCount)
+{
+    // Give the given number of points back to our producer
+    // Note: this is only to be called by our consumer...
+
+    mReadPosition.storeRelease(mReadPosition.load()+pCount);
+}
+
+//==============================================================================
+
+SimulationResultsWriter::SimulationResultsWriter(SimulationResults *pResults,
+                                                 SimulationResultsBuffer *pBuffer,
+                                                 bool pRecomputeVariables) :
+    mResults(pResults),
+    mBuffer(pBuffer),
+    mRecomputeVariables(pRecomputeVariables)
+{
+}
+
+//==============================================================================
+
+void SimulationResultsWriter::run()
+{
+    // Add the points from our buffer to our simulation results, as batches,
+    // until we have been asked to finish and there are no points left
+    // Note: we check whether we have been asked to finish before retrieving
+    //       the readable points, so that we don't miss any points that might
+    //       have been committed just before we were asked to finish...
+
+    forever {
+        bool finished = mFinished.loadAcquire() != 0;
+        quint64 count;
+        double *points = mBuffer->readablePoints(count);
+
+        if (count != 0) {
+            mResults->addPoints(points, count, mRecomputeVariables);
+
+            mBuffer->releasePoints(count);
+        } else if (finished) {
+            break;
+        } else {
+            QThread::msleep(1);
+        }
+    }
+}
+
+//==============================================================================
+
+void SimulationResultsWriter::finish()
+{
+    // Ask ourselves to finish, i.e. to stop once all the points from our
+    // buffer have been added to our simulation results
+
+    mFinished.storeRelease(1);
+}
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
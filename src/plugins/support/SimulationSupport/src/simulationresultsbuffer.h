@@ -0,0 +1,94 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation results buffer
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include <QAtomicInteger>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+class SimulationResults;
+
+//==============================================================================
+
+class SimulationResultsBuffer
+{
+public:
+    explicit SimulationResultsBuffer(int pPointSize);
+    ~SimulationResultsBuffer();
+
+    int pointSize() const;
+    quint64 capacity() const;
+
+    double * writablePoint() const;
+    void commitPoint();
+
+    double * readablePoints(quint64 &pCount) const;
+    void releasePoints(quint64 pCount);
+
+private:
+    int mPointSize;
+    quint64 mCapacity;
+
+    double *mPoints;
+
+    alignas(64) QAtomicInteger<quint64> mWritePosition = 0;
+    alignas(64) QAtomicInteger<quint64> mReadPosition = 0;
+};
+
+//==============================================================================
+
+class SimulationResultsWriter
+{
+public:
+    explicit SimulationResultsWriter(SimulationResults *pResults,
+                                     SimulationResultsBuffer *pBuffer,
+                                     bool pRecomputeVariables);
+
+    void run();
+    void finish();
+
+private:
+    SimulationResults *mResults;
+    SimulationResultsBuffer *mBuffer;
+
+    bool mRecomputeVariables;
+
+    QAtomicInteger<int> mFinished = 0;
+};
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -320,6 +320,110 @@ bool SimulationSupportPythonWrapper::run(Simulation *pSimulation)
 
 //==============================================================================
 
+static QList<QVector<double>> ensembleValues(const QVariantList &pValues)
+{
+    // Convert the given list of lists of values to a list of vectors of doubles
+    // Note: an empty/None item means that the corresponding ensemble member
+    //       should use the simulation's own values...
+
+    QList<QVector<double>> res;
+
+    for (const auto &values : pValues) {
+        QVector<double> vector;
+
+        for (const auto &value : values.toList()) {
+            bool ok;
+            double doubleValue = value.toDouble(&ok);
+
+            if (!ok) {
+                throw std::runtime_error(QObject::tr("Ensemble values must be numbers.").toStdString());
+            }
+
+            vector << doubleValue;
+        }
+
+        res << vector;
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+bool SimulationSupportPythonWrapper::run_ensemble(Simulation *pSimulation,
+                                                  const QVariantList &pConstants,
+                                                  const QVariantList &pStates)
+{
+    // Run an ensemble for the given simulation, but only if it doesn't have
+    // blocking issues and if it is valid
+
+    if (pSimulation->hasBlockingIssues()) {
+        throw std::runtime_error(tr("The simulation has blocking issues and cannot therefore be run.").toStdString());
+    }
+
+    if (!valid(pSimulation)) {
+        throw std::runtime_error(tr("The simulation has an invalid runtime and cannot therefore be run.").toStdString());
+    }
+
+    QList<QVector<double>> constants = ensembleValues(pConstants);
+    QList<QVector<double>> states = ensembleValues(pStates);
+
+    // Reset our internals
+
+    mElapsedTime = -1;
+    mErrorMessage = QString();
+
+    // Keep track of any simulation error and of when the ensemble is done
+
+    QWidget *focusWidget = QApplication::focusWidget();
+
+    connect(pSimulation, &Simulation::error,
+            this, &SimulationSupportPythonWrapper::simulationError,
+            Qt::UniqueConnection);
+    connect(pSimulation, &Simulation::done,
+            this, &SimulationSupportPythonWrapper::simulationDone,
+            Qt::UniqueConnection);
+
+    // Run our ensemble and wait for it to complete
+    // Note: each member gets its own run, which gets added by
+    //       Simulation::runEnsemble()...
+
+    QEventLoop waitLoop;
+    auto connection = std::make_shared<QMetaObject::Connection>();
+
+    *connection = connect(pSimulation, &Simulation::done, [&]() {
+        waitLoop.quit();
+
+        disconnect(*connection);
+    });
+
+    if (pSimulation->runEnsemble(constants, states)) {
+        waitLoop.exec();
+    } else {
+        disconnect(*connection);
+
+        if (mErrorMessage.isEmpty()) {
+            mErrorMessage = tr("The ensemble could not be run.");
+        }
+    }
+
+    // Throw any error message that has been generated
+
+    if (!mErrorMessage.isEmpty()) {
+        throw std::runtime_error(mErrorMessage.toStdString());
+    }
+
+    // Restore the focus to the previous widget
+
+    if (focusWidget != nullptr) {
+        focusWidget->setFocus();
+    }
+
+    return mElapsedTime >= 0;
+}
+
+//==============================================================================
+
 void SimulationSupportPythonWrapper::reset(Simulation *pSimulation, bool pAll)
 {
     // Reset the given simulation
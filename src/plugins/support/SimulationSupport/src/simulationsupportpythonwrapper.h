@@ -26,6 +26,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QObject>
+#include <QVariant>
 
 //==============================================================================
 
@@ -72,6 +73,9 @@ public slots:
     bool valid(OpenCOR::SimulationSupport::Simulation *pSimulation);
 
     bool run(OpenCOR::SimulationSupport::Simulation *pSimulation);
+    bool run_ensemble(OpenCOR::SimulationSupport::Simulation *pSimulation,
+                      const QVariantList &pConstants,
+                      const QVariantList &pStates = QVariantList());
 
     void reset(OpenCOR::SimulationSupport::Simulation *pSimulation,
                bool pAll = true);
@@ -24,6 +24,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include "cellmlfileruntime.h"
 #include "corecliutils.h"
 #include "simulation.h"
+#include "simulationresultsbuffer.h"
 #include "simulationworker.h"
 
 //==============================================================================
@@ -95,8 +96,6 @@ void SimulationWorker::run()
 
     if (mRuntime->needNlaSolver()) {
         nlaSolver = static_cast<Solver::NlaSolver *>(mSimulation->data()->nlaSolverInterface()->solverInstance());
-
-        Solver::setNlaSolver(mRuntime, nlaSolver);
     }
 
     // Keep track of any error that might be reported by any of our solvers
@@ -124,6 +123,12 @@ void SimulationWorker::run()
     // Initialise our ODE solver
 
     odeSolver->setProperties(mSimulation->data()->odeSolverProperties());
+    odeSolver->setJacobian(mRuntime->computeJacobian(),
+                           mRuntime->jacobianColumnStarts(),
+                           mRuntime->jacobianRowIndices());
+    odeSolver->setGates(mRuntime->computeGates(), mRuntime->gateStates());
+    odeSolver->setRoots(mRuntime->computeRoots(), mRuntime->rootsCount());
+    odeSolver->setNlaSolver(nlaSolver);
 
     odeSolver->initialize(mCurrentPoint, mRuntime->statesCount(),
                           mSimulation->data()->constants(),
@@ -145,6 +150,34 @@ void SimulationWorker::run()
     qint64 elapsedTime = 0;
 
     if (!mError) {
+        // Create our results buffer and writer, and start our writer in its own
+        // thread
+        // Note #1: we only fill our results buffer with the raw values of our
+        //          model, leaving it to our writer to recompute our 'variables'
+        //          and to add our points to our simulation results, as
+        //          batches. This is to keep our main work loop as fast as
+        //          possible...
+        // Note #2: if we need an NLA solver, then our 'variables' must be
+        //          recomputed here since our NLA solver belongs to this
+        //          thread...
+        // Note #3: otherwise, the 'variables' of our simulation data are only
+        //          recomputed when we pause or are done. This is fine since
+        //          those are the only times our GUI reads them (through
+        //          SimulationData::algebraic()), our graphs using our
+        //          simulation results, whose 'variables' our writer
+        //          recomputes...
+
+        bool recomputeVariables = nlaSolver != nullptr;
+        SimulationResultsBuffer buffer(1+mRuntime->constantsCount()+mRuntime->ratesCount()
+                                        +mRuntime->statesCount()+mRuntime->algebraicCount());
+        SimulationResultsWriter writer(mSimulation->results(), &buffer,
+                                       !recomputeVariables);
+        QThread *writerThread = QThread::create([&writer]() {
+            writer.run();
+        });
+
+        writerThread->start();
+
         // Start our timer
 
         QElapsedTimer timer;
@@ -153,7 +186,7 @@ void SimulationWorker::run()
 
         // Add our first point
 
-        mSimulation->results()->addPoint(mCurrentPoint);
+        addPoint(&buffer, recomputeVariables, nlaSolver);
 
         // Our main work loop
         // Note: for performance reasons, it is essential that the following
@@ -165,12 +198,16 @@ void SimulationWorker::run()
         QMutex pausedMutex;
 
         forever {
-            // Reinitialise our solver, if we have an NLA solver or if the model
-            // got reset
-            // Note: indeed, with a solver such as CVODE, we need to update our
-            //       internals...
-
-            if ((nlaSolver != nullptr) || mReset) {
+            // Reinitialise our solver, if the model got reset or if we have an
+            // NLA solver and our ODE solver doesn't interpolate its solution
+            // Note #1: indeed, with a solver such as CVODE, we need to update
+            //          our internals...
+            // Note #2: an ODE solver that interpolates its solution integrates
+            //          our model using its own steps, independently of our
+            //          points, so we only want to reinitialise it when there
+            //          is a discontinuity (i.e. when the model got reset)...
+
+            if (mReset || ((nlaSolver != nullptr) && !odeSolver->interpolatesSolution())) {
                 odeSolver->reinitialize(mCurrentPoint);
 
                 mReset = false;
@@ -190,7 +227,7 @@ void SimulationWorker::run()
 
             // Add our new point
 
-            mSimulation->results()->addPoint(mCurrentPoint);
+            addPoint(&buffer, recomputeVariables, nlaSolver);
 
             // Some post-processing, if needed
 
@@ -214,6 +251,13 @@ void SimulationWorker::run()
 
                 elapsedTime += timer.elapsed();
 
+                // Make sure that our 'variables' are up to date, so that they
+                // can be shown while we are paused
+
+                if (!recomputeVariables) {
+                    mSimulation->data()->recomputeVariables(mCurrentPoint);
+                }
+
                 // Let people know that we are paused
 
                 emit paused();
@@ -228,6 +272,15 @@ void SimulationWorker::run()
 
                 mPaused = false;
 
+                // Make sure that our ODE solver takes into account any change
+                // that might have been made to our model while we were paused,
+                // should it interpolate its solution (since it then integrates
+                // our model from its own internal states)
+
+                if (odeSolver->interpolatesSolution()) {
+                    mReset = true;
+                }
+
                 // Let people know that we are running again
 
                 emit running(true);
@@ -238,11 +291,26 @@ void SimulationWorker::run()
             }
         }
 
+        // Wait for our writer to have added all our points to our simulation
+        // results, so that they are all there by the time we are done
+
+        writer.finish();
+
+        writerThread->wait();
+
+        delete writerThread;
+
         // Retrieve the total elapsed time, should no error have occurred
 
         if (!mError) {
             elapsedTime += timer.elapsed();
         }
+
+        // Make sure that our 'variables' are up to date
+
+        if (!recomputeVariables) {
+            mSimulation->data()->recomputeVariables(mCurrentPoint);
+        }
     }
 
     // Delete our solver(s)
@@ -267,6 +335,50 @@ void SimulationWorker::run()
 
 //==============================================================================
 
+void SimulationWorker::addPoint(SimulationResultsBuffer *pBuffer,
+                                bool pRecomputeVariables,
+                                Solver::NlaSolver *pNlaSolver)
+{
+    // Make sure that all our variables are up to date, if needed
+
+    if (pRecomputeVariables) {
+        mSimulation->data()->recomputeVariables(mCurrentPoint, pNlaSolver);
+    }
+
+    // Wait for our results buffer to have room for a new point, should it be
+    // full
+    // Note: our results writer is much faster at emptying our results buffer
+    //       than we are at filling it, so we should hardly ever have to wait
+    //       here...
+
+    double *point;
+
+    while ((point = pBuffer->writablePoint()) == nullptr) {
+        QThread::yieldCurrentThread();
+    }
+
+    // Copy the raw values of our model to our new point and commit it
+
+    int constantsCount = mRuntime->constantsCount();
+    int ratesCount = mRuntime->ratesCount();
+    int statesCount = mRuntime->statesCount();
+    double *constants = point+1;
+    double *rates = constants+constantsCount;
+    double *states = rates+ratesCount;
+    double *algebraic = states+statesCount;
+
+    point[0] = mCurrentPoint;
+
+    memcpy(constants, mSimulation->data()->constants(), size_t(constantsCount)*Solver::SizeOfDouble);
+    memcpy(rates, mSimulation->data()->rates(), size_t(ratesCount)*Solver::SizeOfDouble);
+    memcpy(states, mSimulation->data()->states(), size_t(statesCount)*Solver::SizeOfDouble);
+    memcpy(algebraic, mSimulation->data()->algebraic(), size_t(mRuntime->algebraicCount())*Solver::SizeOfDouble);
+
+    pBuffer->commitPoint();
+}
+
+//==============================================================================
+
 void SimulationWorker::pause()
 {
     // Pause ourselves, if we are currently running
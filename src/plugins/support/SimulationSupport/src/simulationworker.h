@@ -40,11 +40,18 @@ namespace CellMLSupport {
 
 //==============================================================================
 
+namespace Solver {
+    class NlaSolver;
+} // namespace Solver
+
+//==============================================================================
+
 namespace SimulationSupport {
 
 //==============================================================================
 
 class Simulation;
+class SimulationResultsBuffer;
 
 //==============================================================================
 
@@ -87,6 +94,9 @@ private:
 
     SimulationWorker *&mSelf;
 
+    void addPoint(SimulationResultsBuffer *pBuffer, bool pRecomputeVariables,
+                  Solver::NlaSolver *pNlaSolver);
+
 signals:
     void running(bool pIsResuming);
     void paused();
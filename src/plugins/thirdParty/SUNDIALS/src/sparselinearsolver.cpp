@@ -0,0 +1,479 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Sparse linear solver
+//==============================================================================
+
+#include "sparselinearsolver.h"
+
+//==============================================================================
+
+#include <QtMath>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SUNDIALS {
+
+//==============================================================================
+
+SparseLinearSolver::SparseLinearSolver(sunindextype pSize) :
+    mSize(pSize),
+    mLColumnStarts(int(pSize+1)),
+    mUColumnStarts(int(pSize+1)),
+    mPivots(int(pSize)),
+    mWork(int(pSize)),
+    mStack(int(2*pSize)),
+    mPositions(int(pSize)),
+    mMarks(int(pSize))
+{
+}
+
+//==============================================================================
+
+sunindextype SparseLinearSolver::reach(const sunindextype *pColumnStarts,
+                                       const sunindextype *pRowIndices,
+                                       sunindextype pColumn)
+{
+    // Determine the rows that are non-zero in the solution of L*x = A(:,j),
+    // i.e. the rows that can be reached in the graph of L from the non-zero
+    // rows of A(:,j), and return them in topological order in
+    // mStack[top..mSize-1]
+    // Note: we use a non-recursive depth-first search, with mStack[mSize..] as
+    //       our stack and mPositions to keep track of where we are in the
+    //       column of L associated with a node...
+
+    sunindextype *output = mStack.data();
+    sunindextype *stack = output+mSize;
+    sunindextype top = mSize;
+
+    ++mMark;
+
+    for (sunindextype p = pColumnStarts[pColumn]; p < pColumnStarts[pColumn+1]; ++p) {
+        sunindextype node = pRowIndices[p];
+
+        if (mMarks[int(node)] == mMark) {
+            continue;
+        }
+
+        sunindextype head = 0;
+
+        stack[0] = node;
+
+        while (head >= 0) {
+            node = stack[head];
+
+            sunindextype column = mPivots[int(node)];
+
+            if (mMarks[int(node)] != mMark) {
+                mMarks[int(node)] = mMark;
+                mPositions[int(node)] = (column < 0)?0:mLColumnStarts[int(column)]+1;
+            }
+
+            bool done = true;
+            sunindextype end = (column < 0)?0:mLColumnStarts[int(column+1)];
+
+            for (sunindextype q = mPositions[int(node)]; q < end; ++q) {
+                sunindextype row = mLRowIndices[int(q)];
+
+                if (mMarks[int(row)] != mMark) {
+                    mPositions[int(node)] = q+1;
+                    stack[++head] = row;
+                    done = false;
+
+                    break;
+                }
+            }
+
+            if (done) {
+                --head;
+
+                output[--top] = node;
+            }
+        }
+    }
+
+    return top;
+}
+
+//==============================================================================
+
+bool SparseLinearSolver::factorize(const sunindextype *pColumnStarts,
+                                   const sunindextype *pRowIndices,
+                                   const double *pValues)
+{
+    // Compute the LU factorisation, with partial pivoting, of the given matrix,
+    // which is in compressed sparse column format, using a left-looking
+    // algorithm (Gilbert-Peierls), i.e. column j of L and U is computed by
+    // solving L*x = A(:,j) where only the non-zero rows of x, as determined by
+    // the graph of L, get visited
+    // Note: the row indices of L are original row indices until the very end,
+    //       at which point they get permuted using our pivots...
+
+    sunindextype lNnz = 0;
+    sunindextype uNnz = 0;
+
+    mPivots.fill(-1);
+    mWork.fill(0.0);
+
+    for (sunindextype j = 0; j < mSize; ++j) {
+        mLColumnStarts[int(j)] = lNnz;
+        mUColumnStarts[int(j)] = uNnz;
+
+        // Make sure that L and U are big enough for another column
+
+        if (mLRowIndices.count() < lNnz+mSize) {
+            mLRowIndices.resize(int(2*mLRowIndices.count()+mSize));
+            mLValues.resize(mLRowIndices.count());
+        }
+
+        if (mURowIndices.count() < uNnz+mSize) {
+            mURowIndices.resize(int(2*mURowIndices.count()+mSize));
+            mUValues.resize(mURowIndices.count());
+        }
+
+        // Solve L*x = A(:,j)
+
+        sunindextype top = reach(pColumnStarts, pRowIndices, j);
+
+        for (sunindextype p = pColumnStarts[j]; p < pColumnStarts[j+1]; ++p) {
+            mWork[int(pRowIndices[p])] = pValues[p];
+        }
+
+        for (sunindextype p = top; p < mSize; ++p) {
+            sunindextype row = mStack[int(p)];
+            sunindextype column = mPivots[int(row)];
+
+            if (column < 0) {
+                continue;
+            }
+
+            double value = mWork[int(row)];
+
+            for (sunindextype q = mLColumnStarts[int(column)]+1; q < mLColumnStarts[int(column+1)]; ++q) {
+                mWork[int(mLRowIndices[int(q)])] -= mLValues[int(q)]*value;
+            }
+        }
+
+        // Look for our pivot, i.e. the largest entry among the rows that are
+        // not yet pivotal, and add the entries of the rows that are pivotal to
+        // U
+
+        sunindextype pivotRow = -1;
+        double pivotValue = -1.0;
+
+        for (sunindextype p = top; p < mSize; ++p) {
+            sunindextype row = mStack[int(p)];
+
+            if (mPivots[int(row)] < 0) {
+                double value = qAbs(mWork[int(row)]);
+
+                if (value > pivotValue) {
+                    pivotRow = row;
+                    pivotValue = value;
+                }
+            } else {
+                mURowIndices[int(uNnz)] = mPivots[int(row)];
+                mUValues[int(uNnz++)] = mWork[int(row)];
+            }
+        }
+
+        if ((pivotRow < 0) || (pivotValue <= 0.0) || !qIsFinite(pivotValue)) {
+            // Our matrix is singular, so clean up our work array and leave
+
+            for (sunindextype p = top; p < mSize; ++p) {
+                mWork[int(mStack[int(p)])] = 0.0;
+            }
+
+            return false;
+        }
+
+        double pivot = mWork[int(pivotRow)];
+
+        mURowIndices[int(uNnz)] = j;
+        mUValues[int(uNnz++)] = pivot;
+
+        mPivots[int(pivotRow)] = j;
+
+        // Add the entries of the rows that are not yet pivotal to L, scaled by
+        // our pivot, and clean up our work array
+
+        mLRowIndices[int(lNnz)] = pivotRow;
+        mLValues[int(lNnz++)] = 1.0;
+
+        for (sunindextype p = top; p < mSize; ++p) {
+            sunindextype row = mStack[int(p)];
+
+            if (mPivots[int(row)] < 0) {
+                mLRowIndices[int(lNnz)] = row;
+                mLValues[int(lNnz++)] = mWork[int(row)]/pivot;
+            }
+
+            mWork[int(row)] = 0.0;
+        }
+    }
+
+    mLColumnStarts[int(mSize)] = lNnz;
+    mUColumnStarts[int(mSize)] = uNnz;
+
+    // Permute the row indices of L
+
+    for (sunindextype p = 0; p < lNnz; ++p) {
+        mLRowIndices[int(p)] = mPivots[int(mLRowIndices[int(p)])];
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+void SparseLinearSolver::solve(double *pX, const double *pB)
+{
+    // Solve A*x = b, i.e. L*U*x = P*b, using our LU factorisation
+
+    for (sunindextype i = 0; i < mSize; ++i) {
+        pX[mPivots[int(i)]] = pB[i];
+    }
+
+    for (sunindextype j = 0; j < mSize; ++j) {
+        double value = pX[j];
+
+        for (sunindextype p = mLColumnStarts[int(j)]+1; p < mLColumnStarts[int(j+1)]; ++p) {
+            pX[mLRowIndices[int(p)]] -= mLValues[int(p)]*value;
+        }
+    }
+
+    for (sunindextype j = mSize-1; j >= 0; --j) {
+        pX[j] /= mUValues[int(mUColumnStarts[int(j+1)]-1)];
+
+        double value = pX[j];
+
+        for (sunindextype p = mUColumnStarts[int(j)]; p < mUColumnStarts[int(j+1)]-1; ++p) {
+            pX[mURowIndices[int(p)]] -= mUValues[int(p)]*value;
+        }
+    }
+}
+
+//==============================================================================
+
+struct SparseLinearSolverContent
+{
+    SparseLinearSolver *solver;
+    QVector<double> work;
+    sunindextype lastFlag;
+};
+
+//==============================================================================
+
+static SparseLinearSolverContent * content(SUNLinearSolver pLinearSolver)
+{
+    // Return the content of the given linear solver
+
+    return static_cast<SparseLinearSolverContent *>(pLinearSolver->content);
+}
+
+//==============================================================================
+
+static SUNLinearSolver_Type sparseLinearSolverType(SUNLinearSolver pLinearSolver)
+{
+    Q_UNUSED(pLinearSolver)
+
+    // We are a direct linear solver
+
+    return SUNLINEARSOLVER_DIRECT;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverInitialize(SUNLinearSolver pLinearSolver)
+{
+    // Nothing to initialise as such
+
+    content(pLinearSolver)->lastFlag = SUNLS_SUCCESS;
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverSetup(SUNLinearSolver pLinearSolver,
+                                   SUNMatrix pMatrix)
+{
+    // Factorise the given matrix
+
+    SparseLinearSolverContent *linearSolverContent = content(pLinearSolver);
+
+    linearSolverContent->lastFlag = linearSolverContent->solver->factorize(SUNSparseMatrix_IndexPointers(pMatrix),
+                                                                           SUNSparseMatrix_IndexValues(pMatrix),
+                                                                           SUNSparseMatrix_Data(pMatrix))?
+                                        SUNLS_SUCCESS:
+                                        SUNLS_LUFACT_FAIL;
+
+    return int(linearSolverContent->lastFlag);
+}
+
+//==============================================================================
+
+static int sparseLinearSolverSolve(SUNLinearSolver pLinearSolver,
+                                   SUNMatrix pMatrix, N_Vector pX, N_Vector pB,
+                                   realtype pTolerance)
+{
+    Q_UNUSED(pMatrix)
+    Q_UNUSED(pTolerance)
+
+    // Solve our linear system using the factorisation that was computed during
+    // our last setup
+    // Note: we go through our work array in case x and b are the same
+    //       vector...
+
+    SparseLinearSolverContent *linearSolverContent = content(pLinearSolver);
+    double *x = N_VGetArrayPointer_Serial(pX);
+    double *work = linearSolverContent->work.data();
+
+    memcpy(work, N_VGetArrayPointer_Serial(pB), size_t(linearSolverContent->work.count())*sizeof(double));
+
+    linearSolverContent->solver->solve(x, work);
+
+    linearSolverContent->lastFlag = SUNLS_SUCCESS;
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+static sunindextype sparseLinearSolverLastFlag(SUNLinearSolver pLinearSolver)
+{
+    // Return our last flag
+
+    return content(pLinearSolver)->lastFlag;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverFree(SUNLinearSolver pLinearSolver)
+{
+    // Delete our content and then ourselves
+
+    if (pLinearSolver == nullptr) {
+        return SUNLS_SUCCESS;
+    }
+
+    if (pLinearSolver->content != nullptr) {
+        delete content(pLinearSolver)->solver;
+        delete content(pLinearSolver);
+
+        pLinearSolver->content = nullptr;
+    }
+
+    SUNLinSolFreeEmpty(pLinearSolver);
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+SUNLinearSolver sparseLinearSolver(N_Vector pVector, SUNMatrix pMatrix)
+{
+    // Create a sparse direct linear solver for the given (square, compressed
+    // sparse column) matrix
+
+    if (   (SUNMatGetID(pMatrix) != SUNMATRIX_SPARSE)
+        || (SUNSparseMatrix_SparseType(pMatrix) != CSC_MAT)
+        || (SUNSparseMatrix_Rows(pMatrix) != SUNSparseMatrix_Columns(pMatrix))
+        || (N_VGetLength_Serial(pVector) != SUNSparseMatrix_Rows(pMatrix))) {
+        return nullptr;
+    }
+
+    SUNLinearSolver res = SUNLinSolNewEmpty();
+
+    res->ops->gettype = sparseLinearSolverType;
+    res->ops->initialize = sparseLinearSolverInitialize;
+    res->ops->setup = sparseLinearSolverSetup;
+    res->ops->solve = sparseLinearSolverSolve;
+    res->ops->lastflag = sparseLinearSolverLastFlag;
+    res->ops->free = sparseLinearSolverFree;
+
+    sunindextype size = SUNSparseMatrix_Rows(pMatrix);
+
+    res->content = new SparseLinearSolverContent {
+                                                     new SparseLinearSolver(size),
+                                                     QVector<double>(int(size)),
+                                                     SUNLS_SUCCESS
+                                                 };
+
+    return res;
+}
+
+//==============================================================================
+
+void setSparseMatrix(SUNMatrix pMatrix, const QVector<int> &pColumnStarts,
+                     const QVector<int> &pRowIndices, const double *pValues)
+{
+    // Set the structure and values of the given sparse matrix using the given
+    // sparsity pattern, in compressed sparse column format, and values
+    // Note #1: we make sure that all the diagonal entries are part of our
+    //          sparse matrix since SUNDIALS needs them to compute I-gamma*J
+    //          and would otherwise have to reallocate our sparse matrix...
+    // Note #2: our sparse matrix must be able to hold the given number of
+    //          non-zero entries plus one for each column...
+
+    sunindextype *columnStarts = SUNSparseMatrix_IndexPointers(pMatrix);
+    sunindextype *rowIndices = SUNSparseMatrix_IndexValues(pMatrix);
+    double *values = SUNSparseMatrix_Data(pMatrix);
+    sunindextype nnz = 0;
+
+    for (int j = 0, jMax = pColumnStarts.count()-1; j < jMax; ++j) {
+        bool diagonal = false;
+
+        columnStarts[j] = nnz;
+
+        for (int k = pColumnStarts[j], kMax = pColumnStarts[j+1]; k < kMax; ++k) {
+            int i = pRowIndices[k];
+
+            if (!diagonal && (i >= j)) {
+                if (i > j) {
+                    rowIndices[nnz] = j;
+                    values[nnz++] = 0.0;
+                }
+
+                diagonal = true;
+            }
+
+            rowIndices[nnz] = i;
+            values[nnz++] = pValues[k];
+        }
+
+        if (!diagonal) {
+            rowIndices[nnz] = j;
+            values[nnz++] = 0.0;
+        }
+    }
+
+    columnStarts[pColumnStarts.count()-1] = nnz;
+}
+
+//==============================================================================
+
+} // namespace SUNDIALS
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
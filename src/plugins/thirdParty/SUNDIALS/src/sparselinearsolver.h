@@ -0,0 +1,98 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Sparse linear solver
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "sundialsglobal.h"
+
+//==============================================================================
+
+#include <QVector>
+
+//==============================================================================
+
+#include "sundialsbegin.h"
+    #include "nvector/nvector_serial.h"
+    #include "sundials/sundials_linearsolver.h"
+    #include "sunmatrix/sunmatrix_sparse.h"
+#include "sundialsend.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SUNDIALS {
+
+//==============================================================================
+
+class SUNDIALS_EXPORT SparseLinearSolver
+{
+public:
+    explicit SparseLinearSolver(sunindextype pSize);
+
+    bool factorize(const sunindextype *pColumnStarts,
+                   const sunindextype *pRowIndices, const double *pValues);
+    void solve(double *pX, const double *pB);
+
+private:
+    sunindextype mSize;
+
+    QVector<sunindextype> mLColumnStarts;
+    QVector<sunindextype> mLRowIndices;
+    QVector<double> mLValues;
+
+    QVector<sunindextype> mUColumnStarts;
+    QVector<sunindextype> mURowIndices;
+    QVector<double> mUValues;
+
+    QVector<sunindextype> mPivots;
+
+    QVector<double> mWork;
+    QVector<sunindextype> mStack;
+    QVector<sunindextype> mPositions;
+    QVector<sunindextype> mMarks;
+    sunindextype mMark = 0;
+
+    sunindextype reach(const sunindextype *pColumnStarts,
+                       const sunindextype *pRowIndices, sunindextype pColumn);
+};
+
+//==============================================================================
+
+SUNLinearSolver SUNDIALS_EXPORT sparseLinearSolver(N_Vector pVector,
+                                                   SUNMatrix pMatrix);
+
+void SUNDIALS_EXPORT setSparseMatrix(SUNMatrix pMatrix,
+                                     const QVector<int> &pColumnStarts,
+                                     const QVector<int> &pRowIndices,
+                                     const double *pValues);
+
+//==============================================================================
+
+} // namespace SUNDIALS
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,216 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+
+//==============================================================================
+// SUNDIALS tests
+//==============================================================================
+
+#include "sparselinearsolver.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QRandomGenerator>
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+#include "sundialsbegin.h"
+    #include "sunlinsol/sunlinsol_dense.h"
+    #include "sunmatrix/sunmatrix_dense.h"
+#include "sundialsend.h"
+
+//==============================================================================
+
+#include <algorithm>
+
+//==============================================================================
+
+static const sunindextype Size = 100;
+static const double       Density = 0.05;
+
+//==============================================================================
+
+static SUNMatrix randomSparseMatrix(quint32 pSeed, double pDiagonal,
+                                    bool pPermuteRows)
+{
+    // Return a random dense matrix, with a given proportion of non-zero
+    // entries and the given value added to its diagonal, and whose rows are
+    // randomly permuted, if requested
+
+    QRandomGenerator generator(pSeed);
+    SUNMatrix res = SUNDenseMatrix(Size, Size);
+    QVector<sunindextype> rows(int(Size));
+
+    for (sunindextype i = 0; i < Size; ++i) {
+        rows[int(i)] = i;
+    }
+
+    if (pPermuteRows) {
+        std::shuffle(rows.begin(), rows.end(), generator);
+    }
+
+    for (sunindextype j = 0; j < Size; ++j) {
+        for (sunindextype i = 0; i < Size; ++i) {
+            double value = (generator.generateDouble() < Density)?
+                               2.0*generator.generateDouble()-1.0:
+                               0.0;
+
+            if (i == j) {
+                value += pDiagonal;
+            }
+
+            SM_ELEMENT_D(res, rows[int(i)], j) = value;
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+static void compareSolvers(SUNMatrix pDenseMatrix)
+{
+    // Solve a linear system with a random right-hand side using both SUNDIALS'
+    // dense linear solver and our sparse linear solver, and check that we get
+    // the same solution
+
+    QRandomGenerator generator(Size);
+    N_Vector b = N_VNew_Serial(Size);
+    N_Vector denseX = N_VNew_Serial(Size);
+    N_Vector sparseX = N_VNew_Serial(Size);
+
+    for (sunindextype i = 0; i < Size; ++i) {
+        NV_Ith_S(b, i) = 2.0*generator.generateDouble()-1.0;
+    }
+
+    // Solve our system using SUNDIALS' dense linear solver
+    // Note: SUNDIALS' dense linear solver factorises its matrix in place, so
+    //       we first create our sparse matrix...
+
+    SUNMatrix sparseMatrix = SUNSparseFromDenseMatrix(pDenseMatrix, 0.0, CSC_MAT);
+    SUNLinearSolver denseLinearSolver = SUNLinSol_Dense(denseX, pDenseMatrix);
+
+    QCOMPARE(SUNLinSolInitialize(denseLinearSolver), SUNLS_SUCCESS);
+    QCOMPARE(SUNLinSolSetup(denseLinearSolver, pDenseMatrix), SUNLS_SUCCESS);
+    QCOMPARE(SUNLinSolSolve(denseLinearSolver, pDenseMatrix, denseX, b, 0.0), SUNLS_SUCCESS);
+
+    // Solve our system using our sparse linear solver
+
+    SUNLinearSolver sparseLinearSolver = OpenCOR::SUNDIALS::sparseLinearSolver(sparseX, sparseMatrix);
+
+    QVERIFY(sparseLinearSolver != nullptr);
+    QCOMPARE(SUNLinSolInitialize(sparseLinearSolver), SUNLS_SUCCESS);
+    QCOMPARE(SUNLinSolSetup(sparseLinearSolver, sparseMatrix), SUNLS_SUCCESS);
+    QCOMPARE(SUNLinSolSolve(sparseLinearSolver, sparseMatrix, sparseX, b, 0.0), SUNLS_SUCCESS);
+
+    // Compare our solutions
+
+    double maximumValue = 0.0;
+    double maximumDifference = 0.0;
+
+    for (sunindextype i = 0; i < Size; ++i) {
+        maximumValue = qMax(maximumValue, qAbs(NV_Ith_S(denseX, i)));
+        maximumDifference = qMax(maximumDifference, qAbs(NV_Ith_S(sparseX, i)-NV_Ith_S(denseX, i)));
+    }
+
+    QVERIFY(maximumDifference <= 1.0e-9*qMax(maximumValue, 1.0));
+
+    // Clean up things
+
+    SUNLinSolFree(sparseLinearSolver);
+    SUNLinSolFree(denseLinearSolver);
+    SUNMatDestroy(sparseMatrix);
+    SUNMatDestroy(pDenseMatrix);
+    N_VDestroy_Serial(sparseX);
+    N_VDestroy_Serial(denseX);
+    N_VDestroy_Serial(b);
+}
+
+//==============================================================================
+
+void Tests::diagonallyDominantTests()
+{
+    // Compare our sparse linear solver with SUNDIALS' dense linear solver on
+    // diagonally dominant systems, which don't need any pivoting
+
+    for (quint32 seed = 1; seed <= 10; ++seed) {
+        compareSolvers(randomSparseMatrix(seed, Size, false));
+    }
+}
+
+//==============================================================================
+
+void Tests::generalTests()
+{
+    // Compare our sparse linear solver with SUNDIALS' dense linear solver on
+    // systems that have a (small) non-zero diagonal, but that are not
+    // diagonally dominant
+
+    for (quint32 seed = 1; seed <= 10; ++seed) {
+        compareSolvers(randomSparseMatrix(seed, 0.5, false));
+    }
+}
+
+//==============================================================================
+
+void Tests::pivotingTests()
+{
+    // Compare our sparse linear solver with SUNDIALS' dense linear solver on
+    // systems whose rows have been permuted, which means that most of their
+    // diagonal entries are zero and that they can only be solved with pivoting
+
+    for (quint32 seed = 1; seed <= 10; ++seed) {
+        compareSolvers(randomSparseMatrix(seed, Size, true));
+    }
+}
+
+//==============================================================================
+
+void Tests::singularTests()
+{
+    // Make sure that our sparse linear solver fails to factorise a singular
+    // system, i.e. one with an empty column
+
+    SUNMatrix denseMatrix = randomSparseMatrix(1, Size, false);
+
+    for (sunindextype i = 0; i < Size; ++i) {
+        SM_ELEMENT_D(denseMatrix, i, Size/2) = 0.0;
+    }
+
+    SUNMatrix sparseMatrix = SUNSparseFromDenseMatrix(denseMatrix, 0.0, CSC_MAT);
+    N_Vector x = N_VNew_Serial(Size);
+    SUNLinearSolver sparseLinearSolver = OpenCOR::SUNDIALS::sparseLinearSolver(x, sparseMatrix);
+
+    QVERIFY(SUNLinSolSetup(sparseLinearSolver, sparseMatrix) != SUNLS_SUCCESS);
+
+    SUNLinSolFree(sparseLinearSolver);
+    SUNMatDestroy(sparseMatrix);
+    SUNMatDestroy(denseMatrix);
+    N_VDestroy_Serial(x);
+}
+
+//==============================================================================
+
+QTEST_APPLESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -42,7 +42,12 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QtConcurrent/QtConcurrent>
+
+//==============================================================================
+
 #include <cfloat>
+#include <cstring>
 
 //==============================================================================
 
@@ -184,8 +189,15 @@ QColor GraphPanelPlotGraphProperties::symbolFillColor() const
 
 //==============================================================================
 
+static const QRectF InvalidRect = QRectF(0.0, 0.0, -1.0, -1.0);
+
+//==============================================================================
+
 GraphPanelPlotGraphRun::GraphPanelPlotGraphRun(GraphPanelPlotGraph *pOwner) :
-    mOwner(pOwner)
+    mOwner(pOwner),
+    mBoundingRect(InvalidRect),
+    mBoundingLogRect(InvalidRect),
+    mLastBoundingRect(InvalidRect)
 {
     // Customise ourselves a bit
 
@@ -206,106 +218,737 @@ GraphPanelPlotGraph * GraphPanelPlotGraphRun::owner() const
 
 //==============================================================================
 
+GraphPanelPlotGraphRunData::GraphPanelPlotGraphRunData(const GraphPanelPlotGraphRun *pRun,
+                                                       const double *pDataX,
+                                                       const double *pDataY,
+                                                       quint64 pSize) :
+    mRun(pRun),
+    mDataX(pDataX),
+    mDataY(pDataY),
+    mSize(pSize)
+{
+}
+
+//==============================================================================
+
+size_t GraphPanelPlotGraphRunData::size() const
+{
+    // Return our size
+
+    return size_t(mSize);
+}
+
+//==============================================================================
+
+QPointF GraphPanelPlotGraphRunData::sample(size_t pIndex) const
+{
+    // Return the sample at the given index
+
+    return QPointF(mDataX[pIndex], mDataY[pIndex]);
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRunData::boundingRect() const
+{
+    // Return the bounding rectangle of our run, which is maintained as samples
+    // get added to it, rather than have Qwt go through all of our samples
+
+    return mRun->boundingRect();
+}
+
+//==============================================================================
+
+// Level of detail of our runs
+// Note #1: level L of a run consists of buckets of 2^(FirstBucketShift+L)
+//          consecutive samples. Each bucket keeps track of the index of the
+//          sample with the smallest Y value and of the one with the largest Y
+//          value, which, together with the first and last samples of the
+//          bucket, is all we need to draw the bucket within a pixel column
+//          (i.e. M4 aggregation)...
+// Note #2: only complete buckets are stored, meaning that a level can be
+//          extended as new samples get appended to a run, without having to
+//          recompute anything that was previously computed...
+// Note #3: we only use our levels of detail when our X values are increasing,
+//          which is typically the case when plotting something against the
+//          variable of integration...
+// Note #4: a level may have more buckets than a QVector can hold, hence we
+//          use std::vector for them...
+
+static const int FirstBucketShift = 4;
+
+// Maximum number of points that we draw at once, be it as a polyline or as
+// symbols
+
+static const int ChunkSize = 65536;
+
+static const quint64 NoIndex = ~quint64(0);
+
+//==============================================================================
+
 void GraphPanelPlotGraphRun::setRawSamples(const double *pDataX,
                                            const double *pDataY,
-                                           int pSize)
+                                           quint64 pSize)
 {
-    // Set the given raw samples and keep track of those that are valid
+    // Reset ourselves if we are given some new data rather than some more of
+    // our current data
+
+    if ((pDataX != mDataX) || (pDataY != mDataY) || (pSize < mSize)) {
+        mDataX = pDataX;
+        mDataY = pDataY;
+
+        mSize = 0;
 
-    static const QPair<int, int> EmptyData = QPair<int, int>(-1, -1);
+        mValidData.clear();
 
-    QPair<int, int> validData = EmptyData;
+        mBoundingRect = InvalidRect;
+        mBoundingLogRect = InvalidRect;
 
-    if (!mValidData.isEmpty()) {
-        validData = mValidData.last();
+        mIncreasingX = true;
+        mHasLastX = false;
 
-        mValidData.removeLast();
+        mLevels.clear();
     }
 
-    for (int i = mSize; i < pSize; ++i) {
+    // Set the given raw samples and keep track of those that are valid, as
+    // well as of whether our X values are increasing
+
+    for (quint64 i = mSize; i < pSize; ++i) {
         if (   !qIsInf(pDataX[i]) && !qIsNaN(pDataX[i])
             && !qIsInf(pDataY[i]) && !qIsNaN(pDataY[i])) {
-            if (validData == EmptyData) {
-                validData.first = i;
-                validData.second = i;
-            } else if (validData.second == i-1) {
-                validData.second = i;
+            if (   !mValidData.isEmpty() && (i != 0)
+                && (mValidData.last().second == i-1)) {
+                mValidData.last().second = i;
             } else {
-                mValidData << validData;
+                mValidData << QPair<quint64, quint64>(i, i);
+            }
 
-                validData.first = i;
-                validData.second = i;
+            if (mHasLastX && (pDataX[i] < mLastX)) {
+                mIncreasingX = false;
             }
+
+            mLastX = pDataX[i];
+            mHasLastX = true;
         }
     }
 
-    if (validData != EmptyData) {
-        mValidData << validData;
+    // Update our bounding rectangles using our new samples
+
+    if (pSize > mSize) {
+        updateBoundingRects(mSize, pSize-1);
+    } else {
+        mLastBoundingRect = InvalidRect;
     }
 
     mSize = pSize;
 
-    QwtPlotCurve::setRawSamples(pDataX, pDataY, pSize);
+    // Use our raw samples as our data
+    // Note: we don't use QwtPlotCurve::setRawSamples() since it only supports
+    //       32-bit sizes...
+
+    setData(new GraphPanelPlotGraphRunData(this, pDataX, pDataY, pSize));
+
+    // Update our levels of detail
+
+    updateLevels();
+}
+
+//==============================================================================
+
+const double * GraphPanelPlotGraphRun::rawDataX() const
+{
+    // Return our raw X values
+
+    return mDataX;
+}
+
+//==============================================================================
+
+const double * GraphPanelPlotGraphRun::rawDataY() const
+{
+    // Return our raw Y values
+
+    return mDataY;
 }
 
 //==============================================================================
 
-void GraphPanelPlotGraphRun::drawLines(QPainter *pPainter,
-                                       const QwtScaleMap &pMapX,
-                                       const QwtScaleMap &pMapY,
-                                       const QRectF &pCanvasRect,
-                                       int pFrom, int pTo) const
+void GraphPanelPlotGraphRun::directPaint(QwtPlotDirectPainter *pDirectPainter,
+                                         quint64 pFrom)
 {
-    // Draw our lines
+    // Direct paint ourselves from the given sample
+    // Note: QwtPlotDirectPainter::drawSeries() only supports 32-bit indices, so
+    //       we keep track of our 64-bit starting index and use it in
+    //       drawSeries(), which gets called while we are being direct
+    //       painted...
 
-    for (const auto &validData : mValidData) {
-        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
-            int from = (   (pFrom >= validData.first)
-                        && (pFrom <= validData.second))?
-                           pFrom:
-                           validData.first;
-            int to = (   (pTo >= validData.first)
-                      && (pTo <= validData.second))?
-                         pTo:
-                         validData.second;
+    mDirectPainting = true;
+    mDirectPaintFrom = pFrom;
 
-            QwtPlotCurve::drawLines(pPainter, pMapX, pMapY,
-                                    pCanvasRect, from, to);
+    pDirectPainter->drawSeries(this, 0, -1);
+
+    mDirectPainting = false;
+}
+
+//==============================================================================
+
+static void uniteRect(QRectF &pRect, double pMinX, double pMaxX,
+                      double pMinY, double pMaxY)
+{
+    // Unite the given rectangle with the given extent, if valid
+    // Note: we don't rely on QRectF::united() since it ignores rectangles that
+    //       have a null width and height, i.e. rectangles that are made of a
+    //       single point...
+
+    if ((pMinX > pMaxX) || (pMinY > pMaxY)) {
+        return;
+    }
+
+    if (pRect == InvalidRect) {
+        pRect = QRectF(pMinX, pMinY, pMaxX-pMinX, pMaxY-pMinY);
+    } else {
+        double minX = qMin(pRect.left(), pMinX);
+        double maxX = qMax(pRect.right(), pMaxX);
+        double minY = qMin(pRect.top(), pMinY);
+        double maxY = qMax(pRect.bottom(), pMaxY);
+
+        pRect = QRectF(minX, minY, maxX-minX, maxY-minY);
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::updateBoundingRects(quint64 pFrom, quint64 pTo)
+{
+    // Update our bounding rectangles using the valid samples within the given
+    // range, and keep track of the bounding rectangle of those samples
+    // Note #1: our valid data ranges are ordered, so we only need to go
+    //          through those that end within the given range...
+    // Note #2: the samples of a valid range are all finite, so we can update
+    //          our extents without having to check each sample for NaN or
+    //          infinity. This means that we can process our samples in
+    //          batches of lanes, with no branching, and therefore let the
+    //          compiler vectorise our loops...
+    // Note #3: for our bounding log rectangle, we still need to check for
+    //          positive values, but this is done using masks rather than
+    //          branches...
+
+    enum {
+        Lanes = 4
+    };
+
+    mLastBoundingRect = InvalidRect;
+
+    for (auto validData = mValidData.crbegin(), validDataEnd = mValidData.crend();
+         (validData != validDataEnd) && (validData->second >= pFrom); ++validData) {
+        quint64 from = qMax(pFrom, validData->first);
+        quint64 to = qMin(pTo, validData->second);
+
+        if (from > to) {
+            continue;
         }
+
+        double minX[Lanes];
+        double maxX[Lanes];
+        double minY[Lanes];
+        double maxY[Lanes];
+        double minLogX[Lanes];
+        double maxLogX[Lanes];
+        double minLogY[Lanes];
+        double maxLogY[Lanes];
+
+        for (int j = 0; j < Lanes; ++j) {
+            minX[j] = minY[j] = minLogX[j] = minLogY[j] = qInf();
+            maxX[j] = maxY[j] = maxLogX[j] = maxLogY[j] = -qInf();
+        }
+
+        const double *dataX = mDataX+from;
+        const double *dataY = mDataY+from;
+        quint64 count = to-from+1;
+        quint64 i = 0;
+
+        for (quint64 iMax = count-count%Lanes; i < iMax; i += Lanes) {
+            for (int j = 0; j < Lanes; ++j) {
+                double x = dataX[i+j];
+                double y = dataY[i+j];
+                bool positive = (x > 0.0) && (y > 0.0);
+
+                minX[j] = (x < minX[j])?x:minX[j];
+                maxX[j] = (x > maxX[j])?x:maxX[j];
+                minY[j] = (y < minY[j])?y:minY[j];
+                maxY[j] = (y > maxY[j])?y:maxY[j];
+
+                minLogX[j] = (positive && (x < minLogX[j]))?x:minLogX[j];
+                maxLogX[j] = (positive && (x > maxLogX[j]))?x:maxLogX[j];
+                minLogY[j] = (positive && (y < minLogY[j]))?y:minLogY[j];
+                maxLogY[j] = (positive && (y > maxLogY[j]))?y:maxLogY[j];
+            }
+        }
+
+        for (int j = 0; i < count; ++i, ++j) {
+            double x = dataX[i];
+            double y = dataY[i];
+            bool positive = (x > 0.0) && (y > 0.0);
+
+            minX[j] = qMin(minX[j], x);
+            maxX[j] = qMax(maxX[j], x);
+            minY[j] = qMin(minY[j], y);
+            maxY[j] = qMax(maxY[j], y);
+
+            if (positive) {
+                minLogX[j] = qMin(minLogX[j], x);
+                maxLogX[j] = qMax(maxLogX[j], x);
+                minLogY[j] = qMin(minLogY[j], y);
+                maxLogY[j] = qMax(maxLogY[j], y);
+            }
+        }
+
+        for (int j = 1; j < Lanes; ++j) {
+            minX[0] = qMin(minX[0], minX[j]);
+            maxX[0] = qMax(maxX[0], maxX[j]);
+            minY[0] = qMin(minY[0], minY[j]);
+            maxY[0] = qMax(maxY[0], maxY[j]);
+
+            minLogX[0] = qMin(minLogX[0], minLogX[j]);
+            maxLogX[0] = qMax(maxLogX[0], maxLogX[j]);
+            minLogY[0] = qMin(minLogY[0], minLogY[j]);
+            maxLogY[0] = qMax(maxLogY[0], maxLogY[j]);
+        }
+
+        uniteRect(mLastBoundingRect, minX[0], maxX[0], minY[0], maxY[0]);
+        uniteRect(mBoundingRect, minX[0], maxX[0], minY[0], maxY[0]);
+        uniteRect(mBoundingLogRect, minLogX[0], maxLogX[0], minLogY[0], maxLogY[0]);
     }
 }
 
 //==============================================================================
 
-void GraphPanelPlotGraphRun::drawSymbols(QPainter *pPainter,
-                                         const QwtSymbol &pSymbol,
-                                         const QwtScaleMap &pMapX,
-                                         const QwtScaleMap &pMapY,
-                                         const QRectF &pCanvasRect,
-                                         int pFrom, int pTo) const
+QRectF GraphPanelPlotGraphRun::boundingRect() const
+{
+    // Return our bounding rectangle
+
+    return mBoundingRect;
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRun::boundingLogRect() const
+{
+    // Return our bounding log rectangle
+
+    return mBoundingLogRect;
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRun::lastBoundingRect() const
 {
-    // Draw our symbols
+    // Return the bounding rectangle of the samples that were added the last
+    // time we were given some raw samples
+
+    return mLastBoundingRect;
+}
 
-    for (const auto &validData : mValidData) {
-        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
-            int from = (   (pFrom >= validData.first)
-                        && (pFrom <= validData.second))?
-                           pFrom:
-                           validData.first;
-            int to = (   (pTo >= validData.first)
-                      && (pTo <= validData.second))?
-                         pTo:
-                         validData.second;
+//==============================================================================
+
+quint64 GraphPanelPlotGraphRun::bucketSize(int pLevel) const
+{
+    // Return the number of samples in a bucket of the given level
 
-            QwtPlotCurve::drawSymbols(pPainter, pSymbol, pMapX, pMapY,
-                                      pCanvasRect, from, to);
+    return quint64(1) << (FirstBucketShift+pLevel);
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::updateLevels()
+{
+    // Update our levels of detail with the buckets that have been completed
+    // since we were last called
+    // Note: a bucket that contains invalid samples may end up with meaningless
+    //       indices, but such a bucket is never used since we only draw
+    //       buckets that are fully contained within some valid data...
+
+    if (!mIncreasingX) {
+        mLevels.clear();
+
+        return;
+    }
+
+    for (int level = 0; bucketSize(level) <= mSize; ++level) {
+        if (level == mLevels.count()) {
+            mLevels << GraphPanelPlotGraphRunLevel();
+        }
+
+        GraphPanelPlotGraphRunLevel &buckets = mLevels[level];
+        quint64 bucketsCount = mSize >> (FirstBucketShift+level);
+
+        // Note: we don't reserve space for our new buckets since we are called
+        //       every time some new samples are added, in which case
+        //       reserving exactly what we need would result in a reallocation
+        //       each time, as opposed to letting push_back() grow our
+        //       buckets geometrically...
+
+        for (quint64 i = buckets.size(); i < bucketsCount; ++i) {
+            quint64 minIndex = i << (FirstBucketShift+level);
+            quint64 maxIndex = minIndex;
+
+            if (level == 0) {
+                for (quint64 j = minIndex+1, jMax = minIndex+bucketSize(0); j < jMax; ++j) {
+                    double y = mDataY[j];
+
+                    if (y < mDataY[minIndex]) {
+                        minIndex = j;
+                    }
+
+                    if (y > mDataY[maxIndex]) {
+                        maxIndex = j;
+                    }
+                }
+            } else {
+                const GraphPanelPlotGraphRunLevel &lowerBuckets = mLevels[level-1];
+                const QPair<quint64, quint64> &firstBucket = lowerBuckets[2*i];
+                const QPair<quint64, quint64> &secondBucket = lowerBuckets[2*i+1];
+
+                minIndex = (mDataY[secondBucket.first] < mDataY[firstBucket.first])?
+                               secondBucket.first:
+                               firstBucket.first;
+                maxIndex = (mDataY[secondBucket.second] > mDataY[firstBucket.second])?
+                               secondBucket.second:
+                               firstBucket.second;
+            }
+
+            buckets.push_back(QPair<quint64, quint64>(minIndex, maxIndex));
         }
     }
 }
 
 //==============================================================================
 
-static const QRectF InvalidRect = QRectF(0.0, 0.0, -1.0, -1.0);
+void GraphPanelPlotGraphRun::addPoint(QPolygonF &pPoints, quint64 &pLastIndex,
+                                      const QwtScaleMap &pMapX,
+                                      const QwtScaleMap &pMapY,
+                                      quint64 pIndex) const
+{
+    // Add the given sample to our points, unless it is the last one we added
+
+    if (pIndex != pLastIndex) {
+        pPoints << QPointF(pMapX.transform(mDataX[pIndex]),
+                           pMapY.transform(mDataY[pIndex]));
+
+        pLastIndex = pIndex;
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::addLevelPoints(QPolygonF &pPoints,
+                                            quint64 &pLastIndex,
+                                            const QwtScaleMap &pMapX,
+                                            const QwtScaleMap &pMapY,
+                                            int pLevel, quint64 pFrom,
+                                            quint64 pTo) const
+{
+    // Add the points needed to draw the given range of samples using the
+    // given level of detail
+    // Note: the samples before the first complete bucket and after the last
+    //       complete bucket of the given level are added using the level
+    //       below, which means that we never add more than a couple of buckets
+    //       worth of points per level...
+
+    if (pLevel < 0) {
+        for (quint64 i = pFrom; i <= pTo; ++i) {
+            addPoint(pPoints, pLastIndex, pMapX, pMapY, i);
+        }
+
+        return;
+    }
+
+    const GraphPanelPlotGraphRunLevel &buckets = mLevels[pLevel];
+    int shift = FirstBucketShift+pLevel;
+    quint64 firstBucket = (pFrom+bucketSize(pLevel)-1) >> shift;
+    quint64 endBucket = qMin((pTo+1) >> shift, quint64(buckets.size()));
+
+    if (firstBucket >= endBucket) {
+        addLevelPoints(pPoints, pLastIndex, pMapX, pMapY, pLevel-1, pFrom, pTo);
+
+        return;
+    }
+
+    if (pFrom < (firstBucket << shift)) {
+        addLevelPoints(pPoints, pLastIndex, pMapX, pMapY, pLevel-1,
+                       pFrom, (firstBucket << shift)-1);
+    }
+
+    for (quint64 i = firstBucket; i < endBucket; ++i) {
+        const QPair<quint64, quint64> &bucket = buckets[i];
+
+        addPoint(pPoints, pLastIndex, pMapX, pMapY, i << shift);
+
+        if (bucket.first < bucket.second) {
+            addPoint(pPoints, pLastIndex, pMapX, pMapY, bucket.first);
+            addPoint(pPoints, pLastIndex, pMapX, pMapY, bucket.second);
+        } else {
+            addPoint(pPoints, pLastIndex, pMapX, pMapY, bucket.second);
+            addPoint(pPoints, pLastIndex, pMapX, pMapY, bucket.first);
+        }
+
+        addPoint(pPoints, pLastIndex, pMapX, pMapY, ((i+1) << shift)-1);
+    }
+
+    if ((endBucket << shift) <= pTo) {
+        addLevelPoints(pPoints, pLastIndex, pMapX, pMapY, pLevel-1,
+                       endBucket << shift, pTo);
+    }
+}
+
+//==============================================================================
+
+static void drawPolyline(QPainter *pPainter, const QRectF &pClipRect,
+                         const QPolygonF &pPoints)
+{
+    // Draw the given points as a polyline, after having clipped it
+
+    QwtPainter::drawPolyline(pPainter, QwtClipper::clipPolygonF(pClipRect, pPoints));
+}
+
+//==============================================================================
+
+static void drawLineSamples(QPainter *pPainter, const QRectF &pClipRect,
+                            const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                            const double *pDataX, const double *pDataY,
+                            quint64 pFrom, quint64 pTo)
+{
+    // Draw the lines for the given range of (valid) samples, in chunks so that
+    // we never have a polyline with more than ChunkSize points
+
+    QPolygonF points;
+
+    points.reserve(int(qMin(pTo-pFrom+1, quint64(ChunkSize))));
+
+    for (quint64 i = pFrom; i <= pTo; ++i) {
+        points << QPointF(pMapX.transform(pDataX[i]),
+                          pMapY.transform(pDataY[i]));
+
+        if ((points.count() == ChunkSize) && (i != pTo)) {
+            drawPolyline(pPainter, pClipRect, points);
+
+            QPointF lastPoint = points.last();
+
+            points.clear();
+
+            points << lastPoint;
+        }
+    }
+
+    drawPolyline(pPainter, pClipRect, points);
+}
+
+//==============================================================================
+
+static void drawSymbolSamples(QPainter *pPainter, const QwtSymbol &pSymbol,
+                              const QRectF &pClipRect,
+                              const QwtScaleMap &pMapX,
+                              const QwtScaleMap &pMapY, const double *pDataX,
+                              const double *pDataY, quint64 pFrom, quint64 pTo)
+{
+    // Draw the symbols for the given range of (valid) samples that are within
+    // the given clipping rectangle, in chunks of ChunkSize points
+
+    QPolygonF points;
+
+    points.reserve(int(qMin(pTo-pFrom+1, quint64(ChunkSize))));
+
+    for (quint64 i = pFrom; i <= pTo; ++i) {
+        QPointF point = QPointF(pMapX.transform(pDataX[i]),
+                                pMapY.transform(pDataY[i]));
+
+        if (pClipRect.contains(point)) {
+            points << point;
+
+            if (points.count() == ChunkSize) {
+                pSymbol.drawSymbols(pPainter, points);
+
+                points.clear();
+            }
+        }
+    }
+
+    if (!points.isEmpty()) {
+        pSymbol.drawSymbols(pPainter, points);
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::visibleRange(const QwtScaleMap &pMapX,
+                                          const QRectF &pCanvasRect,
+                                          quint64 &pFrom, quint64 &pTo) const
+{
+    // Narrow the given range of (valid) samples down to those that are visible
+    // (plus one on each side, so that lines going across the canvas borders
+    // get drawn), assuming that our X values are increasing
+
+    double minX = pMapX.invTransform(pCanvasRect.left());
+    double maxX = pMapX.invTransform(pCanvasRect.right());
+
+    if (minX > maxX) {
+        qSwap(minX, maxX);
+    }
+
+    quint64 from = quint64(std::lower_bound(mDataX+pFrom, mDataX+pTo+1, minX)-mDataX);
+    quint64 to = quint64(std::upper_bound(mDataX+from, mDataX+pTo+1, maxX)-mDataX);
+
+    pFrom = qMax(pFrom, (from != 0)?from-1:0);
+    pTo = qMin(pTo, to);
+
+    if (pFrom > pTo) {
+        pFrom = pTo;
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawValidLines(QPainter *pPainter,
+                                            const QRectF &pClipRect,
+                                            const QwtScaleMap &pMapX,
+                                            const QwtScaleMap &pMapY,
+                                            const QRectF &pCanvasRect,
+                                            quint64 pFrom, quint64 pTo) const
+{
+    // Draw the lines for the given range of (valid) samples
+    // Note #1: if our X values are increasing, then we only consider the
+    //          samples that are visible, and then use the level of detail that
+    //          has buckets that are no wider than a pixel, meaning that the
+    //          number of points we draw is bounded by the width of our canvas
+    //          rather than by the size of our data...
+    // Note #2: otherwise, we draw all of our samples...
+
+    if (mIncreasingX) {
+        visibleRange(pMapX, pCanvasRect, pFrom, pTo);
+
+        double pixels = qAbs(pMapX.transform(mDataX[pTo])-pMapX.transform(mDataX[pFrom]));
+        int level = -1;
+
+        while (   (level+1 < mLevels.count())
+               && (bucketSize(level+1) <= (pTo-pFrom+1)/qMax(pixels, 1.0))) {
+            ++level;
+        }
+
+        if (level != -1) {
+            QPolygonF points;
+            quint64 lastIndex = NoIndex;
+
+            addLevelPoints(points, lastIndex, pMapX, pMapY, level, pFrom, pTo);
+
+            for (int i = 0, iMax = points.count()-1; i < iMax; i += ChunkSize-1) {
+                drawPolyline(pPainter, pClipRect, points.mid(i, ChunkSize));
+            }
+
+            return;
+        }
+    }
+
+    drawLineSamples(pPainter, pClipRect, pMapX, pMapY, mDataX, mDataY,
+                    pFrom, pTo);
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawValidSymbols(QPainter *pPainter,
+                                              const QwtSymbol &pSymbol,
+                                              const QRectF &pClipRect,
+                                              const QwtScaleMap &pMapX,
+                                              const QwtScaleMap &pMapY,
+                                              const QRectF &pCanvasRect,
+                                              quint64 pFrom, quint64 pTo) const
+{
+    // Draw the symbols for the given range of (valid) samples, only
+    // considering those that are visible
+
+    if (mIncreasingX) {
+        visibleRange(pMapX, pCanvasRect, pFrom, pTo);
+    }
+
+    drawSymbolSamples(pPainter, pSymbol, pClipRect, pMapX, pMapY,
+                      mDataX, mDataY, pFrom, pTo);
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawSeries(QPainter *pPainter,
+                                        const QwtScaleMap &pMapX,
+                                        const QwtScaleMap &pMapY,
+                                        const QRectF &pCanvasRect,
+                                        int pFrom, int pTo) const
+{
+    // Draw our lines and symbols for the given range of samples
+    // Note: Qwt only supports 32-bit indices, so we ignore the given range if
+    //       we are being direct painted, in which case we draw from our 64-bit
+    //       starting index up to our last sample, and otherwise consider a
+    //       negative end index to mean our last sample...
+
+    if (mSize == 0) {
+        return;
+    }
+
+    quint64 from = mDirectPainting?
+                       mDirectPaintFrom:
+                       quint64(qMax(pFrom, 0));
+    quint64 to = (mDirectPainting || (pTo < 0))?
+                     mSize-1:
+                     qMin(quint64(pTo), mSize-1);
+
+    if (from > to) {
+        return;
+    }
+
+    // Draw our lines, clipping them against our canvas, enlarged by the width
+    // of our pen (as done by Qwt)
+
+    if (style() != NoCurve) {
+        double penWidth = qMax(1.0, pen().widthF());
+        QRectF clipRect = pCanvasRect.adjusted(-penWidth, -penWidth, penWidth, penWidth);
+
+        pPainter->save();
+        pPainter->setPen(pen());
+
+        for (const auto &validData : mValidData) {
+            quint64 validFrom = qMax(from, validData.first);
+            quint64 validTo = qMin(to, validData.second);
+
+            if (validFrom <= validTo) {
+                drawValidLines(pPainter, clipRect, pMapX, pMapY, pCanvasRect,
+                               validFrom, validTo);
+            }
+        }
+
+        pPainter->restore();
+    }
+
+    // Draw our symbols, clipping them against our canvas, enlarged by the size
+    // of our symbol
+
+    const QwtSymbol *symbol = this->symbol();
+
+    if ((symbol != nullptr) && (symbol->style() != QwtSymbol::NoSymbol)) {
+        double symbolSize = 0.5*qMax(symbol->size().width(), symbol->size().height());
+        QRectF clipRect = pCanvasRect.adjusted(-symbolSize, -symbolSize, symbolSize, symbolSize);
+
+        pPainter->save();
+
+        for (const auto &validData : mValidData) {
+            quint64 validFrom = qMax(from, validData.first);
+            quint64 validTo = qMin(to, validData.second);
+
+            if (validFrom <= validTo) {
+                drawValidSymbols(pPainter, *symbol, clipRect, pMapX, pMapY,
+                                 pCanvasRect, validFrom, validTo);
+            }
+        }
+
+        pPainter->restore();
+    }
+}
 
 //==============================================================================
 
@@ -451,6 +1094,11 @@ void GraphPanelPlotGraph::removeRuns()
     }
 
     mRuns.clear();
+
+    // Reset the cached version of our bounding rectangles
+
+    mBoundingRect = InvalidRect;
+    mBoundingLogRect = InvalidRect;
 }
 
 //==============================================================================
@@ -716,15 +1364,12 @@ void GraphPanelPlotGraph::setData(double *pDataX, double *pDataY, quint64 pSize,
         return;
     }
 
-    run->setRawSamples(pDataX, pDataY, int(pSize));
+    run->setRawSamples(pDataX, pDataY, pSize);
 
     // Reset the cached version of our bounding rectangles
 
     mBoundingRect = InvalidRect;
     mBoundingLogRect = InvalidRect;
-
-    mBoundingRects.remove(run);
-    mBoundingLogRects.remove(run);
 }
 
 //==============================================================================
@@ -732,74 +1377,16 @@ void GraphPanelPlotGraph::setData(double *pDataX, double *pDataY, quint64 pSize,
 QRectF GraphPanelPlotGraph::boundingRect()
 {
     // Return the cached version of our bounding rectangle, if we have one, or
-    // compute it and return it
+    // compute it from the bounding rectangle of our runs and return it
 
     if ((mBoundingRect == InvalidRect) && !mRuns.isEmpty()) {
         mBoundingRect = QRectF();
 
         for (auto run : mRuns) {
-            if (run->dataSize() != 0) {
-                QRectF boundingRect = mBoundingRects.value(run, InvalidRect);
-
-                if (boundingRect == InvalidRect) {
-                    bool needInitMinX = true;
-                    bool needInitMaxX = true;
-                    bool needInitMinY = true;
-                    bool needInitMaxY = true;
-                    double minX = 1.0;
-                    double maxX = 1.0;
-                    double minY = 1.0;
-                    double maxY = 1.0;
-
-                    for (size_t i = 0, iMax = run->dataSize(); i < iMax; ++i) {
-                        QPointF sample = run->data()->sample(i);
-
-                        if (   !qIsInf(sample.x()) && !qIsNaN(sample.x())
-                            && !qIsInf(sample.y()) && !qIsNaN(sample.y())) {
-                            if (needInitMinX) {
-                                minX = sample.x();
-
-                                needInitMinX = false;
-                            } else if (sample.x() < minX) {
-                                minX = sample.x();
-                            }
-
-                            if (needInitMaxX) {
-                                maxX = sample.x();
-
-                                needInitMaxX = false;
-                            } else if (sample.x() > maxX) {
-                                maxX = sample.x();
-                            }
-
-                            if (needInitMinY) {
-                                minY = sample.y();
-
-                                needInitMinY = false;
-                            } else if (sample.y() < minY) {
-                                minY = sample.y();
-                            }
-
-                            if (needInitMaxY) {
-                                maxY = sample.y();
-
-                                needInitMaxY = false;
-                            } else if (sample.y() > maxY) {
-                                maxY = sample.y();
-                            }
-                        }
-                    }
-
-                    if (!needInitMinX && !needInitMaxX && !needInitMinY && !needInitMaxY) {
-                        boundingRect = QRectF(minX, minY, maxX-minX, maxY-minY);
-
-                        mBoundingRects.insert(run, boundingRect);
-                    }
-                }
+            QRectF boundingRect = run->boundingRect();
 
-                if (boundingRect != InvalidRect) {
-                    mBoundingRect |= boundingRect;
-                }
+            if (boundingRect != InvalidRect) {
+                mBoundingRect |= boundingRect;
             }
         }
     }
@@ -812,76 +1399,16 @@ QRectF GraphPanelPlotGraph::boundingRect()
 QRectF GraphPanelPlotGraph::boundingLogRect()
 {
     // Return the cached version of our bounding log rectangle, if we have one,
-    // or compute it and return it
+    // or compute it from the bounding log rectangle of our runs and return it
 
     if ((mBoundingLogRect == InvalidRect) && !mRuns.isEmpty()) {
         mBoundingLogRect = QRectF();
 
         for (auto run : mRuns) {
-            if (run->dataSize() != 0) {
-                QRectF boundingLogRect = mBoundingLogRects.value(run, InvalidRect);
-
-                if (boundingLogRect == InvalidRect) {
-                    bool needInitMinX = true;
-                    bool needInitMaxX = true;
-                    bool needInitMinY = true;
-                    bool needInitMaxY = true;
-                    double minX = 1.0;
-                    double maxX = 1.0;
-                    double minY = 1.0;
-                    double maxY = 1.0;
-
-                    for (size_t i = 0, iMax = run->dataSize(); i < iMax; ++i) {
-                        QPointF sample = run->data()->sample(i);
-
-                        if (   !qIsInf(sample.x()) && !qIsNaN(sample.x())
-                            &&  (sample.x() > 0.0)
-                            && !qIsInf(sample.y()) && !qIsNaN(sample.y())
-                            &&  (sample.y() > 0.0)) {
-                            if (needInitMinX) {
-                                minX = sample.x();
-
-                                needInitMinX = false;
-                            } else if (sample.x() < minX) {
-                                minX = sample.x();
-                            }
-
-                            if (needInitMaxX) {
-                                maxX = sample.x();
-
-                                needInitMaxX = false;
-                            } else if (sample.x() > maxX) {
-                                maxX = sample.x();
-                            }
-
-                            if (needInitMinY) {
-                                minY = sample.y();
-
-                                needInitMinY = false;
-                            } else if (sample.y() < minY) {
-                                minY = sample.y();
-                            }
-
-                            if (needInitMaxY) {
-                                maxY = sample.y();
-
-                                needInitMaxY = false;
-                            } else if (sample.y() > maxY) {
-                                maxY = sample.y();
-                            }
-                        }
-                    }
-
-                    if (!needInitMinX && !needInitMaxX && !needInitMinY && !needInitMaxY) {
-                        boundingLogRect = QRectF(minX, minY, maxX-minX, maxY-minY);
+            QRectF boundingLogRect = run->boundingLogRect();
 
-                        mBoundingLogRects.insert(run, boundingLogRect);
-                    }
-                }
-
-                if (boundingLogRect != InvalidRect) {
-                    mBoundingLogRect |= boundingLogRect;
-                }
+            if (boundingLogRect != InvalidRect) {
+                mBoundingLogRect |= boundingLogRect;
             }
         }
     }
@@ -891,6 +1418,26 @@ QRectF GraphPanelPlotGraph::boundingLogRect()
 
 //==============================================================================
 
+QRectF GraphPanelPlotGraph::lastBoundingRect(int pRun) const
+{
+    // Return the bounding rectangle of the samples that were last added to the
+    // given run, if it exists
+
+    if (mRuns.isEmpty()) {
+        return InvalidRect;
+    }
+
+    if (pRun == -1) {
+        return mRuns.last()->lastBoundingRect();
+    }
+
+    return ((pRun >= 0) && (pRun < mRuns.count()))?
+               mRuns[pRun]->lastBoundingRect():
+               InvalidRect;
+}
+
+//==============================================================================
+
 GraphPanelPlotOverlayWidget::GraphPanelPlotOverlayWidget(GraphPanelPlotWidget *pParent) :
     QWidget(pParent),
     mOwner(pParent)
@@ -928,6 +1475,17 @@ void GraphPanelPlotOverlayWidget::paintEvent(QPaintEvent *pEvent)
 
     pEvent->accept();
 
+    // Composite the graph segments that our owner has rendered in the
+    // background, if any, on top of its canvas
+
+    QImage renderedImage = mOwner->renderedImage();
+
+    if (!renderedImage.isNull()) {
+        QPainter painter(this);
+
+        painter.drawImage(mOwner->canvas()->geometry().topLeft(), renderedImage);
+    }
+
     // Check whether an action is to be carried out
 
     if (mOwner->action() == GraphPanelPlotWidget::Action::None) {
@@ -1533,6 +2091,109 @@ static const double MinAxisRange    = DblMinAxis;
 
 //==============================================================================
 
+// Rendering of new graph segments in the background
+// Note #1: when rendering in the background, new graph segments are not
+//          direct painted, but rasterised into an image by a worker thread, at
+//          most MaximumRenderingFrameRate times per second. The resulting
+//          image is then composited on top of our canvas by our overlay
+//          widget, i.e. on the GUI thread...
+// Note #2: our graph segments contain a copy of their samples since the data
+//          of a graph may get released while we are rasterising it (e.g. when
+//          a simulation gets reset)...
+// Note #3: a graph segment is at most MaximumSegmentCanvasWidths canvas widths
+//          worth of samples long and we replot ourselves otherwise. Indeed,
+//          copying a segment is then cheap and a bigger segment would have
+//          several samples per pixel, in which case replotting ourselves (which
+//          can use our levels of detail) is cheaper than rasterising it...
+
+static const int MaximumRenderingFrameRate = 30;
+static const int MaximumSegmentCanvasWidths = 4;
+
+//==============================================================================
+
+class GraphPanelPlotGraphSegment
+{
+public:
+    QVector<double> dataX;
+    QVector<double> dataY;
+
+    QPen pen;
+
+    QwtSymbol::Style symbolStyle = QwtSymbol::NoSymbol;
+    QBrush symbolBrush;
+    QPen symbolPen;
+    QSize symbolSize;
+};
+
+//==============================================================================
+
+static QImage rasteriseSegments(const QSize &pSize, qreal pDevicePixelRatio,
+                                const QRectF &pCanvasRect,
+                                const QwtScaleMap &pMapX,
+                                const QwtScaleMap &pMapY,
+                                const QList<GraphPanelPlotGraphSegment> &pSegments)
+{
+    // Rasterise the given graph segments into a transparent image
+
+    QImage res = QImage(pSize*pDevicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+
+    res.setDevicePixelRatio(pDevicePixelRatio);
+    res.fill(Qt::transparent);
+
+    QPainter painter(&res);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    for (const auto &segment : pSegments) {
+        // Determine the ranges of valid samples in our segment
+
+        const double *dataX = segment.dataX.constData();
+        const double *dataY = segment.dataY.constData();
+        QVector<QPair<quint64, quint64>> validData;
+
+        for (quint64 i = 0, iMax = quint64(segment.dataX.count()); i < iMax; ++i) {
+            if (   !qIsInf(dataX[i]) && !qIsNaN(dataX[i])
+                && !qIsInf(dataY[i]) && !qIsNaN(dataY[i])) {
+                if (!validData.isEmpty() && (validData.last().second == i-1)) {
+                    validData.last().second = i;
+                } else {
+                    validData << QPair<quint64, quint64>(i, i);
+                }
+            }
+        }
+
+        // Draw our lines and symbols, using the same clipping rectangles as
+        // GraphPanelPlotGraphRun::drawSeries()
+
+        double penWidth = qMax(1.0, segment.pen.widthF());
+        QRectF linesClipRect = pCanvasRect.adjusted(-penWidth, -penWidth, penWidth, penWidth);
+
+        painter.setPen(segment.pen);
+
+        for (const auto &range : validData) {
+            drawLineSamples(&painter, linesClipRect, pMapX, pMapY,
+                            dataX, dataY, range.first, range.second);
+        }
+
+        if (segment.symbolStyle != QwtSymbol::NoSymbol) {
+            QwtSymbol symbol(segment.symbolStyle, segment.symbolBrush,
+                             segment.symbolPen, segment.symbolSize);
+            double symbolSize = 0.5*qMax(segment.symbolSize.width(), segment.symbolSize.height());
+            QRectF symbolsClipRect = pCanvasRect.adjusted(-symbolSize, -symbolSize, symbolSize, symbolSize);
+
+            for (const auto &range : validData) {
+                drawSymbolSamples(&painter, symbol, symbolsClipRect,
+                                  pMapX, pMapY, dataX, dataY,
+                                  range.first, range.second);
+            }
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 GraphPanelPlotWidget::GraphPanelPlotWidget(const GraphPanelPlotWidgets &pNeighbors,
                                            QAction *pSynchronizeXAxisAction,
                                            QAction *pSynchronizeYAxisAction,
@@ -1563,6 +2224,20 @@ GraphPanelPlotWidget::GraphPanelPlotWidget(const GraphPanelPlotWidgets &pNeighbo
 
     mDirectPainter->setAttribute(QwtPlotDirectPainter::CopyBackingStore, true);
 
+    // Get ourselves a timer and a future watcher to render new graph segments
+    // in the background, if requested
+
+    mRenderingTimer = new QTimer(this);
+    mRenderingWatcher = new QFutureWatcher<QImage>(this);
+
+    mRenderingTimer->setInterval(1000/MaximumRenderingFrameRate);
+    mRenderingTimer->setSingleShot(true);
+
+    connect(mRenderingTimer, &QTimer::timeout,
+            this, &GraphPanelPlotWidget::renderPendingSegments);
+    connect(mRenderingWatcher, &QFutureWatcher<QImage>::finished,
+            this, &GraphPanelPlotWidget::pendingSegmentsRendered);
+
     // Speedup painting on X11 systems
     // Note: this can only be done on X11 systems...
 
@@ -1730,6 +2405,10 @@ GraphPanelPlotWidget::GraphPanelPlotWidget(const GraphPanelPlotWidgets &pNeighbo
 
 GraphPanelPlotWidget::~GraphPanelPlotWidget()
 {
+    // Make sure that we are not rendering anything in the background
+
+    mRenderingWatcher->waitForFinished();
+
     // Delete some internal objects
 
     delete mDirectPainter;
@@ -3640,10 +4319,13 @@ void GraphPanelPlotWidget::resizeEvent(QResizeEvent *pEvent)
 
     QwtPlot::resizeEvent(pEvent);
 
-    // Update the size of our overlay widget
+    // Update the size of our overlay widget and reset our rendered segments,
+    // since our canvas is to be repainted
 
     mOverlayWidget->resize(pEvent->size());
 
+    resetRenderedSegments();
+
     // Update our GUI (and that of our neighbours)
 
     updateGui();
@@ -3747,6 +4429,8 @@ bool GraphPanelPlotWidget::removeGraph(GraphPanelPlotGraph *pGraph)
 
     mLegend->removeGraph(pGraph);
 
+    mPendingSegments.remove(pGraph);
+
     delete pGraph;
 
     // To remove a graph may affect our GUI (and that of our neighbours), so
@@ -3775,7 +4459,18 @@ bool GraphPanelPlotWidget::drawGraphFrom(GraphPanelPlotGraph *pGraph,
     // (due to the axes having been changed), in which case we replot ourselves
 
     if (mCanDirectPaint) {
-        mDirectPainter->drawSeries(pGraph->lastRun(), int(pFrom), -1);
+        if (mBackgroundRendering) {
+            // We are to render our graph in the background, so keep track of
+            // the segment to be rendered and make sure that it will be
+
+            mPendingSegments.insert(pGraph, qMin(pFrom, mPendingSegments.value(pGraph, pFrom)));
+
+            if (!mRenderingTimer->isActive() && !mRenderingWatcher->isRunning()) {
+                mRenderingTimer->start();
+            }
+        } else {
+            pGraph->lastRun()->directPaint(mDirectPainter, pFrom);
+        }
 
         return false;
     }
@@ -3791,6 +4486,197 @@ bool GraphPanelPlotWidget::drawGraphFrom(GraphPanelPlotGraph *pGraph,
 
 //==============================================================================
 
+QImage GraphPanelPlotWidget::renderedImage() const
+{
+    // Return the image of the segments that we have rendered in the background
+    // since we were last replotted, if any
+
+    return mRenderedImage;
+}
+
+//==============================================================================
+
+bool GraphPanelPlotWidget::isBackgroundRendering() const
+{
+    // Return whether we render new graph segments in the background
+
+    return mBackgroundRendering;
+}
+
+//==============================================================================
+
+void GraphPanelPlotWidget::setBackgroundRendering(bool pBackgroundRendering)
+{
+    // Set whether we render new graph segments in the background
+    // Note: we replot ourselves when we stop rendering in the background, so
+    //       that our canvas includes any segment that we haven't rendered
+    //       yet...
+
+    if (pBackgroundRendering == mBackgroundRendering) {
+        return;
+    }
+
+    mBackgroundRendering = pBackgroundRendering;
+
+    if (!pBackgroundRendering) {
+        replot();
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotWidget::replot()
+{
+    // Reset our rendered segments since our canvas is going to include them
+
+    resetRenderedSegments();
+
+    // Default handling of our replotting
+
+    QwtPlot::replot();
+}
+
+//==============================================================================
+
+void GraphPanelPlotWidget::resetRenderedSegments()
+{
+    // Forget about our pending and rendered segments, as well as about the
+    // segments that we may currently be rendering
+
+    ++mRenderingGeneration;
+
+    mRenderingTimer->stop();
+
+    mPendingSegments.clear();
+
+    if (!mRenderedImage.isNull()) {
+        mRenderedImage = QImage();
+
+        mOverlayWidget->update();
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotWidget::renderPendingSegments()
+{
+    // Make sure that we have some pending segments and that we are not already
+    // rendering some
+
+    if (mPendingSegments.isEmpty() || mRenderingWatcher->isRunning()) {
+        return;
+    }
+
+    // Retrieve our pending segments, replotting ourselves if one of them is
+    // too big
+
+    QSize canvasSize = canvas()->size();
+    qreal devicePixelRatio = canvas()->devicePixelRatioF();
+    quint64 maximumSegmentSize = quint64(qMax(1.0, MaximumSegmentCanvasWidths*canvasSize.width()*devicePixelRatio));
+    QList<GraphPanelPlotGraphSegment> segments;
+
+    for (auto pendingSegment = mPendingSegments.constBegin(),
+              pendingSegmentEnd = mPendingSegments.constEnd();
+         pendingSegment != pendingSegmentEnd; ++pendingSegment) {
+        GraphPanelPlotGraph *graph = pendingSegment.key();
+        GraphPanelPlotGraphRun *run = graph->lastRun();
+
+        if ((run == nullptr) || !graph->isVisible()) {
+            continue;
+        }
+
+        quint64 from = pendingSegment.value();
+        quint64 size = graph->dataSize();
+
+        if (from >= size) {
+            continue;
+        }
+
+        if (size-from > maximumSegmentSize) {
+            replot();
+
+            return;
+        }
+
+        GraphPanelPlotGraphSegment segment;
+        const QwtSymbol *symbol = run->symbol();
+
+        segment.dataX = QVector<double>(int(size-from));
+        segment.dataY = QVector<double>(int(size-from));
+
+        memcpy(segment.dataX.data(), run->rawDataX()+from, (size-from)*sizeof(double));
+        memcpy(segment.dataY.data(), run->rawDataY()+from, (size-from)*sizeof(double));
+
+        segment.pen = run->pen();
+
+        if (run->style() == QwtPlotCurve::NoCurve) {
+            segment.pen.setStyle(Qt::NoPen);
+        }
+
+        if (symbol != nullptr) {
+            segment.symbolStyle = symbol->style();
+            segment.symbolBrush = symbol->brush();
+            segment.symbolPen = symbol->pen();
+            segment.symbolSize = symbol->size();
+        }
+
+        segments << segment;
+    }
+
+    mPendingSegments.clear();
+
+    if (segments.isEmpty()) {
+        return;
+    }
+
+    // Rasterise our segments in the background
+
+    QRectF canvasRect = canvas()->contentsRect();
+    QwtScaleMap mapX = canvasMap(QwtPlot::xBottom);
+    QwtScaleMap mapY = canvasMap(QwtPlot::yLeft);
+
+    mRenderingJobGeneration = mRenderingGeneration;
+    mRenderingJobCanvasSize = canvasSize;
+
+    mRenderingWatcher->setFuture(QtConcurrent::run([=]() {
+        return rasteriseSegments(canvasSize, devicePixelRatio, canvasRect,
+                                 mapX, mapY, segments);
+    }));
+}
+
+//==============================================================================
+
+void GraphPanelPlotWidget::pendingSegmentsRendered()
+{
+    // Composite the segments that we have just rendered with those that we
+    // have already rendered, unless we have been reset or resized in between,
+    // and have our overlay widget show them
+
+    if (   (mRenderingJobGeneration == mRenderingGeneration)
+        && (mRenderingJobCanvasSize == canvas()->size())) {
+        QImage image = mRenderingWatcher->result();
+
+        if (mRenderedImage.isNull()) {
+            mRenderedImage = image;
+        } else {
+            QPainter painter(&mRenderedImage);
+
+            painter.drawImage(QPointF(), image);
+        }
+
+        mOverlayWidget->update();
+    }
+
+    // Render our pending segments, if any, making sure that we don't render
+    // more than MaximumRenderingFrameRate times per second
+
+    if (!mPendingSegments.isEmpty()) {
+        mRenderingTimer->start();
+    }
+}
+
+//==============================================================================
+
 GraphPanelPlotWidgets GraphPanelPlotWidget::neighbors() const
 {
     // Return our neighbours
@@ -30,6 +30,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QFutureWatcher>
+#include <QImage>
+
+//==============================================================================
+
+#include <vector>
+
+//==============================================================================
+
 #include "qwtbegin.h"
     #include "qwt_legend.h"
     #include "qwt_plot.h"
@@ -43,6 +52,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 class QMenu;
+class QTimer;
 
 //==============================================================================
 
@@ -136,6 +146,36 @@ class GraphPanelPlotGraph;
 
 //==============================================================================
 
+using GraphPanelPlotGraphRunLevel = std::vector<QPair<quint64, quint64>>;
+
+//==============================================================================
+
+class GraphPanelPlotGraphRun;
+
+//==============================================================================
+
+class GraphPanelPlotGraphRunData : public QwtSeriesData<QPointF>
+{
+public:
+    explicit GraphPanelPlotGraphRunData(const GraphPanelPlotGraphRun *pRun,
+                                        const double *pDataX,
+                                        const double *pDataY, quint64 pSize);
+
+    size_t size() const override;
+    QPointF sample(size_t pIndex) const override;
+    QRectF boundingRect() const override;
+
+private:
+    const GraphPanelPlotGraphRun *mRun;
+
+    const double *mDataX;
+    const double *mDataY;
+
+    quint64 mSize;
+};
+
+//==============================================================================
+
 class GraphPanelPlotGraphRun : public QwtPlotCurve
 {
 public:
@@ -143,21 +183,65 @@ public:
 
     GraphPanelPlotGraph * owner() const;
 
-    void setRawSamples(const double *pDataX, const double *pDataY, int pSize);
+    void setRawSamples(const double *pDataX, const double *pDataY,
+                       quint64 pSize);
+
+    const double * rawDataX() const;
+    const double * rawDataY() const;
+
+    void directPaint(QwtPlotDirectPainter *pDirectPainter, quint64 pFrom);
+
+    QRectF boundingRect() const override;
+    QRectF boundingLogRect() const;
+    QRectF lastBoundingRect() const;
 
 protected:
-    void drawLines(QPainter *pPainter, const QwtScaleMap &pMapX,
-                   const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
-                   int pFrom, int pTo) const override;
-    void drawSymbols(QPainter *pPainter, const QwtSymbol &pSymbol,
-                     const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
-                     const QRectF &pCanvasRect, int pFrom, int pTo) const override;
+    void drawSeries(QPainter *pPainter, const QwtScaleMap &pMapX,
+                    const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
+                    int pFrom, int pTo) const override;
 
 private:
     GraphPanelPlotGraph *mOwner;
 
-    int mSize = 0;
-    QList<QPair<int, int>> mValidData;
+    const double *mDataX = nullptr;
+    const double *mDataY = nullptr;
+
+    quint64 mSize = 0;
+    QVector<QPair<quint64, quint64>> mValidData;
+
+    QRectF mBoundingRect;
+    QRectF mBoundingLogRect;
+    QRectF mLastBoundingRect;
+
+    bool mIncreasingX = true;
+    double mLastX = 0.0;
+    bool mHasLastX = false;
+
+    QVector<GraphPanelPlotGraphRunLevel> mLevels;
+
+    bool mDirectPainting = false;
+    quint64 mDirectPaintFrom = 0;
+
+    void updateBoundingRects(quint64 pFrom, quint64 pTo);
+    void updateLevels();
+
+    quint64 bucketSize(int pLevel) const;
+    void addLevelPoints(QPolygonF &pPoints, quint64 &pLastIndex,
+                        const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                        int pLevel, quint64 pFrom, quint64 pTo) const;
+    void addPoint(QPolygonF &pPoints, quint64 &pLastIndex,
+                  const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                  quint64 pIndex) const;
+    void visibleRange(const QwtScaleMap &pMapX, const QRectF &pCanvasRect,
+                      quint64 &pFrom, quint64 &pTo) const;
+    void drawValidLines(QPainter *pPainter, const QRectF &pClipRect,
+                        const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                        const QRectF &pCanvasRect, quint64 pFrom,
+                        quint64 pTo) const;
+    void drawValidSymbols(QPainter *pPainter, const QwtSymbol &pSymbol,
+                          const QRectF &pClipRect, const QwtScaleMap &pMapX,
+                          const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
+                          quint64 pFrom, quint64 pTo) const;
 };
 
 //==============================================================================
@@ -226,6 +310,7 @@ public:
 
     QRectF boundingRect();
     QRectF boundingLogRect();
+    QRectF lastBoundingRect(int pRun = -1) const;
 
 private:
     bool mSelected = true;
@@ -238,10 +323,7 @@ private:
     QColor mColor;
 
     QRectF mBoundingRect;
-    QMap<GraphPanelPlotGraphRun *, QRectF> mBoundingRects;
-
     QRectF mBoundingLogRect;
-    QMap<GraphPanelPlotGraphRun *, QRectF> mBoundingLogRects;
 
     GraphPanelPlotWidget *mPlot = nullptr;
 
@@ -526,8 +608,13 @@ public:
                  bool pForceAxesSetting, bool pSynchronizeXAxis,
                  bool pSynchronizeYAxis);
 
+    bool isBackgroundRendering() const;
+    void setBackgroundRendering(bool pBackgroundRendering);
+
     bool drawGraphFrom(GraphPanelPlotGraph *pGraph, quint64 pFrom);
 
+    QImage renderedImage() const;
+
     GraphPanelPlotWidgets neighbors() const;
 
     void addNeighbor(GraphPanelPlotWidget *pPlot);
@@ -546,6 +633,9 @@ public:
 
     void updateGui(bool pSingleShot = false, bool pForceAlignment = false);
 
+public slots:
+    void replot() override;
+
 protected:
     void changeEvent(QEvent *pEvent) override;
     bool event(QEvent *pEvent) override;
@@ -620,6 +710,15 @@ private:
     bool mCanDirectPaint = true;
     bool mCanReplot = true;
 
+    bool mBackgroundRendering = false;
+    QMap<GraphPanelPlotGraph *, quint64> mPendingSegments;
+    QTimer *mRenderingTimer;
+    QFutureWatcher<QImage> *mRenderingWatcher;
+    int mRenderingGeneration = 0;
+    int mRenderingJobGeneration = 0;
+    QSize mRenderingJobCanvasSize;
+    QImage mRenderedImage;
+
     bool mCanZoomInX = true;
     bool mCanZoomOutX = true;
     bool mCanZoomInY = true;
@@ -672,6 +771,8 @@ private:
 
     void resetAction();
 
+    void resetRenderedSegments();
+
     QRectF realDataRect();
 
     void optimizeAxis(int pAxisId, double &pMin, double &pMax,
@@ -719,6 +820,9 @@ private slots:
     void zoomIn();
     void zoomOut();
     void resetZoom();
+
+    void renderPendingSegments();
+    void pendingSegmentsRendered();
 };
 
 //==============================================================================
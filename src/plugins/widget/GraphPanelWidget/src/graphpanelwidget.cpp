@@ -38,10 +38,12 @@ namespace GraphPanelWidget {
 
 GraphPanelWidgetProperties::GraphPanelWidgetProperties(const QColor &pBackgroundColor,
                                                        const QColor &pForegroundColor,
-                                                       bool pLegend) :
+                                                       bool pLegend,
+                                                       bool pBackgroundRendering) :
     mBackgroundColor(pBackgroundColor),
     mForegroundColor(pForegroundColor),
-    mLegend(pLegend)
+    mLegend(pLegend),
+    mBackgroundRendering(pBackgroundRendering)
 {
 }
 
@@ -74,6 +76,15 @@ bool GraphPanelWidgetProperties::legend() const
 
 //==============================================================================
 
+bool GraphPanelWidgetProperties::backgroundRendering() const
+{
+    // Return whether we render in the background
+
+    return mBackgroundRendering;
+}
+
+//==============================================================================
+
 GraphPanelWidget::GraphPanelWidget(const GraphPanelWidgets &pNeighbors,
                                    QAction *pSynchronizeXAxisAction,
                                    QAction *pSynchronizeYAxisAction,
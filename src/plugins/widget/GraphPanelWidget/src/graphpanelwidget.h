@@ -40,9 +40,10 @@ namespace GraphPanelWidget {
 
 //==============================================================================
 
-static const QColor DefaultGraphPanelBackgroundColor = Qt::white;
-static const QColor DefaultGraphPanelForegroundColor = Qt::black;
-static const bool DefaultGraphPanelLegend            = true;
+static const QColor DefaultGraphPanelBackgroundColor   = Qt::white;
+static const QColor DefaultGraphPanelForegroundColor   = Qt::black;
+static const bool DefaultGraphPanelLegend              = true;
+static const bool DefaultGraphPanelBackgroundRendering = false;
 
 //==============================================================================
 
@@ -51,16 +52,19 @@ class GRAPHPANELWIDGET_EXPORT GraphPanelWidgetProperties
 public:
     explicit GraphPanelWidgetProperties(const QColor &pBackgroundColor = DefaultGraphPanelBackgroundColor,
                                         const QColor &pForegroundColor = DefaultGraphPanelForegroundColor,
-                                        bool pLegend = DefaultGraphPanelLegend);
+                                        bool pLegend = DefaultGraphPanelLegend,
+                                        bool pBackgroundRendering = DefaultGraphPanelBackgroundRendering);
 
     QColor backgroundColor() const;
     QColor foregroundColor() const;
     bool legend() const;
+    bool backgroundRendering() const;
 
 private:
     QColor mBackgroundColor;
     QColor mForegroundColor;
     bool mLegend;
+    bool mBackgroundRendering;
 };
 
 //==============================================================================